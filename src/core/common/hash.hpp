@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "cvTypeDef.hpp"
+
+namespace ImageStitch {
+
+const uint64_t kFnvOffsetBasis = 14695981039346656037ULL;
+const uint64_t kFnvPrime = 1099511628211ULL;
+
+/**
+ * @brief FNV-1a哈希，seed传入上一次的结果即可分段计算。
+ */
+inline uint64_t HashBytes(const void *data, size_t size,
+                          uint64_t seed = kFnvOffsetBasis) {
+  auto bytes = static_cast<const unsigned char *>(data);
+  for (size_t i = 0; i < size; ++i) {
+    seed ^= bytes[i];
+    seed *= kFnvPrime;
+  }
+  return seed;
+}
+
+/**
+ * @brief 按(行, 列, 类型, 逐行数据)计算矩阵的哈希，支持非连续的ROI。
+ */
+inline uint64_t HashImage(const Mat &image, uint64_t seed = kFnvOffsetBasis) {
+  const int header[3] = {image.rows, image.cols, image.type()};
+  seed = HashBytes(header, sizeof(header), seed);
+  for (int i = 0; i < image.rows; ++i) {
+    seed = HashBytes(image.ptr(i), image.cols * image.elemSize(), seed);
+  }
+  return seed;
+}
+}  // namespace ImageStitch
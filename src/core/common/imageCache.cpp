@@ -0,0 +1,122 @@
+#include "imageCache.hpp"
+
+#include "imageLoader.hpp"
+
+namespace ImageStitch {
+
+auto ImageCache::Instance() -> ImageCache & {
+  static ImageCache cache;
+  return cache;
+}
+
+ImageCache::ImageCache(size_t max_bytes) : _max_bytes(max_bytes), _bytes(0) {}
+
+auto ImageCache::Find(const std::string &file_name, Image &image) -> bool {
+  const int64_t mtime = ModifiedTime(file_name);
+  std::lock_guard<std::mutex> locker(_mutex);
+  auto item = _index.find(file_name);
+  if (item == _index.end()) {
+    return false;
+  }
+  if (item->second->second.mtime != mtime) {
+    EraseItem(item->second);
+    return false;
+  }
+  // 最近使用的放到队首
+  _items.splice(_items.begin(), _items, item->second);
+  image = item->second->second.image;
+  return true;
+}
+
+auto ImageCache::Insert(const std::string &file_name, const Image &image)
+    -> void {
+  if (image.empty()) {
+    return;
+  }
+  Entry entry{ModifiedTime(file_name), image};
+  size_t bytes = EntryBytes(entry);
+  std::lock_guard<std::mutex> locker(_mutex);
+  if (bytes > _max_bytes) {
+    return;
+  }
+  auto item = _index.find(file_name);
+  if (item != _index.end()) {
+    EraseItem(item->second);
+  }
+  _items.emplace_front(file_name, entry);
+  _index[file_name] = _items.begin();
+  _bytes += bytes;
+  Evict();
+}
+
+auto ImageCache::Load(const std::string &file_name) -> Image {
+  Image image;
+  if (Find(file_name, image)) {
+    return image;
+  }
+  image = DecodeImageFile(file_name);
+  Insert(file_name, image);
+  return image;
+}
+
+auto ImageCache::Erase(const std::string &file_name) -> void {
+  std::lock_guard<std::mutex> locker(_mutex);
+  auto item = _index.find(file_name);
+  if (item != _index.end()) {
+    EraseItem(item->second);
+  }
+}
+
+auto ImageCache::Clear() -> void {
+  std::lock_guard<std::mutex> locker(_mutex);
+  _items.clear();
+  _index.clear();
+  _bytes = 0;
+}
+
+auto ImageCache::SetMemoryLimit(size_t max_bytes) -> void {
+  std::lock_guard<std::mutex> locker(_mutex);
+  _max_bytes = max_bytes;
+  Evict();
+}
+
+auto ImageCache::MemoryLimit() const -> size_t {
+  std::lock_guard<std::mutex> locker(_mutex);
+  return _max_bytes;
+}
+
+auto ImageCache::MemoryUsage() const -> size_t {
+  std::lock_guard<std::mutex> locker(_mutex);
+  return _bytes;
+}
+
+auto ImageCache::Size() const -> size_t {
+  std::lock_guard<std::mutex> locker(_mutex);
+  return _items.size();
+}
+
+auto ImageCache::ModifiedTime(const std::string &file_name) -> int64_t {
+  std::error_code error;
+  auto time = std::filesystem::last_write_time(file_name, error);
+  if (error) {
+    return 0;
+  }
+  return time.time_since_epoch().count();
+}
+
+auto ImageCache::EntryBytes(const Entry &entry) -> size_t {
+  return entry.image.total() * entry.image.elemSize();
+}
+
+auto ImageCache::EraseItem(std::list<Item>::iterator item) -> void {
+  _bytes -= EntryBytes(item->second);
+  _index.erase(item->first);
+  _items.erase(item);
+}
+
+auto ImageCache::Evict() -> void {
+  while (_bytes > _max_bytes && !_items.empty()) {
+    EraseItem(std::prev(_items.end()));
+  }
+}
+}  // namespace ImageStitch
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "cvTypeDef.hpp"
+
+namespace ImageStitch {
+
+/**
+ * @brief 进程内共享的解码图像缓存。
+ * 以(文件路径, 修改时间)为键缓存全分辨率解码结果(BGR的cv::Mat)。界面打开原图和
+ * 拼接器全分辨率加载图像时都经过缓存，重新拼接同一组图像时不再解码；按预览图或
+ * 缩小解码加载的图像不放入缓存。Mat按引用计数共享，淘汰只是释放缓存持有的引用。
+ * 缓存按字节数做LRU淘汰，上限属于各个缓存实例，可以并发访问。
+ */
+class ImageCache {
+ public:
+  static auto Instance() -> ImageCache &;
+
+  explicit ImageCache(size_t max_bytes = kDefaultMemoryLimit);
+  /**
+   * @brief 查找缓存，文件在缓存后被修改过视为未命中
+   */
+  auto Find(const std::string &file_name, Image &image) -> bool;
+  auto Insert(const std::string &file_name, const Image &image) -> void;
+  /**
+   * @brief 命中时直接返回缓存，否则全分辨率解码并放入缓存
+   */
+  auto Load(const std::string &file_name) -> Image;
+  auto Erase(const std::string &file_name) -> void;
+  auto Clear() -> void;
+  auto SetMemoryLimit(size_t max_bytes) -> void;
+  auto MemoryLimit() const -> size_t;
+  auto MemoryUsage() const -> size_t;
+  auto Size() const -> size_t;
+
+ public:
+  static constexpr size_t kDefaultMemoryLimit = size_t(512) * 1024 * 1024;
+
+ private:
+  struct Entry {
+    int64_t mtime;
+    Image image;
+  };
+  using Item = std::pair<std::string, Entry>;
+  static auto ModifiedTime(const std::string &file_name) -> int64_t;
+  static auto EntryBytes(const Entry &entry) -> size_t;
+  auto EraseItem(std::list<Item>::iterator item) -> void;
+  auto Evict() -> void;
+
+ private:
+  mutable std::mutex _mutex;
+  std::list<Item> _items;
+  std::unordered_map<std::string, std::list<Item>::iterator> _index;
+  size_t _max_bytes;
+  size_t _bytes;
+};
+}  // namespace ImageStitch
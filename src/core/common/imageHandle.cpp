@@ -0,0 +1,77 @@
+#include "imageHandle.hpp"
+
+#include "imageLoader.hpp"
+
+namespace ImageStitch {
+
+ImageHandle::ImageHandle(ImagePtr image, double scale)
+    : _full(image), _preview(image), _full_size(image->size()), _scale(1.0) {
+  if (scale < 1.0) {
+    _scale = scale;
+    _preview = new Image();
+    cv::resize(*image, *_preview,
+               cv::Size(cvRound(_full_size.width * scale),
+                        cvRound(_full_size.height * scale)),
+               0, 0, cv::INTER_AREA);
+  }
+}
+
+auto ImageHandle::Open(const std::string &file_name, double scale)
+    -> std::shared_ptr<ImageHandle> {
+  if (scale >= 1.0) {
+    auto image = DecodeImageFile(file_name);
+    if (image.empty()) {
+      return nullptr;
+    }
+    return std::make_shared<ImageHandle>(ImagePtr(new Image(image)));
+  }
+  cv::Size full_size;
+  Image image;
+  if (!ReadImageFileSize(file_name, full_size)) {
+    // 无法从文件头得到尺寸时只能完整解码一次
+    image = DecodeImageFile(file_name);
+    full_size = image.size();
+  } else {
+    image = DecodeImageFile(file_name, full_size.area() * scale * scale / 1e6);
+  }
+  if (image.empty()) {
+    return nullptr;
+  }
+  // EXIF方向会在解码时应用，文件头中的尺寸可能是旋转前的
+  if ((image.cols > image.rows) != (full_size.width > full_size.height) &&
+      full_size.width != full_size.height) {
+    std::swap(full_size.width, full_size.height);
+  }
+  std::shared_ptr<ImageHandle> handle(new ImageHandle());
+  handle->_file_name = file_name;
+  handle->_full_size = full_size;
+  handle->_scale = scale;
+  cv::Size preview_size(cvRound(full_size.width * scale),
+                        cvRound(full_size.height * scale));
+  if (image.size() != preview_size) {
+    Image preview;
+    cv::resize(image, preview, preview_size, 0, 0, cv::INTER_AREA);
+    image = preview;
+  }
+  handle->_preview = new Image(image);
+  return handle;
+}
+
+auto ImageHandle::Full() const -> Image {
+  if (!Lazy()) {
+    return *_full;
+  }
+  auto image = DecodeImageFile(_file_name);
+  if (image.empty()) {
+    LOG(ERROR) << "Failed to decode image file : " << _file_name;
+    return image;
+  }
+  if (image.size() != _full_size) {
+    LOG(WARNING) << "Image file changed since it was opened : " << _file_name;
+    Image resized;
+    cv::resize(image, resized, _full_size, 0, 0, cv::INTER_LINEAR_EXACT);
+    return resized;
+  }
+  return image;
+}
+}  // namespace ImageStitch
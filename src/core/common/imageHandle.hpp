@@ -0,0 +1,56 @@
+#pragma once
+
+#include <memory>
+#include <string>
+
+#include "cvTypeDef.hpp"
+
+namespace ImageStitch {
+
+/**
+ * @brief 两级分辨率的图像句柄。
+ * 从文件打开时立即解码一张按固定比例缩小的预览图供配准、拼接缝和曝光补偿使用，
+ * 全分辨率图像只在融合时通过Full()按需解码，由调用者用完即释放，句柄本身不缓存。
+ * 由内存图像构造时持有原图，预览图由原图缩小得到(scale为1时即原图)。
+ */
+class ImageHandle {
+ public:
+  explicit ImageHandle(ImagePtr image, double scale = 1.0);
+  /**
+   * @brief 打开图像文件，只解码缩放系数为scale的预览图
+   *
+   * @param file_name
+   * @param scale 预览图相对原图的缩放系数，大于等于1时直接解码原图
+   * @return std::shared_ptr<ImageHandle> 失败时为空
+   */
+  static auto Open(const std::string &file_name, double scale)
+      -> std::shared_ptr<ImageHandle>;
+
+  inline auto Preview() const -> ImagePtr { return _preview; }
+  inline auto PreviewScale() const -> double { return _scale; }
+  inline auto FullSize() const -> cv::Size { return _full_size; }
+  inline auto FileName() const -> const std::string & { return _file_name; }
+  /**
+   * @brief 全分辨率图像是否需要重新解码
+   */
+  inline auto Lazy() const -> bool { return _full.empty(); }
+  /**
+   * @brief 获取全分辨率图像，延迟加载的句柄每次调用都会重新解码，可以并发调用
+   *
+   * @return Image 文件在打开后被删除或无法解码时为空，由调用者处理
+   */
+  auto Full() const -> Image;
+
+ private:
+  ImageHandle() = default;
+
+ private:
+  std::string _file_name;
+  ImagePtr _full;
+  ImagePtr _preview;
+  cv::Size _full_size;
+  double _scale = 1.0;
+};
+
+using ImageHandlePtr = std::shared_ptr<ImageHandle>;
+}  // namespace ImageStitch
@@ -0,0 +1,216 @@
+#include "imageLoader.hpp"
+
+#include <cstring>
+
+#ifdef WIN
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace ImageStitch {
+
+namespace {
+inline int ReadBigEndian16(const uchar *p) { return (p[0] << 8) | p[1]; }
+
+inline uint32_t ReadBigEndian32(const uchar *p) {
+  return (uint32_t(p[0]) << 24) | (uint32_t(p[1]) << 16) |
+         (uint32_t(p[2]) << 8) | uint32_t(p[3]);
+}
+
+auto ReadJpegSize(const uchar *data, size_t size, cv::Size &image_size)
+    -> bool {
+  size_t pos = 2;
+  while (pos + 4 <= size) {
+    if (data[pos] != 0xFF) {
+      return false;
+    }
+    const uchar marker = data[pos + 1];
+    // 填充字节和没有长度字段的标记
+    if (marker == 0xFF) {
+      ++pos;
+      continue;
+    }
+    if (marker == 0x01 || (marker >= 0xD0 && marker <= 0xD7)) {
+      pos += 2;
+      continue;
+    }
+    const int length = ReadBigEndian16(data + pos + 2);
+    if (length < 2) {
+      return false;
+    }
+    // SOF0~SOF15，排除DHT(C4)、JPG(C8)、DAC(CC)
+    if (marker >= 0xC0 && marker <= 0xCF && marker != 0xC4 &&
+        marker != 0xC8 && marker != 0xCC) {
+      if (pos + 9 > size) {
+        return false;
+      }
+      image_size.height = ReadBigEndian16(data + pos + 5);
+      image_size.width = ReadBigEndian16(data + pos + 7);
+      return image_size.area() > 0;
+    }
+    pos += 2 + length;
+  }
+  return false;
+}
+
+auto ReadPngSize(const uchar *data, size_t size, cv::Size &image_size)
+    -> bool {
+  // 8字节签名 + 4字节长度 + "IHDR" + 宽 + 高
+  if (size < 24 || std::memcmp(data + 12, "IHDR", 4) != 0) {
+    return false;
+  }
+  image_size.width = ReadBigEndian32(data + 16);
+  image_size.height = ReadBigEndian32(data + 20);
+  return image_size.area() > 0;
+}
+}  // namespace
+
+MappedFile::MappedFile(const std::string &file_name) { Open(file_name); }
+
+MappedFile::~MappedFile() { Close(); }
+
+auto MappedFile::Open(const std::string &file_name) -> bool {
+  Close();
+#ifdef WIN
+  HANDLE file = CreateFileA(file_name.c_str(), GENERIC_READ, FILE_SHARE_READ,
+                            nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL,
+                            nullptr);
+  if (file == INVALID_HANDLE_VALUE) {
+    return false;
+  }
+  LARGE_INTEGER file_size;
+  if (!GetFileSizeEx(file, &file_size) || file_size.QuadPart == 0) {
+    CloseHandle(file);
+    return false;
+  }
+  HANDLE mapping =
+      CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  if (mapping == nullptr) {
+    CloseHandle(file);
+    return false;
+  }
+  void *data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+  if (data == nullptr) {
+    CloseHandle(mapping);
+    CloseHandle(file);
+    return false;
+  }
+  _file = file;
+  _mapping = mapping;
+  _data = static_cast<const uchar *>(data);
+  _size = file_size.QuadPart;
+#else
+  int fd = open(file_name.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return false;
+  }
+  struct stat file_stat;
+  if (fstat(fd, &file_stat) != 0 || file_stat.st_size == 0) {
+    close(fd);
+    return false;
+  }
+  void *data = mmap(nullptr, file_stat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  // 映射建立后即可关闭文件描述符
+  close(fd);
+  if (data == MAP_FAILED) {
+    return false;
+  }
+  // 解码器顺序读取整个文件
+  madvise(data, file_stat.st_size, MADV_SEQUENTIAL);
+  _data = static_cast<const uchar *>(data);
+  _size = file_stat.st_size;
+#endif
+  return true;
+}
+
+auto MappedFile::Close() -> void {
+  if (_data == nullptr) {
+    return;
+  }
+#ifdef WIN
+  UnmapViewOfFile(_data);
+  CloseHandle(_mapping);
+  CloseHandle(_file);
+  _mapping = nullptr;
+  _file = nullptr;
+#else
+  munmap(const_cast<uchar *>(_data), _size);
+#endif
+  _data = nullptr;
+  _size = 0;
+}
+
+auto MappedFile::Buffer() const -> Mat {
+  if (_data == nullptr) {
+    return Mat();
+  }
+  return Mat(1, (int)_size, CV_8U, const_cast<uchar *>(_data));
+}
+
+auto ReadImageSize(const uchar *data, size_t size, cv::Size &image_size)
+    -> bool {
+  if (data == nullptr || size < 4) {
+    return false;
+  }
+  if (data[0] == 0xFF && data[1] == 0xD8) {
+    return ReadJpegSize(data, size, image_size);
+  }
+  const uchar png_signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+  if (size >= 8 && std::memcmp(data, png_signature, 8) == 0) {
+    return ReadPngSize(data, size, image_size);
+  }
+  return false;
+}
+
+auto ReadImageFileSize(const std::string &file_name, cv::Size &image_size)
+    -> bool {
+  MappedFile file(file_name);
+  return file.IsOpen() && ReadImageSize(file.Data(), file.Size(), image_size);
+}
+
+auto ReducedDecodeFlag(const cv::Size &full_size, double megapix) -> int {
+  if (megapix <= 0 || full_size.area() <= 0) {
+    return cv::IMREAD_COLOR;
+  }
+  const std::pair<int, int> reduced[3] = {{8, cv::IMREAD_REDUCED_COLOR_8},
+                                          {4, cv::IMREAD_REDUCED_COLOR_4},
+                                          {2, cv::IMREAD_REDUCED_COLOR_2}};
+  for (const auto &[factor, flag] : reduced) {
+    double area =
+        double(full_size.width / factor) * (full_size.height / factor);
+    if (area >= megapix * 1e6) {
+      return flag;
+    }
+  }
+  return cv::IMREAD_COLOR;
+}
+
+auto DecodeImageFile(const std::string &file_name, double megapix,
+                     cv::Size *full_size) -> Image {
+  MappedFile file(file_name);
+  if (!file.IsOpen()) {
+    LOG(WARNING) << "Couldn't open image file : " << file_name;
+    return Image();
+  }
+  cv::Size size;
+  int flag = cv::IMREAD_COLOR;
+  if (ReadImageSize(file.Data(), file.Size(), size)) {
+    flag = ReducedDecodeFlag(size, megapix);
+  }
+  Image image = cv::imdecode(file.Buffer(), flag);
+  if (image.empty()) {
+    LOG(WARNING) << "Couldn't decode image file : " << file_name;
+    return image;
+  }
+  if (full_size != nullptr) {
+    *full_size = size.area() > 0 ? size : image.size();
+  }
+  return image;
+}
+}  // namespace ImageStitch
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+#include "cvTypeDef.hpp"
+
+namespace ImageStitch {
+
+/**
+ * @brief 只读内存映射文件，析构时自动解除映射。
+ */
+class MappedFile {
+ public:
+  MappedFile() = default;
+  explicit MappedFile(const std::string &file_name);
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+  ~MappedFile();
+  auto Open(const std::string &file_name) -> bool;
+  auto Close() -> void;
+  inline auto IsOpen() const -> bool { return _data != nullptr; }
+  inline auto Data() const -> const uchar * { return _data; }
+  inline auto Size() const -> size_t { return _size; }
+  /**
+   * @brief 以不复制数据的方式把映射内容包装成1xN的CV_8U矩阵，供imdecode使用
+   */
+  auto Buffer() const -> Mat;
+
+ private:
+  const uchar *_data = nullptr;
+  size_t _size = 0;
+#ifdef WIN
+  void *_file = nullptr;
+  void *_mapping = nullptr;
+#endif
+};
+
+/**
+ * @brief 只解析JPEG(SOF段)和PNG(IHDR块)的文件头获取图像尺寸，不解码像素。
+ *
+ * @return bool 格式不支持或文件头损坏时返回false
+ */
+auto ReadImageSize(const uchar *data, size_t size, cv::Size &image_size)
+    -> bool;
+
+/**
+ * @brief 只读取文件头获取图像尺寸，失败时返回false
+ */
+auto ReadImageFileSize(const std::string &file_name, cv::Size &image_size)
+    -> bool;
+
+/**
+ * @brief
+ * 选择解码后面积仍不小于megapix(百万像素)的最小IMREAD_REDUCED_COLOR_*标志，
+ * JPEG可以直接在DCT域缩小，不必先解码全分辨率。megapix小于等于零时返回IMREAD_COLOR。
+ */
+auto ReducedDecodeFlag(const cv::Size &full_size, double megapix) -> int;
+
+/**
+ * @brief
+ * 通过内存映射读取并解码图像。megapix大于零时只保证解码结果不小于该面积，
+ * 尽可能降采样解码以节省时间和内存。
+ *
+ * @param file_name
+ * @param megapix 需要的最小面积(百万像素)，小于等于零表示全分辨率
+ * @param full_size 可选，输出原图尺寸
+ * @return Image 失败时为空
+ */
+auto DecodeImageFile(const std::string &file_name, double megapix = -1,
+                     cv::Size *full_size = nullptr) -> Image;
+}  // namespace ImageStitch
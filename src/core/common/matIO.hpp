@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstdint>
+#include <fstream>
+
+#include "cvTypeDef.hpp"
+
+namespace ImageStitch {
+
+template <typename T>
+inline void WritePod(std::ofstream &out, const T &value) {
+  out.write(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+
+template <typename T>
+inline bool ReadPod(std::ifstream &in, T &value) {
+  in.read(reinterpret_cast<char *>(&value), sizeof(T));
+  return in.good();
+}
+
+/**
+ * @brief 以(行, 列, 类型, 逐行数据)的二进制格式写入矩阵，支持非连续的ROI。
+ */
+inline void WriteMat(std::ofstream &out, const Mat &mat) {
+  WritePod<int32_t>(out, mat.rows);
+  WritePod<int32_t>(out, mat.cols);
+  WritePod<int32_t>(out, mat.type());
+  for (int i = 0; i < mat.rows; ++i) {
+    out.write(reinterpret_cast<const char *>(mat.ptr(i)),
+              mat.cols * mat.elemSize());
+  }
+}
+
+inline bool ReadMat(std::ifstream &in, Mat &mat) {
+  int32_t rows, cols, type;
+  if (!ReadPod(in, rows) || !ReadPod(in, cols) || !ReadPod(in, type)) {
+    return false;
+  }
+  if (rows < 0 || cols < 0) {
+    return false;
+  }
+  if (rows == 0 || cols == 0) {
+    mat.release();
+    return true;
+  }
+  mat.create(rows, cols, type);
+  for (int i = 0; i < rows; ++i) {
+    in.read(reinterpret_cast<char *>(mat.ptr(i)), cols * mat.elemSize());
+  }
+  return in.good();
+}
+}  // namespace ImageStitch
@@ -0,0 +1,73 @@
+#include "prefetchLoader.hpp"
+
+#include <algorithm>
+
+namespace ImageStitch {
+
+PrefetchLoader::PrefetchLoader(int count, Loader loader, int depth,
+                               int workers)
+    : _count(count), _depth((std::max)(1, depth)), _loader(loader) {
+  workers = (std::min)((std::max)(1, workers), _depth);
+  for (int i = 0; i < workers; ++i) {
+    _threads.emplace_back([this]() { Run(); });
+  }
+}
+
+PrefetchLoader::~PrefetchLoader() {
+  {
+    std::lock_guard<std::mutex> locker(_mutex);
+    _stop = true;
+  }
+  _space_cond.notify_all();
+  _ready_cond.notify_all();
+  for (auto &thread : _threads) {
+    thread.join();
+  }
+}
+
+auto PrefetchLoader::Take(int index) -> ImageHandlePtr {
+  std::unique_lock<std::mutex> locker(_mutex);
+  _ready_cond.wait(locker, [this, index]() {
+    return _stop || _ready.find(index) != _ready.end();
+  });
+  auto item = _ready.find(index);
+  if (item == _ready.end()) {
+    return nullptr;
+  }
+  auto handle = item->second;
+  _ready.erase(item);
+  _next_take = index + 1;
+  locker.unlock();
+  _space_cond.notify_all();
+  return handle;
+}
+
+auto PrefetchLoader::Run() -> void {
+  while (true) {
+    int index;
+    {
+      std::unique_lock<std::mutex> locker(_mutex);
+      // 超出预取窗口时等待消费者取走图像
+      _space_cond.wait(locker, [this]() {
+        return _stop || _next_load >= _count ||
+               _next_load < _next_take + _depth;
+      });
+      if (_stop || _next_load >= _count) {
+        return;
+      }
+      index = _next_load++;
+    }
+    ImageHandlePtr handle;
+    try {
+      handle = _loader(index);
+    } catch (const std::exception &e) {
+      LOG(ERROR) << "Prefetch image " << index << " failed : " << e.what();
+    }
+    {
+      std::lock_guard<std::mutex> locker(_mutex);
+      _ready[index] = handle;
+    }
+    _ready_cond.notify_all();
+  }
+}
+}  // namespace ImageStitch
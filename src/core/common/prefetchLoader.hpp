@@ -0,0 +1,51 @@
+#pragma once
+
+#include <condition_variable>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "imageHandle.hpp"
+
+namespace ImageStitch {
+
+/**
+ * @brief 预取加载器。
+ * 后台线程按下标顺序提前加载图像，消费者按0..count-1的顺序Take，
+ * 已加载但未取走的图像不超过depth张，加载与调用方的计算(如特征提取)重叠进行。
+ */
+class PrefetchLoader {
+ public:
+  using Loader = std::function<ImageHandlePtr(int)>;
+
+ public:
+  PrefetchLoader(int count, Loader loader, int depth = 4, int workers = 2);
+  PrefetchLoader(const PrefetchLoader &) = delete;
+  PrefetchLoader &operator=(const PrefetchLoader &) = delete;
+  ~PrefetchLoader();
+  /**
+   * @brief 取出第index张图像，必须按顺序调用，图像未加载完时阻塞等待
+   *
+   * @return ImageHandlePtr 加载失败时为空
+   */
+  auto Take(int index) -> ImageHandlePtr;
+
+ private:
+  auto Run() -> void;
+
+ private:
+  const int _count;
+  const int _depth;
+  Loader _loader;
+  std::mutex _mutex;
+  std::condition_variable _space_cond;
+  std::condition_variable _ready_cond;
+  std::map<int, ImageHandlePtr> _ready;
+  int _next_load = 0;
+  int _next_take = 0;
+  bool _stop = false;
+  std::vector<std::thread> _threads;
+};
+}  // namespace ImageStitch
@@ -0,0 +1,171 @@
+#include "cameraParamsStore.hpp"
+
+#include <glog/logging.h>
+
+#include <Eigen/Dense>
+#include <algorithm>
+#include <fstream>
+#include <nlohmann/json.hpp>
+
+namespace ImageStitch {
+
+auto CameraParamsStore::Find(uint64_t hash, CameraParams &camera) const
+    -> bool {
+  auto item = _cameras.find(hash);
+  if (item == _cameras.end()) {
+    return false;
+  }
+  camera = item->second;
+  camera.R = item->second.R.clone();
+  camera.t = item->second.t.clone();
+  return true;
+}
+
+auto CameraParamsStore::Set(uint64_t hash, const CameraParams &camera) -> void {
+  CameraParams stored = camera;
+  stored.R = camera.R.clone();
+  stored.t = camera.t.clone();
+  _cameras[hash] = stored;
+  _dirty = true;
+}
+
+auto CameraParamsStore::Clear() -> void {
+  _cameras.clear();
+  _dirty = false;
+}
+
+auto CameraParamsStore::Size() const -> size_t { return _cameras.size(); }
+
+auto CameraParamsStore::Save(const std::string &file_name) -> bool {
+  nlohmann::json cameras = nlohmann::json::array();
+  for (const auto &[hash, camera] : _cameras) {
+    Mat R, t;
+    camera.R.convertTo(R, CV_64F);
+    camera.t.convertTo(t, CV_64F);
+    nlohmann::json item;
+    item["hash"] = std::to_string(hash);
+    item["focal"] = camera.focal;
+    item["aspect"] = camera.aspect;
+    item["ppx"] = camera.ppx;
+    item["ppy"] = camera.ppy;
+    item["R"] = std::vector<double>(R.begin<double>(), R.end<double>());
+    item["t"] = std::vector<double>(t.begin<double>(), t.end<double>());
+    cameras.push_back(item);
+  }
+  std::ofstream out(file_name);
+  if (!out.is_open()) {
+    LOG(WARNING) << "Couldn't open camera params file : " << file_name;
+    return false;
+  }
+  out << nlohmann::json{{"version", 1}, {"cameras", cameras}}.dump(2);
+  _dirty = false;
+  LOG(INFO) << "Camera params saved : " << file_name << " ("
+            << _cameras.size() << " cameras)";
+  return true;
+}
+
+auto CameraParamsStore::Load(const std::string &file_name) -> bool {
+  std::ifstream in(file_name);
+  if (!in.is_open()) {
+    LOG(WARNING) << "Couldn't open camera params file : " << file_name;
+    return false;
+  }
+  try {
+    nlohmann::json json;
+    in >> json;
+    for (const auto &item : json.at("cameras")) {
+      CameraParams camera;
+      camera.focal = item.at("focal").get<double>();
+      camera.aspect = item.at("aspect").get<double>();
+      camera.ppx = item.at("ppx").get<double>();
+      camera.ppy = item.at("ppy").get<double>();
+      auto R = item.at("R").get<std::vector<double>>();
+      auto t = item.at("t").get<std::vector<double>>();
+      if (R.size() != 9 || t.size() != 3) {
+        continue;
+      }
+      Mat(3, 3, CV_64F, R.data()).convertTo(camera.R, CV_32F);
+      Mat(3, 1, CV_64F, t.data()).convertTo(camera.t, CV_64F);
+      _cameras[std::stoull(item.at("hash").get<std::string>())] = camera;
+    }
+  } catch (const std::exception &e) {
+    LOG(WARNING) << "Invalid camera params file : " << file_name << ", "
+                 << e.what();
+    return false;
+  }
+  _dirty = false;
+  LOG(INFO) << "Camera params loaded : " << file_name << " ("
+            << _cameras.size() << " cameras)";
+  return true;
+}
+
+auto CameraParamsStore::WarmStart(const std::vector<uint64_t> &hashes,
+                                  std::vector<CameraParams> &cameras,
+                                  bool rotation) const -> int {
+  std::vector<int> known, unknown;
+  std::vector<CameraParams> stored(cameras.size());
+  for (int i = 0; i < (int)cameras.size(); ++i) {
+    if (Find(hashes[i], stored[i])) {
+      known.push_back(i);
+    } else {
+      unknown.push_back(i);
+    }
+  }
+  if (known.empty()) {
+    return 0;
+  }
+  if (!unknown.empty()) {
+    // 求T使得 T * R_估计 ≈ R_保存，逐行做线性最小二乘
+    Eigen::MatrixXd A(known.size() * 3, 3);
+    Eigen::MatrixXd B(known.size() * 3, 3);
+    std::vector<double> focal_ratios;
+    for (size_t k = 0; k < known.size(); ++k) {
+      Mat estimated, saved;
+      cameras[known[k]].R.convertTo(estimated, CV_64F);
+      stored[known[k]].R.convertTo(saved, CV_64F);
+      // (T R)^T = R^T T^T
+      for (int r = 0; r < 3; ++r) {
+        for (int c = 0; c < 3; ++c) {
+          A(k * 3 + r, c) = estimated.at<double>(c, r);
+          B(k * 3 + r, c) = saved.at<double>(c, r);
+        }
+      }
+      if (cameras[known[k]].focal > 0) {
+        focal_ratios.push_back(stored[known[k]].focal /
+                               cameras[known[k]].focal);
+      }
+    }
+    Eigen::Matrix3d Tt = A.colPivHouseholderQr().solve(B);
+    Mat T(3, 3, CV_64F);
+    for (int r = 0; r < 3; ++r) {
+      for (int c = 0; c < 3; ++c) {
+        T.at<double>(r, c) = Tt(c, r);
+      }
+    }
+    if (rotation) {
+      cv::SVD svd(T, cv::SVD::FULL_UV);
+      T = svd.u * svd.vt;
+      if (cv::determinant(T) < 0) {
+        T *= -1;
+      }
+    }
+    double focal_ratio = 1.0;
+    if (!focal_ratios.empty()) {
+      std::nth_element(focal_ratios.begin(),
+                       focal_ratios.begin() + focal_ratios.size() / 2,
+                       focal_ratios.end());
+      focal_ratio = focal_ratios[focal_ratios.size() / 2];
+    }
+    for (int i : unknown) {
+      Mat R;
+      cameras[i].R.convertTo(R, CV_64F);
+      Mat(T * R).convertTo(cameras[i].R, CV_32F);
+      cameras[i].focal *= focal_ratio;
+    }
+  }
+  for (int i : known) {
+    cameras[i] = stored[i];
+  }
+  return known.size();
+}
+}  // namespace ImageStitch
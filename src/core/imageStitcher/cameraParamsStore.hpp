@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "../common/cvTypeDef.hpp"
+
+namespace ImageStitch {
+
+/**
+ * @brief 按图像内容哈希保存的相机参数。
+ * 重新拼接时，未变化的图像直接使用上一次光束平差的结果作为初值；
+ * 新图像的估计结果通过与已知图像对齐变换到同一坐标系。
+ */
+class CameraParamsStore {
+ public:
+  auto Find(uint64_t hash, CameraParams &camera) const -> bool;
+  auto Set(uint64_t hash, const CameraParams &camera) -> void;
+  auto Clear() -> void;
+  auto Size() const -> size_t;
+  inline bool Dirty() const { return _dirty; }
+  auto Save(const std::string &file_name) -> bool;
+  auto Load(const std::string &file_name) -> bool;
+  /**
+   * @brief 用估计值初始化相机参数：已知图像使用保存的参数，其余图像的估计值
+   * 经最小二乘变换对齐到保存的坐标系。
+   *
+   * @param hashes 每台相机对应图像的哈希
+   * @param cameras 估计器的结果，原地修改
+   * @param rotation 相机模型是否为旋转(单应性估计)，是则把对齐变换投影为旋转，
+   * 仿射模型保留完整的仿射变换
+   * @return int 使用保存参数的相机数
+   */
+  auto WarmStart(const std::vector<uint64_t> &hashes,
+                 std::vector<CameraParams> &cameras, bool rotation) const
+      -> int;
+
+ private:
+  std::unordered_map<uint64_t, CameraParams> _cameras;
+  bool _dirty = false;
+};
+}  // namespace ImageStitch
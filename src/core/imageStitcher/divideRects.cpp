@@ -0,0 +1,21 @@
+#include "divideRects.hpp"
+
+namespace ImageStitch {
+
+auto DivideRects(const cv::Size &size, int direction, int count,
+                 double overlap) -> std::vector<cv::Rect> {
+  const int length = direction == 1 ? size.height : size.width;
+  const int strip = cvCeil(length / (count - (count - 1) * overlap));
+  const double step = count > 1 ? double(length - strip) / (count - 1) : 0;
+  std::vector<cv::Rect> rects;
+  for (int k = 0; k < count; ++k) {
+    const int offset = cvRound(k * step);
+    if (direction == 1) {
+      rects.emplace_back(0, offset, size.width, strip);
+    } else {
+      rects.emplace_back(offset, 0, strip, size.height);
+    }
+  }
+  return rects;
+}
+}  // namespace ImageStitch
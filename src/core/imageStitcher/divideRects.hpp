@@ -0,0 +1,24 @@
+#pragma once
+
+#include <vector>
+
+#include "../common/cvTypeDef.hpp"
+
+namespace ImageStitch {
+
+/**
+ * @brief 沿行或列把图像切成count条长度相同、相邻重叠overlap比例的条带。
+ * 条带均匀分布，第一条从0开始，最后一条结束于图像边界；count为1或overlap为1时
+ * 每条都是整张图像。
+ * 默认的3条、重叠0.5时条带长L/2，起点为0、L/4、L/2；旧版固定切割的起点为
+ * 0、L/3、L/2，中间条带偏后，两者并不相同。
+ *
+ * @param size 图像尺寸
+ * @param direction 1沿行(水平条带)，2沿列(竖直条带)
+ * @param count 条带数量
+ * @param overlap 相邻条带重叠部分占条带长度的比例，[0, 1]
+ * @return std::vector<cv::Rect>
+ */
+auto DivideRects(const cv::Size &size, int direction, int count,
+                 double overlap) -> std::vector<cv::Rect>;
+}  // namespace ImageStitch
@@ -0,0 +1,238 @@
+#include "fastGainCompensator.hpp"
+
+#include <glog/logging.h>
+#include <omp.h>
+
+#include <Eigen/Sparse>
+#include <cmath>
+
+namespace ImageStitch {
+
+namespace {
+// 与GainCompensator相同的正则系数
+const double kAlpha = 0.01;
+const double kBeta = 100;
+const int kGainFilteringIterations = 2;
+
+struct Thumbnail {
+  cv::Point corner;
+  cv::Mat_<float> intensity;
+  cv::Mat_<uchar> mask;
+  // 缩略图像素对应的块下标
+  cv::Mat_<int> blocks;
+  cv::Size blocks_size;
+};
+
+struct BlockPairStat {
+  int count = 0;
+  double sum1 = 0;
+  double sum2 = 0;
+};
+}  // namespace
+
+FastGainCompensator::FastGainCompensator(int bl_width, int bl_height,
+                                         double thumbnail_scale)
+    : _bl_width(bl_width),
+      _bl_height(bl_height),
+      _thumbnail_scale(thumbnail_scale) {}
+
+void FastGainCompensator::feed(
+    const std::vector<cv::Point> &corners, const std::vector<cv::UMat> &images,
+    const std::vector<std::pair<cv::UMat, uchar>> &masks) {
+  LOG(INFO) << "Fast exposure compensation...";
+  int64 start = cv::getTickCount();
+  const int n = images.size();
+  const double s = _thumbnail_scale;
+  const bool use_blocks = _bl_width > 0 && _bl_height > 0;
+
+  // 缩略图、亮度和块划分，各图像互不依赖
+  std::vector<Thumbnail> thumbs(n);
+#pragma omp parallel for
+  for (int i = 0; i < n; ++i) {
+    auto &thumb = thumbs[i];
+    Mat image = images[i].getMat(cv::ACCESS_READ);
+    Mat mask = masks[i].first.getMat(cv::ACCESS_READ);
+    cv::Size size(std::max(1, cvRound(image.cols * s)),
+                  std::max(1, cvRound(image.rows * s)));
+    Mat small, small_mask;
+    cv::resize(image, small, size, 0, 0, cv::INTER_AREA);
+    cv::resize(mask, small_mask, size, 0, 0, cv::INTER_NEAREST);
+    small.convertTo(small, CV_32F);
+    Mat squared = small.mul(small);
+    cv::transform(squared, thumb.intensity, cv::Matx13f(1, 1, 1));
+    cv::sqrt(thumb.intensity, thumb.intensity);
+    cv::compare(small_mask, (double)masks[i].second, thumb.mask, cv::CMP_EQ);
+    thumb.corner = cv::Point(cvRound(corners[i].x * s),
+                             cvRound(corners[i].y * s));
+    if (use_blocks) {
+      thumb.blocks_size = cv::Size((image.cols + _bl_width - 1) / _bl_width,
+                                   (image.rows + _bl_height - 1) / _bl_height);
+    } else {
+      thumb.blocks_size = cv::Size(1, 1);
+    }
+    thumb.blocks.create(size);
+    for (int y = 0; y < size.height; ++y) {
+      int by = std::min(thumb.blocks_size.height - 1,
+                        use_blocks ? int(y / s) / _bl_height : 0);
+      for (int x = 0; x < size.width; ++x) {
+        int bx = std::min(thumb.blocks_size.width - 1,
+                          use_blocks ? int(x / s) / _bl_width : 0);
+        thumb.blocks(y, x) = by * thumb.blocks_size.width + bx;
+      }
+    }
+  }
+  std::vector<int> offsets(n + 1, 0);
+  for (int i = 0; i < n; ++i) {
+    offsets[i + 1] = offsets[i] + thumbs[i].blocks_size.area();
+  }
+  const int node_count = offsets[n];
+
+  // 每个块自身的有效像素数
+  std::vector<int> self_counts(node_count, 0);
+#pragma omp parallel for
+  for (int i = 0; i < n; ++i) {
+    const auto &thumb = thumbs[i];
+    for (int y = 0; y < thumb.mask.rows; ++y) {
+      for (int x = 0; x < thumb.mask.cols; ++x) {
+        if (thumb.mask(y, x)) {
+          self_counts[offsets[i] + thumb.blocks(y, x)]++;
+        }
+      }
+    }
+  }
+
+  // 有重叠的图像对，逐对统计重叠区域的亮度
+  std::vector<std::pair<int, int>> pairs;
+  for (int i = 0; i < n; ++i) {
+    for (int j = i + 1; j < n; ++j) {
+      cv::Rect roi;
+      if (cv::detail::overlapRoi(thumbs[i].corner, thumbs[j].corner,
+                                 thumbs[i].mask.size(), thumbs[j].mask.size(),
+                                 roi)) {
+        pairs.emplace_back(i, j);
+      }
+    }
+  }
+  std::vector<std::vector<Eigen::Triplet<double>>> pair_triplets(pairs.size());
+  std::vector<std::vector<std::pair<int, double>>> pair_rhs(pairs.size());
+#pragma omp parallel for schedule(dynamic)
+  for (int k = 0; k < (int)pairs.size(); ++k) {
+    const auto &t1 = thumbs[pairs[k].first];
+    const auto &t2 = thumbs[pairs[k].second];
+    const int o1 = offsets[pairs[k].first], o2 = offsets[pairs[k].second];
+    const int b2 = t2.blocks_size.area();
+    cv::Rect roi;
+    cv::detail::overlapRoi(t1.corner, t2.corner, t1.mask.size(),
+                           t2.mask.size(), roi);
+    std::vector<BlockPairStat> stats(t1.blocks_size.area() * b2);
+    for (int y = roi.y; y < roi.br().y; ++y) {
+      int y1 = y - t1.corner.y, y2 = y - t2.corner.y;
+      for (int x = roi.x; x < roi.br().x; ++x) {
+        int x1 = x - t1.corner.x, x2 = x - t2.corner.x;
+        if (t1.mask(y1, x1) && t2.mask(y2, x2)) {
+          auto &stat = stats[t1.blocks(y1, x1) * b2 + t2.blocks(y2, x2)];
+          stat.count++;
+          stat.sum1 += t1.intensity(y1, x1);
+          stat.sum2 += t2.intensity(y2, x2);
+        }
+      }
+    }
+    auto &triplets = pair_triplets[k];
+    auto &rhs = pair_rhs[k];
+    for (int idx = 0; idx < (int)stats.size(); ++idx) {
+      const auto &stat = stats[idx];
+      if (stat.count == 0) {
+        continue;
+      }
+      const int a = o1 + idx / b2, b = o2 + idx % b2;
+      const double N = stat.count;
+      const double Iab = stat.sum1 / N, Iba = stat.sum2 / N;
+      triplets.emplace_back(a, a, kBeta * N + 2 * kAlpha * Iab * Iab * N);
+      triplets.emplace_back(b, b, kBeta * N + 2 * kAlpha * Iba * Iba * N);
+      triplets.emplace_back(a, b, -2 * kAlpha * Iab * Iba * N);
+      triplets.emplace_back(b, a, -2 * kAlpha * Iab * Iba * N);
+      rhs.emplace_back(a, kBeta * N);
+      rhs.emplace_back(b, kBeta * N);
+    }
+  }
+
+  // 与GainCompensator相同的方程组，只保留非零项
+  std::vector<Eigen::Triplet<double>> triplets;
+  Eigen::VectorXd b = Eigen::VectorXd::Zero(node_count);
+  for (int a = 0; a < node_count; ++a) {
+    double N = std::max(1, self_counts[a]);
+    triplets.emplace_back(a, a, kBeta * N);
+    b(a) += kBeta * N;
+  }
+  for (size_t k = 0; k < pairs.size(); ++k) {
+    triplets.insert(triplets.end(), pair_triplets[k].begin(),
+                    pair_triplets[k].end());
+    for (const auto &[node, value] : pair_rhs[k]) {
+      b(node) += value;
+    }
+  }
+  Eigen::SparseMatrix<double> A(node_count, node_count);
+  A.setFromTriplets(triplets.begin(), triplets.end());
+  Eigen::SimplicialLDLT<Eigen::SparseMatrix<double>> solver(A);
+  Eigen::VectorXd gains;
+  if (solver.info() == Eigen::Success) {
+    gains = solver.solve(b);
+  }
+  if (solver.info() != Eigen::Success || gains.size() != node_count) {
+    LOG(WARNING) << "Fast exposure compensation failed to solve gains";
+    gains = Eigen::VectorXd::Ones(node_count);
+  }
+
+  _gain_maps.resize(n);
+  float kernel_data[] = {0.25f, 0.5f, 0.25f};
+  Mat kernel(1, 3, CV_32F, kernel_data);
+  for (int i = 0; i < n; ++i) {
+    const auto &blocks_size = thumbs[i].blocks_size;
+    _gain_maps[i].create(blocks_size);
+    for (int k = 0; k < blocks_size.area(); ++k) {
+      _gain_maps[i](k / blocks_size.width, k % blocks_size.width) =
+          (float)gains(offsets[i] + k);
+    }
+    if (use_blocks) {
+      for (int iter = 0; iter < kGainFilteringIterations; ++iter) {
+        cv::sepFilter2D(_gain_maps[i], _gain_maps[i], CV_32F, kernel, kernel,
+                        cv::Point(-1, -1), 0, cv::BORDER_REFLECT);
+      }
+    }
+  }
+  LOG(INFO) << "Fast exposure compensation, " << node_count << " blocks, "
+            << pairs.size() << " pairs, time: "
+            << ((cv::getTickCount() - start) / cv::getTickFrequency())
+            << " sec";
+}
+
+void FastGainCompensator::apply(int index, cv::Point /*corner*/,
+                                cv::InputOutputArray image,
+                                cv::InputArray /*mask*/) {
+  const auto &gain_map = _gain_maps[index];
+  Mat img = image.getMat();
+  if (gain_map.total() == 1) {
+    cv::multiply(img, cv::Scalar::all(gain_map(0, 0)), img);
+    return;
+  }
+  Mat gain, gains;
+  cv::resize(gain_map, gain, img.size(), 0, 0, cv::INTER_LINEAR);
+  std::vector<Mat> channels(img.channels(), gain);
+  cv::merge(channels, gains);
+  cv::multiply(img, gains, img, 1, img.type());
+}
+
+void FastGainCompensator::getMatGains(std::vector<Mat> &umv) {
+  umv.clear();
+  for (const auto &gain_map : _gain_maps) {
+    umv.push_back(gain_map.clone());
+  }
+}
+
+void FastGainCompensator::setMatGains(std::vector<Mat> &umv) {
+  _gain_maps.resize(umv.size());
+  for (size_t i = 0; i < umv.size(); ++i) {
+    umv[i].convertTo(_gain_maps[i], CV_32F);
+  }
+}
+}  // namespace ImageStitch
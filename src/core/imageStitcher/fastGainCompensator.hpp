@@ -0,0 +1,39 @@
+#pragma once
+
+#include <vector>
+
+#include "../common/cvTypeDef.hpp"
+
+namespace ImageStitch {
+
+/**
+ * @brief 基于缩略图的增益补偿器。
+ * 与GainCompensator/BlocksGainCompensator使用相同的误差模型，但重叠统计在
+ * 缩略图上并行计算，块增益的方程组只在相邻块之间有非零项，用稀疏分解求解；
+ * 应用时把块增益插值到原分辨率后整幅相乘。
+ */
+class FastGainCompensator : public cv::detail::ExposureCompensator {
+ public:
+  /**
+   * @param bl_width 块宽度(输入分辨率下的像素)，为0时只估计整幅图像的增益
+   * @param bl_height 块高度
+   * @param thumbnail_scale 统计重叠区域时使用的缩略图比例
+   */
+  FastGainCompensator(int bl_width = 0, int bl_height = 0,
+                      double thumbnail_scale = 0.25);
+  void feed(const std::vector<cv::Point> &corners,
+            const std::vector<cv::UMat> &images,
+            const std::vector<std::pair<cv::UMat, uchar>> &masks) override;
+  void apply(int index, cv::Point corner, cv::InputOutputArray image,
+             cv::InputArray mask) override;
+  void getMatGains(std::vector<Mat> &umv) override;
+  void setMatGains(std::vector<Mat> &umv) override;
+
+ private:
+  int _bl_width;
+  int _bl_height;
+  double _thumbnail_scale;
+  // 每张图像的块增益，整幅增益时为1x1
+  std::vector<cv::Mat_<float>> _gain_maps;
+};
+}  // namespace ImageStitch
@@ -0,0 +1,316 @@
+#include "hierarchicalBundleAdjuster.hpp"
+
+#include <glog/logging.h>
+#include <omp.h>
+
+#include <Eigen/Dense>
+#include <algorithm>
+#include <deque>
+#include <sstream>
+
+namespace ImageStitch {
+
+namespace {
+struct Neighbor {
+  int index;
+  int inliers;
+};
+
+std::vector<std::vector<Neighbor>> BuildAdjacency(
+    int num_images, const std::vector<MatchesInfo> &pairwise_matches,
+    double conf_thresh) {
+  std::vector<std::vector<Neighbor>> adjacency(num_images);
+  for (int i = 0; i < num_images; ++i) {
+    for (int j = i + 1; j < num_images; ++j) {
+      const auto &matches_info = pairwise_matches[i * num_images + j];
+      if (matches_info.confidence < conf_thresh ||
+          matches_info.num_inliers <= 0) {
+        continue;
+      }
+      adjacency[i].push_back({j, matches_info.num_inliers});
+      adjacency[j].push_back({i, matches_info.num_inliers});
+    }
+  }
+  // 匹配点多的邻居优先并入同一块
+  for (auto &neighbors : adjacency) {
+    std::sort(neighbors.begin(), neighbors.end(),
+              [](const Neighbor &a, const Neighbor &b) {
+                return a.inliers > b.inliers;
+              });
+  }
+  return adjacency;
+}
+
+cv::Matx33d ToMatx(const Mat &R) {
+  cv::Matx33d result;
+  R.convertTo(result, CV_64F);
+  return result;
+}
+}  // namespace
+
+HierarchicalBundleAdjuster::HierarchicalBundleAdjuster(
+    SparseBundleAdjuster::Model model, int cluster_size, Reporter reporter)
+    : cv::detail::BundleAdjusterBase(
+          model == SparseBundleAdjuster::AFFINE ? 6 : 4,
+          model == SparseBundleAdjuster::RAY ? 3 : 2),
+      _model(model),
+      _cluster_size(std::max(2, cluster_size)),
+      _reporter(std::move(reporter)) {}
+
+auto HierarchicalBundleAdjuster::Partition(
+    int num_images, const std::vector<MatchesInfo> &pairwise_matches,
+    double conf_thresh, int cluster_size) -> std::vector<std::vector<int>> {
+  auto adjacency = BuildAdjacency(num_images, pairwise_matches, conf_thresh);
+  std::vector<int> seeds(num_images);
+  for (int i = 0; i < num_images; ++i) {
+    seeds[i] = i;
+  }
+  std::stable_sort(seeds.begin(), seeds.end(), [&](int a, int b) {
+    return adjacency[a].size() > adjacency[b].size();
+  });
+  std::vector<int> assigned(num_images, -1);
+  std::vector<std::vector<int>> clusters;
+  for (int seed : seeds) {
+    if (assigned[seed] >= 0) {
+      continue;
+    }
+    std::vector<int> cluster;
+    std::deque<int> queue{seed};
+    while (!queue.empty() && (int)cluster.size() < cluster_size) {
+      int u = queue.front();
+      queue.pop_front();
+      if (assigned[u] >= 0) {
+        continue;
+      }
+      assigned[u] = clusters.size();
+      cluster.push_back(u);
+      for (const auto &neighbor : adjacency[u]) {
+        if (assigned[neighbor.index] < 0) {
+          queue.push_back(neighbor.index);
+        }
+      }
+    }
+    std::sort(cluster.begin(), cluster.end());
+    clusters.push_back(cluster);
+  }
+  return clusters;
+}
+
+auto HierarchicalBundleAdjuster::Report(const std::string &message) const
+    -> void {
+  LOG(INFO) << message;
+  if (_reporter) {
+    _reporter(message);
+  }
+}
+
+bool HierarchicalBundleAdjuster::estimate(
+    const std::vector<ImageFeatures> &features,
+    const std::vector<MatchesInfo> &pairwise_matches,
+    std::vector<CameraParams> &cameras) {
+  int64 start = cv::getTickCount();
+  const int n = features.size();
+  auto cores = Partition(n, pairwise_matches, confThresh(), _cluster_size);
+  const int cluster_count = cores.size();
+  _cluster_times.assign(cluster_count, 0);
+  if (cluster_count <= 1) {
+    SparseBundleAdjuster adjuster(_model);
+    adjuster.setConfThresh(confThresh());
+    adjuster.setTermCriteria(termCriteria());
+    return adjuster(features, pairwise_matches, cameras);
+  }
+
+  // 每块向外扩展一层，相邻的块共享边界上的图像
+  auto adjacency = BuildAdjacency(n, pairwise_matches, confThresh());
+  std::vector<int> owner(n, -1);
+  std::vector<std::vector<int>> clusters(cluster_count);
+  for (int c = 0; c < cluster_count; ++c) {
+    std::vector<bool> in_cluster(n, false);
+    for (int u : cores[c]) {
+      owner[u] = c;
+      in_cluster[u] = true;
+    }
+    for (int u : cores[c]) {
+      for (const auto &neighbor : adjacency[u]) {
+        in_cluster[neighbor.index] = true;
+      }
+    }
+    for (int u = 0; u < n; ++u) {
+      if (in_cluster[u]) {
+        clusters[c].push_back(u);
+      }
+    }
+  }
+
+  // 各块独立平差
+  std::vector<std::vector<CameraParams>> cluster_cameras(cluster_count);
+  // 不能用vector<bool>，按位存储时并行写相邻的块会互相覆盖
+  std::vector<char> succeeded(cluster_count, 0);
+#pragma omp parallel for schedule(dynamic)
+  for (int c = 0; c < cluster_count; ++c) {
+    int64 cluster_start = cv::getTickCount();
+    const auto &nodes = clusters[c];
+    const int k = nodes.size();
+    std::vector<ImageFeatures> sub_features(k);
+    std::vector<MatchesInfo> sub_matches(k * k);
+    auto &sub_cameras = cluster_cameras[c];
+    sub_cameras.resize(k);
+    for (int a = 0; a < k; ++a) {
+      sub_features[a] = features[nodes[a]];
+      sub_features[a].img_idx = a;
+      sub_cameras[a] = cameras[nodes[a]];
+      for (int b = 0; b < k; ++b) {
+        auto &matches_info = sub_matches[a * k + b];
+        matches_info = pairwise_matches[nodes[a] * n + nodes[b]];
+        if (matches_info.src_img_idx >= 0) {
+          matches_info.src_img_idx = a;
+          matches_info.dst_img_idx = b;
+        }
+      }
+    }
+    SparseBundleAdjuster adjuster(_model);
+    adjuster.setConfThresh(confThresh());
+    adjuster.setTermCriteria(termCriteria());
+    succeeded[c] = adjuster(sub_features, sub_matches, sub_cameras);
+    _cluster_times[c] =
+        (cv::getTickCount() - cluster_start) / cv::getTickFrequency();
+  }
+  for (int c = 0; c < cluster_count; ++c) {
+    std::stringstream message;
+    message << "分块平差 " << c + 1 << "/" << cluster_count << ": "
+            << cores[c].size() << "(" << clusters[c].size() << ") 张图像, "
+            << _cluster_times[c] << " s";
+    Report(message.str());
+    if (!succeeded[c]) {
+      LOG(WARNING) << "Bundle adjustment of cluster " << c << " failed";
+      return false;
+    }
+  }
+
+  // 图像在各块中的局部下标
+  std::vector<std::vector<std::pair<int, int>>> memberships(n);
+  for (int c = 0; c < cluster_count; ++c) {
+    for (int a = 0; a < (int)clusters[c].size(); ++a) {
+      memberships[clusters[c][a]].emplace_back(c, a);
+    }
+  }
+  // 块之间通过共享图像连通，每个连通分量固定第一块为参考
+  std::vector<int> component(cluster_count, -1);
+  std::vector<int> unknown_index(cluster_count, -1);
+  int unknown_count = 0;
+  for (int c = 0; c < cluster_count; ++c) {
+    if (component[c] >= 0) {
+      continue;
+    }
+    component[c] = c;
+    std::deque<int> queue{c};
+    while (!queue.empty()) {
+      int u = queue.front();
+      queue.pop_front();
+      for (int node : clusters[u]) {
+        for (const auto &[v, a] : memberships[node]) {
+          if (component[v] < 0) {
+            component[v] = c;
+            unknown_index[v] = unknown_count++;
+            queue.push_back(v);
+          }
+        }
+      }
+    }
+  }
+
+  // 共享图像在两块中的全局位姿应一致: T_a R_a = T_b R_b
+  const int rows = _model == SparseBundleAdjuster::RAY ? 3 : 2;
+  const int params_per_cluster = rows * 3;
+  std::vector<cv::Matx33d> transforms(cluster_count, cv::Matx33d::eye());
+  if (unknown_count > 0) {
+    Eigen::MatrixXd AtA =
+        Eigen::MatrixXd::Zero(unknown_count * params_per_cluster,
+                              unknown_count * params_per_cluster);
+    Eigen::VectorXd Atb =
+        Eigen::VectorXd::Zero(unknown_count * params_per_cluster);
+    for (int node = 0; node < n; ++node) {
+      const auto &members = memberships[node];
+      for (size_t x = 0; x < members.size(); ++x) {
+        for (size_t y = x + 1; y < members.size(); ++y) {
+          const int ca = members[x].first, cb = members[y].first;
+          const cv::Matx33d Ra = ToMatx(cluster_cameras[ca][members[x].second].R);
+          const cv::Matx33d Rb = ToMatx(cluster_cameras[cb][members[y].second].R);
+          for (int r = 0; r < rows; ++r) {
+            for (int col = 0; col < 3; ++col) {
+              // 方程: sum_m Ta(r,m)Ra(m,col) - sum_m Tb(r,m)Rb(m,col) = 0
+              Eigen::VectorXd row =
+                  Eigen::VectorXd::Zero(unknown_count * params_per_cluster);
+              double rhs = 0;
+              for (int m = 0; m < 3; ++m) {
+                if (unknown_index[ca] >= 0) {
+                  row(unknown_index[ca] * params_per_cluster + r * 3 + m) +=
+                      Ra(m, col);
+                } else {
+                  rhs -= (r == m ? 1.0 : 0.0) * Ra(m, col);
+                }
+                if (unknown_index[cb] >= 0) {
+                  row(unknown_index[cb] * params_per_cluster + r * 3 + m) -=
+                      Rb(m, col);
+                } else {
+                  rhs += (r == m ? 1.0 : 0.0) * Rb(m, col);
+                }
+              }
+              AtA += row * row.transpose();
+              Atb += row * rhs;
+            }
+          }
+        }
+      }
+    }
+    Eigen::VectorXd t = AtA.ldlt().solve(Atb);
+    for (int c = 0; c < cluster_count; ++c) {
+      if (unknown_index[c] < 0) {
+        continue;
+      }
+      for (int r = 0; r < rows; ++r) {
+        for (int m = 0; m < 3; ++m) {
+          transforms[c](r, m) =
+              t(unknown_index[c] * params_per_cluster + r * 3 + m);
+        }
+      }
+      if (_model == SparseBundleAdjuster::RAY) {
+        // 投影回旋转矩阵
+        cv::SVD svd(Mat(transforms[c]), cv::SVD::FULL_UV);
+        Mat rotation = svd.u * svd.vt;
+        if (cv::determinant(rotation) < 0) {
+          rotation *= -1;
+        }
+        transforms[c] = ToMatx(rotation);
+      }
+    }
+  }
+
+  // 每张图像取其所属块的结果
+  for (int node = 0; node < n; ++node) {
+    const int c = owner[node];
+    int a = -1;
+    for (const auto &[cluster, local] : memberships[node]) {
+      if (cluster == c) {
+        a = local;
+      }
+    }
+    const auto &camera = cluster_cameras[c][a];
+    cameras[node].focal = camera.focal;
+    Mat(transforms[c] * ToMatx(camera.R)).convertTo(cameras[node].R, CV_32F);
+  }
+  cv::detail::Graph span_tree;
+  std::vector<int> span_tree_centers;
+  cv::detail::findMaxSpanningTree(n, pairwise_matches, span_tree,
+                                  span_tree_centers);
+  Mat R_inv = cameras[span_tree_centers[0]].R.inv();
+  for (int i = 0; i < n; ++i) {
+    cameras[i].R = R_inv * cameras[i].R;
+  }
+  std::stringstream message;
+  message << "分块平差完成: " << cluster_count << " 块, "
+          << (cv::getTickCount() - start) / cv::getTickFrequency() << " s";
+  Report(message.str());
+  return true;
+}
+}  // namespace ImageStitch
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "../common/cvTypeDef.hpp"
+#include "sparseBundleAdjuster.hpp"
+
+namespace ImageStitch {
+
+/**
+ * @brief 分块光束平差。
+ * 按匹配图把图像划分为若干块，每块再向外扩展一层相邻图像，使相邻的块共享
+ * 部分图像；各块并行地做稀疏光束平差，再用共享图像求每块到全局的变换
+ * (线性最小二乘)，把各块的结果拼到同一坐标系下。
+ */
+class HierarchicalBundleAdjuster : public cv::detail::BundleAdjusterBase {
+ public:
+  using Reporter = std::function<void(const std::string &)>;
+
+ public:
+  /**
+   * @param model 块内平差的误差模型，支持AFFINE和RAY
+   * @param cluster_size 每块(扩展前)最多包含的图像数
+   * @param reporter 输出每块耗时等信息
+   */
+  HierarchicalBundleAdjuster(
+      SparseBundleAdjuster::Model model = SparseBundleAdjuster::AFFINE,
+      int cluster_size = 50, Reporter reporter = nullptr);
+  /**
+   * @brief 沿匹配图广度优先划分图像，返回每块包含的图像下标(互不重叠)。
+   */
+  static auto Partition(int num_images,
+                        const std::vector<MatchesInfo> &pairwise_matches,
+                        double conf_thresh, int cluster_size)
+      -> std::vector<std::vector<int>>;
+  inline const std::vector<double> &ClusterTimes() const {
+    return _cluster_times;
+  }
+
+ protected:
+  bool estimate(const std::vector<ImageFeatures> &features,
+                const std::vector<MatchesInfo> &pairwise_matches,
+                std::vector<CameraParams> &cameras) override;
+  void setUpInitialCameraParams(const std::vector<CameraParams> &) override {}
+  void obtainRefinedCameraParams(std::vector<CameraParams> &) const override {}
+  void calcError(Mat &) override {}
+  void calcJacobian(Mat &) override {}
+
+ private:
+  auto Report(const std::string &message) const -> void;
+
+ private:
+  SparseBundleAdjuster::Model _model;
+  int _cluster_size;
+  Reporter _reporter;
+  std::vector<double> _cluster_times;
+};
+}  // namespace ImageStitch
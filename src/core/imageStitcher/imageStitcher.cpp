@@ -4,11 +4,29 @@
 #include <math.h>
 #include <omp.h>
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <fstream>
 #include <functional>
+#include <map>
 #include <opencv2/features2d.hpp>
 #include <opencv2/xfeatures2d/nonfree.hpp>
 #include <sstream>
+#include <typeinfo>
+
+#include "../common/hash.hpp"
+#include "../common/imageCache.hpp"
+#include "../common/imageHandle.hpp"
+#include "../common/imageLoader.hpp"
+#include "../common/prefetchLoader.hpp"
+#include "divideRects.hpp"
+#include "fastGainCompensator.hpp"
+#include "hierarchicalBundleAdjuster.hpp"
+#include "parallelSeamFinder.hpp"
+#include "previewCanvas.hpp"
+#include "sharedFeatures.hpp"
+#include "sparseBundleAdjuster.hpp"
 
 namespace ImageStitch {
 
@@ -138,11 +156,46 @@ class EstimatorListener : public cv::detail::Estimator {
     if (_stitcher != nullptr) {
       _stitcher->signal_run_message("Estimating Image ", -1);
     }
+    std::vector<uint64_t> hashes;
+    if (WarmStartHashes(features, hashes)) {
+      // 所有图像都有保存的参数时跳过估计
+      cameras.assign(features.size(), cv::detail::CameraParams());
+      auto &store = _stitcher->GetCameraParamsStore();
+      if (store.WarmStart(hashes, cameras, !_stitcher->AffineModel()) ==
+          (int)features.size()) {
+        LOG(INFO) << "Estimate skipped, all cameras warm started";
+        return true;
+      }
+    }
     bool result = (*_estimator)(features, pairwise_matches, cameras);
+    if (result && !hashes.empty()) {
+      int count = _stitcher->GetCameraParamsStore().WarmStart(
+          hashes, cameras, !_stitcher->AffineModel());
+      LOG(INFO) << "Warm started " << count << "/" << cameras.size()
+                << " cameras";
+    }
     LOG(INFO) << "Estimate finished" << std::endl;
     return result;
   }
 
+ private:
+  bool WarmStartHashes(const std::vector<ImageFeatures> &features,
+                       std::vector<uint64_t> &hashes) const {
+    hashes.clear();
+    if (_stitcher == nullptr || !_stitcher->WarmStart()) {
+      return false;
+    }
+    const auto &image_hashes = _stitcher->ImageHashes();
+    for (const auto &feature : features) {
+      if (feature.img_idx < 0 || feature.img_idx >= image_hashes.size()) {
+        hashes.clear();
+        return false;
+      }
+      hashes.push_back(image_hashes[feature.img_idx]);
+    }
+    return true;
+  }
+
  private:
   cv::Ptr<cv::detail::Estimator> _estimator;
   ImageStitcher *_stitcher;
@@ -206,12 +259,30 @@ class WarperListener : public cv::detail::RotationWarper {
   }
   cv::Rect buildMaps(cv::Size src_size, cv::InputArray K, cv::InputArray R,
                      cv::OutputArray xmap, cv::OutputArray ymap) override {
-    return _warper->buildMaps(src_size, K, R, xmap, ymap);
+    // 调用方按浮点映射表使用结果，这里只走缓存，不转换为定点格式
+    if (!CacheEnabled()) {
+      return _warper->buildMaps(src_size, K, R, xmap, ymap);
+    }
+    auto entry = WarpMaps(src_size, K, R, false);
+    xmap.assign(entry.xmap);
+    ymap.assign(entry.ymap);
+    return entry.roi;
   }
   cv::Point warp(cv::InputArray src, cv::InputArray K, cv::InputArray R,
                  int interp_mode, int border_mode,
                  CV_OUT cv::OutputArray dst) override {
-    return _warper->warp(src, K, R, interp_mode, border_mode, dst);
+    if (!CacheEnabled()) {
+      return _warper->warp(src, K, R, interp_mode, border_mode, dst);
+    }
+    // 转换定点映射表本身有开销，只在映射表被缓存复用时使用
+    const bool fixed_point =
+        FixedPointEnabled() &&
+        RemapCache::FixedPointApplicable(src.depth(), interp_mode);
+    // 与RotationWarperBase::warp一致，只是映射表来自缓存或转换为定点格式
+    auto entry = WarpMaps(src.size(), K, R, fixed_point);
+    dst.create(entry.roi.height + 1, entry.roi.width + 1, src.type());
+    cv::remap(src, dst, entry.xmap, entry.ymap, interp_mode, border_mode);
+    return entry.roi.tl();
   }
   void warpBackward(cv::InputArray src, cv::InputArray K, cv::InputArray R,
                     int interp_mode, int border_mode, cv::Size dst_size,
@@ -219,6 +290,7 @@ class WarperListener : public cv::detail::RotationWarper {
     if (_stitcher != nullptr) {
       _stitcher->signal_run_message.notify("Warping", -1);
     }
+    // 反向投影不在拼接流程中，映射表不会复用，保持浮点映射
     _warper->warpBackward(src, K, R, interp_mode, border_mode, dst_size, dst);
     LOG(INFO) << "Warping backward finished";
   }
@@ -229,6 +301,40 @@ class WarperListener : public cv::detail::RotationWarper {
   float getScale() const { return _warper->getScale(); }
   void setScale(float scale) { _warper->setScale(scale); }
 
+ private:
+  bool CacheEnabled() const {
+    return _stitcher != nullptr && _stitcher->GetRemapCache().Enabled();
+  }
+  bool FixedPointEnabled() const {
+    return _stitcher != nullptr && _stitcher->FixedPointRemap();
+  }
+  RemapCache::Entry BuildWarpMaps(cv::Size src_size, cv::InputArray K,
+                                  cv::InputArray R, bool fixed_point) {
+    RemapCache::Entry entry;
+    entry.roi = _warper->buildMaps(src_size, K, R, entry.xmap, entry.ymap);
+    if (fixed_point) {
+      RemapCache::ToFixedPoint(entry);
+    }
+    return entry;
+  }
+  RemapCache::Entry WarpMaps(cv::Size src_size, cv::InputArray K,
+                             cv::InputArray R, bool fixed_point) {
+    if (!CacheEnabled()) {
+      return BuildWarpMaps(src_size, K, R, fixed_point);
+    }
+    auto &cache = _stitcher->GetRemapCache();
+    auto key = RemapCache::MakeKey(
+        src_size, K, R,
+        std::string(typeid(*_warper).name()) + (fixed_point ? "/16SC2" : ""),
+        _warper->getScale());
+    RemapCache::Entry entry;
+    if (!cache.Find(key, entry)) {
+      entry = BuildWarpMaps(src_size, K, R, fixed_point);
+      cache.Insert(key, entry);
+    }
+    return entry;
+  }
+
  private:
   cv::Ptr<cv::detail::RotationWarper> _warper;
   ImageStitcher *_stitcher;
@@ -267,6 +373,16 @@ class BundleAdjusterListener : public cv::detail::BundleAdjusterBase {
     if (_stitcher != nullptr) {
       _stitcher->FinalCameraParams() = cameras;
     }
+    if (result && _stitcher != nullptr && _stitcher->WarmStart()) {
+      const auto &image_hashes = _stitcher->ImageHashes();
+      for (size_t i = 0; i < features.size(); ++i) {
+        if (features[i].img_idx >= 0 &&
+            features[i].img_idx < image_hashes.size()) {
+          _stitcher->GetCameraParamsStore().Set(
+              image_hashes[features[i].img_idx], cameras[i]);
+        }
+      }
+    }
     LOG(INFO) << "Bundle adjuster finished";
     return result;
   }
@@ -290,10 +406,21 @@ class BlenderListener : public cv::detail::Blender {
   void prepare(const std::vector<cv::Point> &corners,
                const std::vector<cv::Size> &sizes) override {
     _blender->prepare(corners, sizes);
+    PreparePreview(cv::detail::resultRoi(corners, sizes));
+  }
+  void prepare(cv::Rect dst_roi) override {
+    _blender->prepare(dst_roi);
+    PreparePreview(dst_roi);
   }
-  void prepare(cv::Rect dst_roi) override { _blender->prepare(dst_roi); }
   void feed(cv::InputArray img, cv::InputArray mask, cv::Point tl) override {
     _blender->feed(img, mask, tl);
+    // cv::Stitcher串行送入各图像，可以直接发出信号
+    if (_preview_enabled) {
+      _preview.Feed(img, mask, tl);
+      if (_preview.Due()) {
+        _stitcher->signal_preview(_preview.Preview());
+      }
+    }
   }
   void blend(cv::InputOutputArray dst, cv::InputOutputArray dst_mask) override {
     if (_stitcher != nullptr) {
@@ -303,9 +430,20 @@ class BlenderListener : public cv::detail::Blender {
     LOG(INFO) << "Blender finished";
   }
 
+ private:
+  void PreparePreview(const cv::Rect &dst_roi) {
+    _preview_enabled =
+        _stitcher != nullptr && !_stitcher->signal_preview.empty();
+    if (_preview_enabled) {
+      _preview.Prepare(dst_roi);
+    }
+  }
+
  private:
   cv::Ptr<cv::detail::Blender> _blender;
   ImageStitcher *_stitcher;
+  PreviewCanvas _preview;
+  bool _preview_enabled = false;
 };
 
 class SeamFinderListener : public cv::detail::SeamFinder {
@@ -319,7 +457,11 @@ class SeamFinderListener : public cv::detail::SeamFinder {
     if (_stitcher != nullptr) {
       _stitcher->signal_run_message.notify("Seam finding", -1);
     }
-    _seam_finder->find(src, corners, masks);
+    if (_stitcher != nullptr && _stitcher->IncrementalSeam()) {
+      IncrementalFind(src, corners, masks);
+    } else {
+      _seam_finder->find(src, corners, masks);
+    }
     if (_stitcher != nullptr) {
       for (int i = 0; i < masks.size(); ++i) {
         cv::Mat img, dst;
@@ -330,6 +472,28 @@ class SeamFinderListener : public cv::detail::SeamFinder {
     }
   }
 
+ private:
+  void IncrementalFind(const std::vector<cv::UMat> &src,
+                       const std::vector<cv::Point> &corners,
+                       std::vector<cv::UMat> &masks) {
+    auto &cache = _stitcher->GetSeamCache();
+    std::vector<uint64_t> hashes(src.size());
+#pragma omp parallel for
+    for (int i = 0; i < src.size(); ++i) {
+      hashes[i] = HashImage(src[i].getMat(cv::ACCESS_READ));
+      hashes[i] = HashImage(masks[i].getMat(cv::ACCESS_READ), hashes[i]);
+    }
+    std::vector<int> changed;
+    // 超过一半的图像变化时局部重算不再划算
+    if (cache.ChangedImages(hashes, corners, changed) &&
+        changed.size() * 2 <= src.size()) {
+      cache.Refind(*_seam_finder, src, corners, masks, changed);
+    } else {
+      _seam_finder->find(src, corners, masks);
+    }
+    cache.Update(hashes, corners, masks);
+  }
+
  private:
   cv::Ptr<cv::detail::SeamFinder> _seam_finder;
   ImageStitcher *_stitcher;
@@ -390,7 +554,23 @@ class FeatureDetectorListener : public cv::FeatureDetector {
     if (_stitcher != nullptr) {
       _stitcher->signal_run_message("Feature detector detecting", -1);
     }
-    _feature_detector->detect(images, keypoints, masks);
+    if (SharedDetect(images, keypoints, masks)) {
+      LOG(INFO) << "Feature detector detected on source images";
+      return;
+    }
+    if (PrefetchedDetect(images, keypoints, masks)) {
+      LOG(INFO) << "Feature detector reused prefetched features";
+      return;
+    }
+    // 各图像(切割后的条带)之间互不依赖，逐张并行提取
+    const int n = images.total();
+    const bool has_masks = !masks.empty();
+    keypoints.resize(n);
+#pragma omp parallel for schedule(dynamic)
+    for (int i = 0; i < n; ++i) {
+      _feature_detector->detect(images.getMat(i), keypoints[i],
+                                has_masks ? masks.getMat(i) : Mat());
+    }
     LOG(INFO) << "Feature detector detected";
   }
   void compute(cv::InputArray image, std::vector<KeyPoint> &keypoints,
@@ -407,7 +587,29 @@ class FeatureDetectorListener : public cv::FeatureDetector {
     if (_stitcher != nullptr) {
       _stitcher->signal_run_message("Feature detector computing", -1);
     }
-    _feature_detector->compute(images, keypoints, descriptors);
+    const int n = images.total();
+    CV_Assert(keypoints.size() == (size_t)n);
+    if (UseSharedDescriptors(keypoints, descriptors)) {
+      LOG(INFO) << "Feature detector reused shared descriptors";
+      return;
+    }
+    if (descriptors.isUMatVector()) {
+      auto &umats = *(std::vector<cv::UMat> *)descriptors.getObj();
+      umats.resize(n);
+#pragma omp parallel for schedule(dynamic)
+      for (int i = 0; i < n; ++i) {
+        _feature_detector->compute(images.getUMat(i), keypoints[i], umats[i]);
+      }
+    } else if (descriptors.isMatVector()) {
+      auto &mats = *(std::vector<Mat> *)descriptors.getObj();
+      mats.resize(n);
+#pragma omp parallel for schedule(dynamic)
+      for (int i = 0; i < n; ++i) {
+        _feature_detector->compute(images.getMat(i), keypoints[i], mats[i]);
+      }
+    } else {
+      _feature_detector->compute(images, keypoints, descriptors);
+    }
     LOG(INFO) << "Feature detector computed";
   }
   void detectAndCompute(cv::InputArray image, cv::InputArray mask,
@@ -425,9 +627,137 @@ class FeatureDetectorListener : public cv::FeatureDetector {
     }
   }
 
+ private:
+  /**
+   * @brief
+   * 输入为切割得到的条带时，每张原图只在缩放到条带尺度后提取一次特征，再按坐标
+   * 分配给各个条带，重叠区域不再重复提取。描述子暂存起来供随后的compute使用。
+   * 有特征数量上限的检测器按条带数放大上限，无法确定上限的检测器不共享。
+   */
+  auto SharedDetect(cv::InputArrayOfArrays images,
+                    std::vector<std::vector<KeyPoint>> &keypoints,
+                    cv::InputArrayOfArrays masks) -> bool {
+    _shared_keypoints.clear();
+    _shared_descriptors.clear();
+    if (_stitcher == nullptr || !masks.empty()) {
+      return false;
+    }
+    const auto &layout = _stitcher->DivideLayout();
+    const int n = images.total();
+    if (n == 0 || layout.size() != (size_t)n) {
+      return false;
+    }
+    std::map<int, std::vector<int>> groups;
+    for (int i = 0; i < n; ++i) {
+      groups[layout[i].first].push_back(i);
+    }
+    std::vector<int> sources;
+    for (const auto &[source, strips] : groups) {
+      if (SharedFeatureDetector(_feature_detector, strips.size()).empty()) {
+        return false;
+      }
+      sources.push_back(source);
+    }
+    keypoints.assign(n, std::vector<KeyPoint>());
+    std::vector<Mat> descriptors(n);
+#pragma omp parallel for schedule(dynamic)
+    for (int s = 0; s < sources.size(); ++s) {
+      const auto &strips = groups.at(sources[s]);
+      auto source = _stitcher->DivideSources()[sources[s]];
+      // 同一张原图的条带缩放系数相同，由条带的实际尺寸反推
+      const auto &first_rect = layout[strips[0]].second;
+      const cv::Size first_size = images.size(strips[0]);
+      const double sx = double(first_size.width) / first_rect.width;
+      const double sy = double(first_size.height) / first_rect.height;
+      Image scaled;
+      cv::resize(*source, scaled,
+                 cv::Size(cvRound(source->cols * sx),
+                          cvRound(source->rows * sy)),
+                 0, 0, cv::INTER_LINEAR_EXACT);
+      std::vector<KeyPoint> source_keypoints;
+      Mat source_descriptors;
+      SharedFeatureDetector(_feature_detector, strips.size())
+          ->detectAndCompute(scaled, cv::noArray(), source_keypoints,
+                             source_descriptors);
+      std::vector<cv::Rect2f> areas;
+      for (int i : strips) {
+        const auto &rect = layout[i].second;
+        const cv::Size size = images.size(i);
+        areas.emplace_back(float(rect.x * sx), float(rect.y * sy),
+                           float(size.width), float(size.height));
+      }
+      std::vector<KeyPoints> strip_keypoints;
+      std::vector<Mat> strip_descriptors;
+      SplitFeatures(source_keypoints, source_descriptors, areas,
+                    strip_keypoints, strip_descriptors);
+      for (size_t k = 0; k < strips.size(); ++k) {
+        keypoints[strips[k]] = strip_keypoints[k];
+        descriptors[strips[k]] = strip_descriptors[k];
+      }
+    }
+    _shared_keypoints = keypoints;
+    _shared_descriptors = descriptors;
+    return true;
+  }
+  /**
+   * @brief 加载图像时已经在相同的配准尺度下提取过特征，直接复用
+   */
+  auto PrefetchedDetect(cv::InputArrayOfArrays images,
+                        std::vector<std::vector<KeyPoint>> &keypoints,
+                        cv::InputArrayOfArrays masks) -> bool {
+    if (_stitcher == nullptr || !masks.empty()) {
+      return false;
+    }
+    const auto &prefetched = _stitcher->PrefetchedFeatures();
+    const int n = images.total();
+    if (n == 0 || prefetched.size() != (size_t)n) {
+      return false;
+    }
+    for (int i = 0; i < n; ++i) {
+      if (prefetched[i].img_size != images.size(i)) {
+        return false;
+      }
+    }
+    keypoints.resize(n);
+    _shared_descriptors.resize(n);
+    for (int i = 0; i < n; ++i) {
+      keypoints[i] = prefetched[i].keypoints;
+      prefetched[i].descriptors.copyTo(_shared_descriptors[i]);
+    }
+    _shared_keypoints = keypoints;
+    return true;
+  }
+  auto UseSharedDescriptors(
+      const std::vector<std::vector<KeyPoint>> &keypoints,
+      cv::OutputArrayOfArrays descriptors) -> bool {
+    bool matched = _shared_keypoints.size() == keypoints.size() &&
+                   (descriptors.isUMatVector() || descriptors.isMatVector());
+    for (size_t i = 0; matched && i < keypoints.size(); ++i) {
+      matched = _shared_keypoints[i].size() == keypoints[i].size();
+    }
+    if (matched) {
+      const int n = keypoints.size();
+      if (descriptors.isUMatVector()) {
+        auto &umats = *(std::vector<cv::UMat> *)descriptors.getObj();
+        umats.resize(n);
+        for (int i = 0; i < n; ++i) {
+          _shared_descriptors[i].copyTo(umats[i]);
+        }
+      } else {
+        auto &mats = *(std::vector<Mat> *)descriptors.getObj();
+        mats = _shared_descriptors;
+      }
+    }
+    _shared_keypoints.clear();
+    _shared_descriptors.clear();
+    return matched;
+  }
+
  private:
   cv::Ptr<cv::FeatureDetector> _feature_detector;
   ImageStitcher *_stitcher;
+  std::vector<std::vector<KeyPoint>> _shared_keypoints;
+  std::vector<Mat> _shared_descriptors;
 };
 
 static void init() {
@@ -642,6 +972,54 @@ static void init() {
         return new BundleAdjusterListener(
             cv::makePtr<cv::detail::BundleAdjusterAffinePartial>(), stitcher);
       });
+  RegisterOptionIntoConfig(
+      "BundleAdjuster", "SparseBundleAdjusterAffine",
+      +[](ImageStitcher *stitcher) -> cv::Ptr<cv::detail::BundleAdjusterBase> {
+        return new BundleAdjusterListener(
+            cv::makePtr<SparseBundleAdjuster>(SparseBundleAdjuster::AFFINE),
+            stitcher);
+      });
+  RegisterOptionIntoConfig(
+      "BundleAdjuster", "SparseBundleAdjusterAffinePartial",
+      +[](ImageStitcher *stitcher) -> cv::Ptr<cv::detail::BundleAdjusterBase> {
+        return new BundleAdjusterListener(
+            cv::makePtr<SparseBundleAdjuster>(
+                SparseBundleAdjuster::AFFINE_PARTIAL),
+            stitcher);
+      });
+  RegisterOptionIntoConfig(
+      "BundleAdjuster", "SparseBundleAdjusterRay",
+      +[](ImageStitcher *stitcher) -> cv::Ptr<cv::detail::BundleAdjusterBase> {
+        return new BundleAdjusterListener(
+            cv::makePtr<SparseBundleAdjuster>(SparseBundleAdjuster::RAY),
+            stitcher);
+      });
+  RegisterOptionIntoConfig(
+      "BundleAdjuster", "HierarchicalBundleAdjusterAffine",
+      +[](ImageStitcher *stitcher) -> cv::Ptr<cv::detail::BundleAdjusterBase> {
+        return new BundleAdjusterListener(
+            cv::makePtr<HierarchicalBundleAdjuster>(
+                SparseBundleAdjuster::AFFINE, 50,
+                [stitcher](const std::string &message) {
+                  if (stitcher != nullptr) {
+                    stitcher->signal_run_message.notify(message, -1);
+                  }
+                }),
+            stitcher);
+      });
+  RegisterOptionIntoConfig(
+      "BundleAdjuster", "HierarchicalBundleAdjusterRay",
+      +[](ImageStitcher *stitcher) -> cv::Ptr<cv::detail::BundleAdjusterBase> {
+        return new BundleAdjusterListener(
+            cv::makePtr<HierarchicalBundleAdjuster>(
+                SparseBundleAdjuster::RAY, 50,
+                [stitcher](const std::string &message) {
+                  if (stitcher != nullptr) {
+                    stitcher->signal_run_message.notify(message, -1);
+                  }
+                }),
+            stitcher);
+      });
 
   CreateConfigItem("Blender", ConfigItem::STRING,
                    "图像融合器，用于将拼接后的图像进行融合，"
@@ -696,6 +1074,27 @@ static void init() {
         return new SeamFinderListener(
             cv::makePtr<cv::detail::GraphCutSeamFinder>(), stitcher);
       });
+  RegisterOptionIntoConfig(
+      "SeamFinder", "ParallelGraphCutSeamFinder",
+      +[](ImageStitcher *stitcher) -> cv::Ptr<cv::detail::SeamFinder> {
+        return new SeamFinderListener(
+            cv::makePtr<ParallelPairwiseSeamFinder>(
+                []() -> cv::Ptr<cv::detail::SeamFinder> {
+                  return cv::makePtr<cv::detail::GraphCutSeamFinder>();
+                }),
+            stitcher);
+      });
+  RegisterOptionIntoConfig(
+      "SeamFinder", "ParallelDpSeamFinder",
+      +[](ImageStitcher *stitcher) -> cv::Ptr<cv::detail::SeamFinder> {
+        return new SeamFinderListener(
+            cv::makePtr<ParallelPairwiseSeamFinder>(
+                []() -> cv::Ptr<cv::detail::SeamFinder> {
+                  return cv::makePtr<cv::detail::DpSeamFinder>();
+                },
+                ParallelPairwiseSeamFinder::DP),
+            stitcher);
+      });
 
   CreateConfigItem(
       "ExposureCompensator", ConfigItem::STRING,
@@ -731,6 +1130,18 @@ static void init() {
         return new ExporterListener(
             cv::makePtr<cv::detail::BlocksChannelsCompensator>(), stitcher);
       });
+  RegisterOptionIntoConfig(
+      "ExposureCompensator", "FastGainCompensator",
+      +[](ImageStitcher *stitcher) -> cv::Ptr<cv::detail::ExposureCompensator> {
+        return new ExporterListener(cv::makePtr<FastGainCompensator>(),
+                                    stitcher);
+      });
+  RegisterOptionIntoConfig(
+      "ExposureCompensator", "FastBlocksGainCompensator",
+      +[](ImageStitcher *stitcher) -> cv::Ptr<cv::detail::ExposureCompensator> {
+        return new ExporterListener(
+            cv::makePtr<FastGainCompensator>(32, 32, 0.5), stitcher);
+      });
 
   CreateConfigItem("InterpolationFlags", ConfigItem::STRING,
                    "插值方式，用于图像缩放和旋转时的像素插值，"
@@ -780,14 +1191,102 @@ static void init() {
                    "图像参数估计和标定优化的阈值，建议值为1");
   RegisterOptionIntoConfig("PanoConfidenceThresh", 0.0, 1e10);
 
+  CreateConfigItem(
+      "RemapCacheLimit", ConfigItem::FLOAT,
+      "投影映射表缓存的内存上限(MB)，相机几何不变时重复拼接会直接复用缓存的"
+      "映射表而不再重新计算投影，小于等于零则不使用缓存。");
+  RegisterOptionIntoConfig("RemapCacheLimit", 0.0, 1e6);
+
+  CreateConfigItem("FixedPointRemap", ConfigItem::STRING,
+                   "投影8位图像时把浮点映射表转换为CV_16SC2定点格式，减少投影"
+                   "阶段的内存带宽和插值开销，线性插值的精度损失在1/32像素以内。"
+                   "转换本身有开销，只在映射表缓存开启或固定机位模式下生效；"
+                   "最近邻插值和掩码投影仍使用浮点映射表。");
+  RegisterOptionIntoConfig(
+      "FixedPointRemap", "NO", +[]() -> int { return 0; });
+  RegisterOptionIntoConfig(
+      "FixedPointRemap", "YES", +[]() -> int { return 1; });
+
+  CreateConfigItem("IncrementalSeam", ConfigItem::STRING,
+                   "缓存每张图像的拼接缝掩码，再次拼接时只对内容或位置变化的图"
+                   "像及其重叠的图像对重新查找拼接缝，其余掩码直接复用。");
+  RegisterOptionIntoConfig(
+      "IncrementalSeam", "NO", +[]() -> int { return 0; });
+  RegisterOptionIntoConfig(
+      "IncrementalSeam", "YES", +[]() -> int { return 1; });
+
+  CreateConfigItem("WarmStart", ConfigItem::STRING,
+                   "按图像内容哈希保存光束平差后的相机参数(CameraParamsFile)，"
+                   "再次拼接时未变化的图像直接以保存的参数作为初值，全部未变化"
+                   "时跳过参数估计；只有部分图像未变化时仍完整估计，再把保存的"
+                   "参数对齐到估计结果作为平差的初值。保存的参数与配准分辨率和"
+                   "估计器、平差器、投影模型绑定，修改后不会复用。");
+  RegisterOptionIntoConfig(
+      "WarmStart", "NO", +[]() -> int { return 0; });
+  RegisterOptionIntoConfig(
+      "WarmStart", "YES", +[]() -> int { return 1; });
+
+  CreateConfigItem("SplitComponents", ConfigItem::STRING,
+                   "匹配图包含多个互不连通的部分时，分别并行拼接每一部分，每部"
+                   "分输出一张全景图，而不是只保留最大的部分。中间数据只展示"
+                   "图像最多的部分的相机参数。");
+  RegisterOptionIntoConfig(
+      "SplitComponents", "NO", +[]() -> int { return 0; });
+  RegisterOptionIntoConfig(
+      "SplitComponents", "YES", +[]() -> int { return 1; });
+
+  CreateConfigItem("RigMode", ConfigItem::STRING,
+                   "固定机位模式，CALIBRATE会完整拼接一次并记录相机参数、投影映"
+                   "射表、拼接缝和曝光增益，APPLY则直接使用记录的结果投影融合新"
+                   "的帧组，跳过特征提取、匹配和参数估计。APPLY时没有已标定或"
+                   "可从RigFile加载的结果则拼接失败。");
+  RegisterOptionIntoConfig(
+      "RigMode", "NO", +[]() -> int { return 0; });
+  RegisterOptionIntoConfig(
+      "RigMode", "CALIBRATE", +[]() -> int { return 1; });
+  RegisterOptionIntoConfig(
+      "RigMode", "APPLY", +[]() -> int { return 2; });
+
   CreateConfigItem("DivideImage", ConfigItem::STRING,
-                   "是否对图像进行带重叠的切割以提高拼接成功的概率");
+                   "是否对图像进行带重叠的切割以提高拼接成功的概率，条带数量和"
+                   "重叠比例由DivideCount和DivideOverlap指定");
   RegisterOptionIntoConfig(
       "DivideImage", "NO", +[]() -> int { return 0; });
   RegisterOptionIntoConfig(
       "DivideImage", "ROW", +[]() -> int { return 1; });
   RegisterOptionIntoConfig(
       "DivideImage", "COL", +[]() -> int { return 2; });
+
+  CreateConfigItem("PrefetchCount", ConfigItem::INT,
+                   "从文件加载图像时后台预先解码的图像数量，解码与特征提取同时"
+                   "进行，为0时先解码全部图像再拼接。");
+  RegisterOptionIntoConfig("PrefetchCount", 0, 64);
+
+  CreateConfigItem("DivideCount", ConfigItem::INT,
+                   "切割图像时每张图像的条带数量，建议值为3。条带等长且均匀分布，"
+                   "默认3条、重叠0.5时起点为0、1/4、1/2，与旧版固定的0、1/3、"
+                   "1/2不同，旧配置的切割结果会改变。");
+  RegisterOptionIntoConfig("DivideCount", 2, 64);
+
+  CreateConfigItem("DivideOverlap", ConfigItem::FLOAT,
+                   "切割图像时相邻条带重叠部分占条带长度的比例，建议值为0.5");
+  RegisterOptionIntoConfig("DivideOverlap", 0.0, 0.9);
+}
+
+double ResolScale(const double resol, const cv::Size &size) {
+  return (std::min)(1.0, std::sqrt(resol * 1e6 / size.area()));
+}
+
+double MedianFocal(const std::vector<CameraParams> &cameras) {
+  std::vector<double> focals;
+  for (const auto &camera : cameras) {
+    focals.push_back(camera.focal);
+  }
+  std::sort(focals.begin(), focals.end());
+  if (focals.size() % 2 == 1) {
+    return focals[focals.size() / 2];
+  }
+  return (focals[focals.size() / 2 - 1] + focals[focals.size() / 2]) * 0.5;
 }
 
 }  // namespace
@@ -804,6 +1303,7 @@ auto ImageStitcher::SetParams(const Parameters &params) -> void {
   if (!params.Empty()) {
     _params = params;
   }
+  _prefetched_features.clear();
   // LOG(INFO) << _params.ToString();
   _cv_stitcher.release();
   // 拼接模式
@@ -930,12 +1430,93 @@ auto ImageStitcher::SetParams(const Parameters &params) -> void {
   LOG(INFO) << "PanoConfidenceThresh : " << conf_thresh;
   _cv_stitcher->setPanoConfidenceThresh(conf_thresh);
 
+  auto remap_cache_limit = _params.GetParam("RemapCacheLimit", (float)0.0);
+  LOG(INFO) << "RemapCacheLimit : " << remap_cache_limit;
+  _remap_cache.SetMemoryLimit(
+      remap_cache_limit > 0 ? (size_t)(remap_cache_limit * 1024 * 1024) : 0);
+  _remap_cache_file = _params.GetParam("RemapCacheFile", std::string());
+  if (!_remap_cache_file.empty() && _remap_cache.Size() == 0 &&
+      std::filesystem::exists(_remap_cache_file)) {
+    _remap_cache.Load(_remap_cache_file);
+  }
+
+  _fixed_point_remap = false;
+  auto fixed_point_remap_name =
+      "FixedPointRemap." +
+      _params.GetParam("FixedPointRemap", std::string("NO"));
+  if (ALL_CONFIGS.find(fixed_point_remap_name) != ALL_CONFIGS.end()) {
+    LOG(INFO) << "FixedPointRemap : " << fixed_point_remap_name;
+    _fixed_point_remap =
+        ALL_CONFIGS.at(fixed_point_remap_name)->call<int>() != 0;
+  }
+
+  _incremental_seam = false;
+  auto incremental_seam_name =
+      "IncrementalSeam." +
+      _params.GetParam("IncrementalSeam", std::string("NO"));
+  if (ALL_CONFIGS.find(incremental_seam_name) != ALL_CONFIGS.end()) {
+    LOG(INFO) << "IncrementalSeam : " << incremental_seam_name;
+    _incremental_seam = ALL_CONFIGS.at(incremental_seam_name)->call<int>() != 0;
+  }
+
+  _warm_start = false;
+  auto warm_start_name =
+      "WarmStart." + _params.GetParam("WarmStart", std::string("NO"));
+  if (ALL_CONFIGS.find(warm_start_name) != ALL_CONFIGS.end()) {
+    LOG(INFO) << "WarmStart : " << warm_start_name;
+    _warm_start = ALL_CONFIGS.at(warm_start_name)->call<int>() != 0;
+  }
+  _camera_params_file = _params.GetParam("CameraParamsFile", std::string());
+  if (_warm_start && !_camera_params_file.empty() &&
+      _camera_params_store.Size() == 0 &&
+      std::filesystem::exists(_camera_params_file)) {
+    _camera_params_store.Load(_camera_params_file);
+  }
+
+  // 仿射模型的相机参数R不是旋转矩阵，热启动对齐时不能投影为旋转
+  _affine_model =
+      _params.GetParam("Estimator", std::string()) == "AffineBasedEstimator" ||
+      _params.GetParam("BundleAdjuster", std::string()).find("Affine") !=
+          std::string::npos;
+
+  _split_components = false;
+  auto split_components_name =
+      "SplitComponents." +
+      _params.GetParam("SplitComponents", std::string("NO"));
+  if (ALL_CONFIGS.find(split_components_name) != ALL_CONFIGS.end()) {
+    LOG(INFO) << "SplitComponents : " << split_components_name;
+    _split_components =
+        ALL_CONFIGS.at(split_components_name)->call<int>() != 0;
+  }
+
+  _rig_mode = RigMode::RIG_NONE;
+  auto rig_mode_name =
+      "RigMode." + _params.GetParam("RigMode", std::string("NO"));
+  if (ALL_CONFIGS.find(rig_mode_name) != ALL_CONFIGS.end()) {
+    LOG(INFO) << "RigMode : " << rig_mode_name;
+    _rig_mode = (RigMode)ALL_CONFIGS.at(rig_mode_name)->call<int>();
+  }
+  _rig_file = _params.GetParam("RigFile", std::string());
+  if (_rig_mode == RigMode::RIG_APPLY && !_rig.Valid() && !_rig_file.empty() &&
+      std::filesystem::exists(_rig_file)) {
+    LoadRig(_rig_file);
+  }
+
   auto divide_image_name =
       "DivideImage." + _params.GetParam("DivideImage", std::string("NO"));
   if (ALL_CONFIGS.find(divide_image_name) != ALL_CONFIGS.end()) {
     LOG(INFO) << "DivideImage : " << divide_image_name;
     _divide_images = ALL_CONFIGS.at(divide_image_name)->call<int>();
   }
+  _prefetch_count = (std::max)(0, _params.GetParam("PrefetchCount", 4));
+  LOG(INFO) << "PrefetchCount : " << _prefetch_count;
+
+  _divide_count = (std::max)(2, _params.GetParam("DivideCount", 3));
+  _divide_overlap = (std::min)(
+      0.9, (std::max)(0.0, (double)_params.GetParam("DivideOverlap",
+                                                     (float)0.5)));
+  LOG(INFO) << "DivideCount : " << _divide_count
+            << ", DivideOverlap : " << _divide_overlap;
 
   signal_run_message("配置成功.", 1000);
 }
@@ -947,10 +1528,19 @@ ImageStitcher::ImageStitcher() {
     _params.FromString(
         "{"
         "\"CompositingResol\": {\"value\": -1.0},"
+        "\"DivideCount\": {\"value\": 3},"
         "\"DivideImage\": {\"value\": \"NO\"},"
+        "\"DivideOverlap\": {\"value\": 0.5},"
+        "\"FixedPointRemap\": {\"value\": \"NO\"},"
+        "\"IncrementalSeam\": {\"value\": \"NO\"},"
         "\"PanoConfidenceThresh\": {\"value\": 1.0},"
+        "\"PrefetchCount\": {\"value\": 4},"
         "\"RegistrationResol\": {\"value\": 0.6},"
+        "\"RemapCacheLimit\": {\"value\": 0.0},"
+        "\"RigMode\": {\"value\": \"NO\"},"
         "\"SeamEstimationResol\": {\"value\": 0.1},"
+        "\"SplitComponents\": {\"value\": \"NO\"},"
+        "\"WarmStart\": {\"value\": \"NO\"},"
         "\"Blender\": {\"value\": \"MultiBandBlender\"},"
         "\"BundleAdjuster\": {\"value\": \"BundleAdjusterAffine\"},"
         "\"Estimator\": {\"value\": \"AffineBasedEstimator\"},"
@@ -977,6 +1567,12 @@ auto ImageStitcher::Clean() -> bool {
   _camera_params.clear();
   _regist_scales.clear();
   _comp.clear();
+  _remap_cache.Clear();
+  _rig.Clear();
+  _seam_cache.Clear();
+  _camera_params_store.Clear();
+  _image_hashes.clear();
+  _prefetched_features.clear();
   _cv_stitcher.release();
 
   return true;
@@ -984,23 +1580,161 @@ auto ImageStitcher::Clean() -> bool {
 
 auto ImageStitcher::SetImages(std::vector<ImagePtr> images) -> bool {
   _images.clear();
-  _images = images;
+  _prefetched_features.clear();
+  for (const auto &image : images) {
+    _images.push_back(std::make_shared<ImageHandle>(image));
+  }
   return true;
 }
 
 auto ImageStitcher::SetImages(std::vector<std::string> image_files) -> bool {
-  _images.resize(image_files.size());
+  _images.clear();
+  _prefetched_features.clear();
+  if (image_files.empty()) {
+    return true;
+  }
+  // 需要全分辨率融合时只解码预览图，原图在融合时再按需解码；
+  // 融合分辨率受限时，只需解码出不小于各阶段所需面积的图像
+  double preview_scale = 1.0;
+  cv::Size first_size;
+  if (LazyImagesEnabled() && ReadImageFileSize(image_files[0], first_size)) {
+    preview_scale = ResolScale(
+        (std::max)(_cv_stitcher->registrationResol(),
+                   _cv_stitcher->seamEstimationResol()),
+        first_size);
+  }
+  const double megapix = RequiredMegapix();
+  auto load = [&image_files, preview_scale, megapix](int i) -> ImageHandlePtr {
+    // 界面或上一次拼接已经解码过的图像直接共享，不再重复解码
+    Image cached;
+    if (ImageCache::Instance().Find(image_files[i], cached)) {
+      return std::make_shared<ImageHandle>(ImagePtr(new Image(cached)),
+                                           preview_scale);
+    }
+    if (preview_scale < 1.0) {
+      return ImageHandle::Open(image_files[i], preview_scale);
+    }
+    // 全分辨率解码的结果放入缓存，调整参数后重新拼接同一组图像时不必再解码，
+    // 缓存按字节数淘汰，常驻内存不超过上限；缩小解码的图像不是原图，不放入缓存
+    if (megapix < 0) {
+      return std::make_shared<ImageHandle>(
+          ImagePtr(new Image(ImageCache::Instance().Load(image_files[i]))));
+    }
+    return std::make_shared<ImageHandle>(
+        ImagePtr(new Image(DecodeImageFile(image_files[i], megapix))));
+  };
+  if (_prefetch_count <= 0 || _cv_stitcher.empty()) {
+    std::vector<ImageHandlePtr> handles(image_files.size());
 #pragma omp parallel for
+    for (int i = 0; i < image_files.size(); ++i) {
+      handles[i] = load(i);
+    }
+    for (int i = 0; i < handles.size(); ++i) {
+      if (handles[i] == nullptr || handles[i]->Preview()->empty()) {
+        LOG(WARNING) << "Couldn't load image : " << image_files[i];
+        continue;
+      }
+      _images.push_back(handles[i]);
+    }
+    return true;
+  }
+
+  // 后台预取后续图像的同时，每凑满一批就按cv::Stitcher的配准尺度并行提取特征，
+  // 提取期间预取线程继续加载后续图像
+  PrefetchLoader loader(image_files.size(), load, _prefetch_count,
+                        (std::min)(_prefetch_count,
+                                   (int)std::thread::hardware_concurrency()));
+#ifdef _OPENMP
+  const int batch = (std::max)(1, omp_get_max_threads());
+#else
+  const int batch = 1;
+#endif
+  // 全部提取完才写入_prefetched_features，否则提取下一批时会被当作预取结果复用
+  std::vector<ImageFeatures> prefetched;
+  std::vector<Image> work_images;
+  auto detect_batch = [&]() {
+    if (work_images.empty()) {
+      return;
+    }
+    // 与cv::Stitcher相同，先detect再compute
+    std::vector<KeyPoints> keypoints;
+    std::vector<cv::UMat> descriptors;
+    _cv_stitcher->featuresFinder()->detect(work_images, keypoints);
+    _cv_stitcher->featuresFinder()->compute(work_images, keypoints,
+                                            descriptors);
+    for (int k = 0; k < work_images.size(); ++k) {
+      ImageFeatures features;
+      features.img_idx = prefetched.size();
+      features.img_size = work_images[k].size();
+      features.keypoints = std::move(keypoints[k]);
+      features.descriptors = descriptors[k];
+      prefetched.push_back(std::move(features));
+    }
+    work_images.clear();
+    signal_run_progress(0.3f * prefetched.size() / image_files.size());
+  };
+  double work_scale = -1;
+  bool prefetch_valid = true;
   for (int i = 0; i < image_files.size(); ++i) {
-    std::ifstream file;
-    file.open(image_files[i], std::ios::binary);
-    std::vector<uchar> buffer((std::istreambuf_iterator<char>(file)),
-                              std::istreambuf_iterator<char>());
-    _images[i] = new Image(cv::imdecode(buffer, cv::IMREAD_COLOR));
+    auto handle = loader.Take(i);
+    if (handle == nullptr || handle->Preview()->empty()) {
+      LOG(WARNING) << "Couldn't load image : " << image_files[i];
+      prefetch_valid = false;
+      continue;
+    }
+    _images.push_back(handle);
+    if (!prefetch_valid) {
+      continue;
+    }
+    const Image &image = *handle->Preview();
+    if (work_scale < 0) {
+      work_scale = _cv_stitcher->registrationResol() < 0
+                       ? 1.0
+                       : ResolScale(_cv_stitcher->registrationResol(),
+                                    image.size());
+    }
+    Image work_image;
+    if (_cv_stitcher->registrationResol() < 0) {
+      work_image = image;
+    } else {
+      cv::resize(image, work_image, cv::Size(), work_scale, work_scale,
+                 cv::INTER_LINEAR_EXACT);
+    }
+    work_images.push_back(work_image);
+    if (work_images.size() >= batch) {
+      detect_batch();
+    }
+  }
+  // 有图像加载失败时下标对不上，放弃预取的特征
+  if (prefetch_valid) {
+    detect_batch();
+    _prefetched_features = std::move(prefetched);
   }
   return true;
 }
 
+auto ImageStitcher::LazyImagesEnabled() const -> bool {
+  return !_cv_stitcher.empty() && RequiredMegapix() < 0 &&
+         _cv_stitcher->registrationResol() > 0 && _mode == Mode::ALL &&
+         _divide_images == 0 && !_split_components &&
+         _rig_mode == RigMode::RIG_NONE;
+}
+
+auto ImageStitcher::RequiredMegapix() const -> double {
+  if (_cv_stitcher.empty() || _cv_stitcher->compositingResol() <= 0) {
+    return -1;
+  }
+  double megapix = (std::max)({_cv_stitcher->registrationResol(),
+                               _cv_stitcher->seamEstimationResol(),
+                               _cv_stitcher->compositingResol()});
+  if (_divide_images != 0) {
+    // 各阶段的分辨率针对切割后的条带，条带只占原图的1/(n-(n-1)*overlap)，
+    // 原图要按这个比例放大解码，否则每个条带都低于设定的分辨率
+    megapix *= _divide_count - (_divide_count - 1) * _divide_overlap;
+  }
+  return megapix;
+}
+
 double ImageStitcher::Distance(double lat1, double lon1, double lat2,
                                double lon2) {
   double R = 6371004;  // m
@@ -1109,7 +1843,7 @@ const Image ImageStitcher::WarperImageByHomography(const int index1,
     return Image();
   }
 
-  auto matches = _features_matches[{index1, index2}];
+  const auto &matches = _features_matches.at({index1, index2});
   Image dst;
   cv::Mat points =
       (cv::Mat_<double>(3, 4) << 0, _final_images[index1].cols, 0,
@@ -1146,18 +1880,14 @@ auto ImageStitcher::Stitch(std::vector<Image> &images)
   std::vector<ImagePtr> results;
   Image result;
   signal_run_message("开始拼接", -1);
+  UpdateImageHashes(images);
   auto status = _cv_stitcher->stitch(images, result);
   std::string str;
   if (status == cv::Stitcher::OK) {
     str = "已完成拼接:";
     _comp = _cv_stitcher->component();
     for (int i : _comp) {
-      if (_divide_images == 1 || _divide_images == 2) {
-        str +=
-            std::to_string(i / 3 + 1) + "-" + std::to_string(i % 3 + 1) + ", ";
-      } else {
-        str += std::to_string(i + 1) + ", ";
-      }
+      str += ImageLabel(i) + ", ";
     }
     results.push_back(new Image(result));
     signal_run_message(str, -1);
@@ -1167,6 +1897,203 @@ auto ImageStitcher::Stitch(std::vector<Image> &images)
   return results;
 }
 
+auto ImageStitcher::ComponentsStitch(std::vector<Image> &images)
+    -> std::vector<ImagePtr> {
+  signal_run_message("开始拼接", -1);
+  const int n = images.size();
+  const double conf_thresh = _cv_stitcher->panoConfidenceThresh();
+  double work_scale = 1.0;
+  if (_cv_stitcher->registrationResol() >= 0) {
+    work_scale =
+        ResolScale(_cv_stitcher->registrationResol(), images[0].size());
+  }
+  std::vector<cv::Size> full_sizes(n);
+  std::vector<Image> work_images(n);
+  for (int i = 0; i < n; ++i) {
+    full_sizes[i] = images[i].size();
+    if (work_scale < 1.0) {
+      cv::resize(images[i], work_images[i], cv::Size(), work_scale, work_scale,
+                 cv::INTER_LINEAR_EXACT);
+    } else {
+      work_images[i] = images[i];
+    }
+  }
+
+  // 特征提取与匹配只做一次
+  std::vector<ImageFeatures> features;
+  cv::detail::computeImageFeatures(_cv_stitcher->featuresFinder(), work_images,
+                                   features);
+  for (int i = 0; i < n; ++i) {
+    features[i].img_idx = i;
+  }
+  std::vector<MatchesInfo> pairwise_matches;
+  (*_cv_stitcher->featuresMatcher())(features, pairwise_matches,
+                                     _cv_stitcher->matchingMask());
+  _cv_stitcher->featuresMatcher()->collectGarbage();
+
+  // 按置信度划分连通分量，与leaveBiggestComponent的判断一致
+  std::vector<int> parent(n);
+  for (int i = 0; i < n; ++i) {
+    parent[i] = i;
+  }
+  std::function<int(int)> find_root = [&](int i) {
+    return parent[i] == i ? i : parent[i] = find_root(parent[i]);
+  };
+  for (int i = 0; i < n; ++i) {
+    for (int j = i + 1; j < n; ++j) {
+      if (pairwise_matches[i * n + j].confidence >= conf_thresh) {
+        parent[find_root(i)] = find_root(j);
+      }
+    }
+  }
+  std::map<int, std::vector<int>> groups;
+  for (int i = 0; i < n; ++i) {
+    groups[find_root(i)].push_back(i);
+  }
+  std::vector<std::vector<int>> components;
+  for (auto &[root, indices] : groups) {
+    components.push_back(indices);
+  }
+  std::sort(components.begin(), components.end());
+  signal_run_message("共 " + std::to_string(components.size()) + " 个部分",
+                     -1);
+
+  // 每个部分使用独立的估计器、平差器和拼接缝查找器，可以并行
+  const auto estimator_name =
+      "Estimator." + _params.GetParam("Estimator", std::string());
+  const auto adjuster_name =
+      "BundleAdjuster." + _params.GetParam("BundleAdjuster", std::string());
+  const auto seam_finder_name =
+      "SeamFinder." + _params.GetParam("SeamFinder", std::string());
+  std::vector<ImagePtr> panos(components.size());
+  std::vector<std::vector<CameraParams>> components_cameras(components.size());
+  // 只有一个部分需要拼接时让其内部的投影、融合并行；多个部分时在部分之间并行，
+  // 并关闭嵌套，避免每个部分再各自开满线程
+  const int multi_image_components =
+      std::count_if(components.begin(), components.end(),
+                    [](const std::vector<int> &c) { return c.size() > 1; });
+  const bool parallel_components = multi_image_components > 1;
+#ifdef _OPENMP
+  const int max_active_levels = omp_get_max_active_levels();
+  if (parallel_components) {
+    omp_set_max_active_levels(1);
+  }
+#endif
+#pragma omp parallel for schedule(dynamic) if (parallel_components)
+  for (int c = 0; c < components.size(); ++c) {
+    const auto &indices = components[c];
+    const int k = indices.size();
+    if (k == 1) {
+      panos[c] = new Image(images[indices[0]]);
+      continue;
+    }
+    try {
+      std::vector<ImageFeatures> sub_features(k);
+      std::vector<MatchesInfo> sub_matches(k * k);
+      for (int a = 0; a < k; ++a) {
+        sub_features[a] = features[indices[a]];
+        sub_features[a].img_idx = a;
+        for (int b = 0; b < k; ++b) {
+          auto &matches_info = sub_matches[a * k + b];
+          matches_info = pairwise_matches[indices[a] * n + indices[b]];
+          if (matches_info.src_img_idx >= 0) {
+            matches_info.src_img_idx = a;
+            matches_info.dst_img_idx = b;
+          }
+        }
+      }
+      cv::Ptr<cv::detail::Estimator> estimator =
+          cv::makePtr<cv::detail::HomographyBasedEstimator>();
+      if (ALL_CONFIGS.find(estimator_name) != ALL_CONFIGS.end()) {
+        estimator = ALL_CONFIGS.at(estimator_name)
+                        ->call<cv::Ptr<cv::detail::Estimator>,
+                               ImageStitcher *>(nullptr);
+      }
+      std::vector<CameraParams> cameras;
+      if (!(*estimator)(sub_features, sub_matches, cameras)) {
+        LOG(WARNING) << "Component " << c << " camera estimation failed";
+        continue;
+      }
+      for (auto &camera : cameras) {
+        Mat R;
+        camera.R.convertTo(R, CV_32F);
+        camera.R = R;
+      }
+      cv::Ptr<cv::detail::BundleAdjusterBase> adjuster =
+          cv::makePtr<cv::detail::BundleAdjusterRay>();
+      if (ALL_CONFIGS.find(adjuster_name) != ALL_CONFIGS.end()) {
+        adjuster = ALL_CONFIGS.at(adjuster_name)
+                       ->call<cv::Ptr<cv::detail::BundleAdjusterBase>,
+                              ImageStitcher *>(nullptr);
+      }
+      adjuster->setConfThresh(conf_thresh);
+      if (!(*adjuster)(sub_features, sub_matches, cameras)) {
+        LOG(WARNING) << "Component " << c << " bundle adjustment failed";
+        continue;
+      }
+      if (_cv_stitcher->waveCorrection()) {
+        std::vector<Mat> rmats;
+        for (const auto &camera : cameras) {
+          rmats.push_back(camera.R.clone());
+        }
+        cv::detail::waveCorrect(rmats, _cv_stitcher->waveCorrectKind());
+        for (int a = 0; a < k; ++a) {
+          cameras[a].R = rmats[a];
+        }
+      }
+      components_cameras[c] = cameras;
+      cv::Ptr<cv::detail::SeamFinder> seam_finder =
+          cv::makePtr<cv::detail::GraphCutSeamFinder>();
+      if (ALL_CONFIGS.find(seam_finder_name) != ALL_CONFIGS.end()) {
+        seam_finder = ALL_CONFIGS.at(seam_finder_name)
+                          ->call<cv::Ptr<cv::detail::SeamFinder>,
+                                 ImageStitcher *>(nullptr);
+      }
+      RigCalibration rig;
+      if (BuildRig(images, full_sizes, indices, cameras, work_scale, rig,
+                   seam_finder)) {
+        panos[c] = ComposeRig(rig, images);
+      }
+    } catch (const cv::Exception &e) {
+      LOG(ERROR) << "Component " << c << " stitching failed : " << e.what();
+    }
+  }
+#ifdef _OPENMP
+  omp_set_max_active_levels(max_active_levels);
+#endif
+
+  std::vector<ImagePtr> results;
+  std::string str = "已完成拼接:";
+  int largest = -1;
+  for (size_t c = 0; c < components.size(); ++c) {
+    if (panos[c].empty()) {
+      continue;
+    }
+    results.push_back(panos[c]);
+    str += " [";
+    for (int i : components[c]) {
+      str += ImageLabel(i) + ",";
+    }
+    str.back() = ']';
+    if (!components_cameras[c].empty() &&
+        (largest < 0 ||
+         components[c].size() > components[largest].size())) {
+      largest = c;
+    }
+  }
+  // 中间数据只展示最大的成功部分的相机参数，各部分的拼接缝和曝光补偿不记录
+  _comp.clear();
+  FinalCameraParams().clear();
+  SeamMasks().clear();
+  CompensatorImages().clear();
+  if (largest >= 0) {
+    _comp = components[largest];
+    FinalCameraParams() = components_cameras[largest];
+  }
+  signal_run_message(str, -1);
+  return results;
+}
+
 auto ImageStitcher::IncrementalStitch(std::vector<Image> &images)
     -> std::vector<ImagePtr> {
   signal_run_message.notify("开始拼接", -1);
@@ -1304,27 +2231,74 @@ auto ImageStitcher::Stitch() -> std::vector<ImagePtr> {
     signal_result(std::vector<ImagePtr>());
     return std::vector<ImagePtr>();
   }
+  if (_rig_mode != RigMode::RIG_NONE) {
+    std::vector<Image> frames;
+    std::vector<ImagePtr> results;
+    for (const auto &image : _images) {
+      frames.push_back(image->Full());
+      if (frames.back().empty()) {
+        signal_run_message("拼接失败: 无法读取图像 " + image->FileName(), -1);
+        signal_result(results);
+        return results;
+      }
+    }
+    if (_rig_mode == RigMode::RIG_CALIBRATE) {
+      CalibrateRig(frames);
+    } else if (!_rig.Valid()) {
+      // 直接使用标定结果时不悄悄退回完整拼接，需要先标定或加载标定文件
+      LOG(WARNING) << "RigMode APPLY without a valid rig, RigFile : "
+                   << _rig_file;
+      signal_run_message("拼接失败: 没有可用的固定机位标定", -1);
+    }
+    if (_rig.Valid()) {
+      auto pano = StitchRig(frames);
+      if (!pano.empty()) {
+        results.push_back(pano);
+      }
+    }
+    signal_result(results);
+    signal_run_progress(1);
+    return results;
+  }
+  _image_hashes.clear();
+  // 监听器只追加，每次拼接前清空上一次的中间数据
+  SeamMasks().clear();
+  CompensatorImages().clear();
   signal_run_message("预备拼接图像", -1);
+  bool lazy = _mode == ALL && _divide_images == 0 && !_split_components;
+  for (const auto &image : _images) {
+    lazy = lazy && image->PreviewScale() < 1.0;
+  }
+  if (lazy) {
+    auto results = LazyStitch();
+    SaveCameraParams();
+    signal_result(results);
+    signal_run_progress(1);
+    return results;
+  }
   std::vector<Image> images_;
+  _divide_layout.clear();
+  _divide_sources.clear();
   for (int i = 0; i < _images.size(); ++i) {
-    if (_divide_images == 0 || _mode != ALL) {
-      images_.push_back(*_images[i]);
-    } else if (_divide_images == 1) {
-      cv::Rect rect(0, 0, _images[i]->cols, _images[i]->rows / 2);
-      images_.push_back((*_images[i])(rect).clone());
-      rect.y = _images[i]->rows / 3;
-      images_.push_back((*_images[i])(rect).clone());
-      rect.y = _images[i]->rows / 2;
-      images_.push_back((*_images[i])(rect).clone());
-    } else if (_divide_images == 2) {
-      cv::Rect rect(0, 0, _images[i]->cols / 2, _images[i]->rows);
-      images_.push_back((*_images[i])(rect).clone());
-      rect.x = _images[i]->cols / 3;
-      images_.push_back((*_images[i])(rect).clone());
-      rect.x = _images[i]->cols / 2;
-      images_.push_back((*_images[i])(rect).clone());
+    ImagePtr image = new Image(_images[i]->Full());
+    if (image->empty()) {
+      signal_run_message("拼接失败: 无法读取图像 " + _images[i]->FileName(),
+                         -1);
+      _divide_layout.clear();
+      _divide_sources.clear();
+      signal_result(std::vector<ImagePtr>());
+      return std::vector<ImagePtr>();
+    }
+    if (_mode == ALL && (_divide_images == 1 || _divide_images == 2)) {
+      // 条带直接引用原图数据，不复制
+      for (const auto &rect : DivideRects(image->size(), _divide_images,
+                                          _divide_count, _divide_overlap)) {
+        images_.push_back((*image)(rect));
+        _divide_layout.emplace_back(i, rect);
+      }
+      _divide_sources.push_back(image);
     } else {
-      images_.push_back(*_images[i]);
+      images_.push_back(*image);
     }
   }
   FinalStitchImages().clear();
@@ -1339,7 +2313,9 @@ auto ImageStitcher::Stitch() -> std::vector<ImagePtr> {
            _regist_scales[i], cv::INTER_LINEAR_EXACT);
   }
   std::vector<ImagePtr> results;
-  if (_mode == Mode::ALL) {
+  if (_mode == Mode::ALL && _split_components) {
+    results = ComponentsStitch(images_);
+  } else if (_mode == Mode::ALL) {
     results = Stitch(images_);
     FinalCameraParams() = _cv_stitcher->cameras();
   } else if (_mode == Mode::INCREMENTAL) {
@@ -1350,13 +2326,430 @@ auto ImageStitcher::Stitch() -> std::vector<ImagePtr> {
   } else {
     signal_run_message("未知拼接模式", 10000);
   }
+  if (!_remap_cache_file.empty() && _remap_cache.Dirty()) {
+    _remap_cache.Save(_remap_cache_file);
+  }
+  SaveCameraParams();
+  _divide_layout.clear();
+  _divide_sources.clear();
   signal_result(results);
   signal_run_progress(1);
   return results;
 }
 
+auto ImageStitcher::CalibrateRig(const std::vector<Image> &frames) -> bool {
+  if (_cv_stitcher.empty()) {
+    SetParams(Parameters());
+  }
+  if (frames.size() < 2) {
+    signal_run_message("固定机位标定至少需要两张图像", -1);
+    return false;
+  }
+  signal_run_message("固定机位标定中", -1);
+  UpdateImageHashes(frames);
+  auto status = _cv_stitcher->estimateTransform(frames);
+  SaveCameraParams();
+  if (status != cv::Stitcher::OK) {
+    signal_run_message("固定机位标定失败,错误代码: " + std::to_string(status),
+                       -1);
+    return false;
+  }
+  _comp = _cv_stitcher->component();
+  FinalCameraParams() = _cv_stitcher->cameras();
+
+  std::vector<cv::Size> frame_sizes;
+  for (const auto &frame : frames) {
+    frame_sizes.push_back(frame.size());
+  }
+  double work_scale = 1.0;
+  if (_cv_stitcher->registrationResol() >= 0) {
+    work_scale = ResolScale(_cv_stitcher->registrationResol(), frame_sizes[0]);
+  }
+  RigCalibration rig;
+  if (!BuildRig(frames, frame_sizes, _comp, _cv_stitcher->cameras(),
+                work_scale, rig)) {
+    signal_run_message("固定机位标定失败", -1);
+    return false;
+  }
+  rig.frame_count = frames.size();
+  _rig = rig;
+  if (!_rig_file.empty()) {
+    _rig.Save(_rig_file);
+  }
+  signal_run_message("固定机位标定完成", -1);
+  return true;
+}
+
+auto ImageStitcher::StitchRig(const std::vector<Image> &frames) -> ImagePtr {
+  if (!_rig.Valid()) {
+    LOG(ERROR) << "Rig is not calibrated";
+    return nullptr;
+  }
+  if ((int)frames.size() != _rig.frame_count) {
+    LOG(ERROR) << "Rig expects " << _rig.frame_count << " frames, got "
+               << frames.size();
+    return nullptr;
+  }
+  for (size_t k = 0; k < _rig.indices.size(); ++k) {
+    if (frames[_rig.indices[k]].size() != _rig.frame_sizes[k]) {
+      LOG(ERROR) << "Frame " << _rig.indices[k]
+                 << " size differs from the calibration";
+      return nullptr;
+    }
+  }
+  if (_rig.exposure_compensator.empty() || _rig.blender.empty()) {
+    CreateRigComponents(_rig);
+  }
+  return ComposeRig(_rig, frames);
+}
+
+auto ImageStitcher::SaveRig(const std::string &file_name) -> bool {
+  return _rig.Save(file_name);
+}
+
+auto ImageStitcher::LoadRig(const std::string &file_name) -> bool {
+  if (!_rig.Load(file_name)) {
+    return false;
+  }
+  CreateRigComponents(_rig);
+  std::vector<Mat> gains;
+  for (const auto &gain : _rig.gains) {
+    if (!gain.empty()) {
+      gains.push_back(gain);
+    }
+  }
+  if (gains.size() == _rig.indices.size()) {
+    _rig.exposure_compensator->setMatGains(gains);
+  }
+  return true;
+}
+
+auto ImageStitcher::CreateRigComponents(RigCalibration &rig) -> void {
+  auto exposure_compensator_name =
+      "ExposureCompensator." + rig.exposure_compensator_name;
+  if (ALL_CONFIGS.find(exposure_compensator_name) != ALL_CONFIGS.end()) {
+    rig.exposure_compensator =
+        ALL_CONFIGS.at(exposure_compensator_name)
+            ->call<cv::Ptr<cv::detail::ExposureCompensator>, ImageStitcher *>(
+                nullptr);
+  } else {
+    rig.exposure_compensator = cv::makePtr<cv::detail::NoExposureCompensator>();
+  }
+  auto blender_name = "Blender." + rig.blender_name;
+  if (ALL_CONFIGS.find(blender_name) != ALL_CONFIGS.end()) {
+    rig.blender = ALL_CONFIGS.at(blender_name)
+                      ->call<cv::Ptr<cv::detail::Blender>, ImageStitcher *>(
+                          nullptr);
+  } else {
+    rig.blender =
+        cv::detail::Blender::createDefault(cv::detail::Blender::MULTI_BAND);
+  }
+}
+
+auto ImageStitcher::BuildRig(const std::vector<Image> &images,
+                             const std::vector<cv::Size> &full_sizes,
+                             const std::vector<int> &indices,
+                             std::vector<CameraParams> cameras,
+                             const double work_scale, RigCalibration &rig,
+                             cv::Ptr<cv::detail::SeamFinder> seam_finder)
+    -> bool {
+  const size_t n = indices.size();
+  if (n == 0 || cameras.size() != n) {
+    LOG(ERROR) << "Invalid cameras for rig : " << cameras.size() << " vs "
+               << n;
+    return false;
+  }
+  // 各个尺度的计算方式与cv::Stitcher保持一致
+  double seam_scale =
+      ResolScale(_cv_stitcher->seamEstimationResol(), full_sizes[0]);
+  double seam_work_aspect = seam_scale / work_scale;
+  double compose_scale = 1.0;
+  if (_cv_stitcher->compositingResol() > 0) {
+    compose_scale = ResolScale(_cv_stitcher->compositingResol(),
+                               full_sizes[indices[0]]);
+  }
+  double compose_work_aspect = compose_scale / work_scale;
+  double warped_image_scale = MedianFocal(cameras);
+
+  rig.Clear();
+  rig.indices = indices;
+  rig.compose_scale = compose_scale;
+  rig.interp_flags = _cv_stitcher->interpolationFlags();
+  rig.exposure_compensator_name = _params.GetParam(
+      "ExposureCompensator", std::string("NoExposureCompensator"));
+  rig.blender_name =
+      _params.GetParam("Blender", std::string("MultiBandBlender"));
+  CreateRigComponents(rig);
+
+  if (seam_finder.empty()) {
+    // 分量并行拼接时由调用者传入拼接缝查找器，不在工作线程发出信号
+    signal_run_message("Seam finding", -1);
+    seam_finder = _cv_stitcher->seamFinder();
+  }
+
+  // 在拼接缝分辨率下投影，求曝光增益与拼接缝
+  auto seam_warper = _cv_stitcher->warper()->create(
+      float(warped_image_scale * seam_work_aspect));
+  std::vector<cv::Point> seam_corners(n);
+  std::vector<cv::UMat> seam_images(n), seam_images_f(n), seam_masks(n);
+  for (size_t k = 0; k < n; ++k) {
+    const auto &full_size = full_sizes[indices[k]];
+    cv::Size seam_size(cvRound(full_size.width * seam_scale),
+                       cvRound(full_size.height * seam_scale));
+    Image seam_image;
+    cv::resize(images[indices[k]], seam_image, seam_size, 0, 0,
+               cv::INTER_LINEAR_EXACT);
+    cv::Mat_<float> K;
+    cameras[k].K().convertTo(K, CV_32F);
+    K(0, 0) *= (float)seam_work_aspect;
+    K(0, 2) *= (float)seam_work_aspect;
+    K(1, 1) *= (float)seam_work_aspect;
+    K(1, 2) *= (float)seam_work_aspect;
+    seam_corners[k] =
+        seam_warper->warp(seam_image, K, cameras[k].R, rig.interp_flags,
+                          cv::BORDER_REFLECT, seam_images[k]);
+    Mat mask(seam_image.size(), CV_8U, cv::Scalar::all(255));
+    seam_warper->warp(mask, K, cameras[k].R, cv::INTER_NEAREST,
+                      cv::BORDER_CONSTANT, seam_masks[k]);
+    seam_images[k].convertTo(seam_images_f[k], CV_32F);
+  }
+  rig.exposure_compensator->feed(seam_corners, seam_images, seam_masks);
+  rig.exposure_compensator->getMatGains(rig.gains);
+  seam_finder->find(seam_images_f, seam_corners, seam_masks);
+
+  // 在融合分辨率下生成映射表，并把拼接缝合并进投影掩码
+  auto warper = _cv_stitcher->warper()->create(
+      float(warped_image_scale * compose_work_aspect));
+  rig.frame_sizes.resize(n);
+  rig.corners.resize(n);
+  rig.sizes.resize(n);
+  rig.xmaps.resize(n);
+  rig.ymaps.resize(n);
+  rig.masks.resize(n);
+  for (size_t k = 0; k < n; ++k) {
+    auto &camera = cameras[k];
+    camera.focal *= compose_work_aspect;
+    camera.ppx *= compose_work_aspect;
+    camera.ppy *= compose_work_aspect;
+    rig.frame_sizes[k] = full_sizes[indices[k]];
+    cv::Size size = rig.frame_sizes[k];
+    if (std::abs(compose_scale - 1) > 1e-1) {
+      size = cv::Size(cvRound(size.width * compose_scale),
+                      cvRound(size.height * compose_scale));
+    }
+    Mat K;
+    camera.K().convertTo(K, CV_32F);
+    cv::Rect roi =
+        warper->buildMaps(size, K, camera.R, rig.xmaps[k], rig.ymaps[k]);
+    rig.corners[k] = roi.tl();
+    rig.sizes[k] = rig.xmaps[k].size();
+
+    // 掩码按最近邻插值投影，使用转换前的浮点映射表
+    Mat mask(size, CV_8U, cv::Scalar::all(255)), mask_warped;
+    cv::remap(mask, mask_warped, rig.xmaps[k], rig.ymaps[k],
+              cv::INTER_NEAREST, cv::BORDER_CONSTANT);
+    // 映射表在每组帧之间复用，转换一次定点格式就能一直受益
+    if (_fixed_point_remap &&
+        RemapCache::FixedPointApplicable(CV_8U, rig.interp_flags)) {
+      RemapCache::Entry maps{roi, rig.xmaps[k], rig.ymaps[k]};
+      RemapCache::ToFixedPoint(maps);
+      rig.xmaps[k] = maps.xmap;
+      rig.ymaps[k] = maps.ymap;
+    }
+    Mat dilated_mask, seam_mask;
+    cv::dilate(seam_masks[k], dilated_mask, Mat());
+    cv::resize(dilated_mask, seam_mask, mask_warped.size(), 0, 0,
+               cv::INTER_LINEAR_EXACT);
+    cv::bitwise_and(seam_mask, mask_warped, rig.masks[k]);
+  }
+  rig.cameras = cameras;
+  return true;
+}
+
+auto ImageStitcher::ComposeRig(RigCalibration &rig,
+                               const std::vector<Image> &frames) -> ImagePtr {
+  return ComposeRig(rig, [&frames](int index) { return frames[index]; });
+}
+
+auto ImageStitcher::ComposeRig(RigCalibration &rig,
+                               const std::function<Image(int)> &frame_at)
+    -> ImagePtr {
+  const int n = rig.indices.size();
+  const bool resize_frames = std::abs(rig.compose_scale - 1) > 1e-1;
+  rig.blender->prepare(rig.corners, rig.sizes);
+  // 各连通分量在并行区域内合成，信号只能在串行调用时发出
+  PreviewCanvas preview;
+#ifdef _OPENMP
+  const bool preview_enabled = !omp_in_parallel() && !signal_preview.empty();
+#else
+  const bool preview_enabled = !signal_preview.empty();
+#endif
+  if (preview_enabled) {
+    preview.Prepare(cv::detail::resultRoi(rig.corners, rig.sizes));
+  }
+  // 每批最多同时持有线程数张原图，投影后立即释放，融合器串行接收
+#ifdef _OPENMP
+  const int batch = (std::max)(1, omp_get_max_threads());
+#else
+  const int batch = 1;
+#endif
+  std::vector<Mat> warped(batch);
+  // 按需解码的原图可能在打开后被删除或损坏，此时放弃整张全景图
+  std::atomic<bool> missing(false);
+  for (int begin = 0; begin < n; begin += batch) {
+    const int end = (std::min)(n, begin + batch);
+    // 投影和曝光补偿各帧之间互不依赖，可以并行
+#pragma omp parallel for
+    for (int k = begin; k < end; ++k) {
+      Image frame = frame_at(rig.indices[k]);
+      if (frame.empty()) {
+        missing = true;
+        continue;
+      }
+      Image img, img_warped;
+      if (resize_frames) {
+        cv::resize(frame, img,
+                   cv::Size(cvRound(frame.cols * rig.compose_scale),
+                            cvRound(frame.rows * rig.compose_scale)),
+                   0, 0, cv::INTER_LINEAR_EXACT);
+        frame.release();
+      } else {
+        img = frame;
+      }
+      cv::remap(img, img_warped, rig.xmaps[k], rig.ymaps[k], rig.interp_flags,
+                cv::BORDER_REFLECT);
+      img.release();
+      rig.exposure_compensator->apply(k, rig.corners[k], img_warped,
+                                      rig.masks[k]);
+      img_warped.convertTo(warped[k - begin], CV_16S);
+    }
+    if (missing) {
+      break;
+    }
+    for (int k = begin; k < end; ++k) {
+      rig.blender->feed(warped[k - begin], rig.masks[k], rig.corners[k]);
+      if (preview_enabled) {
+        preview.Feed(warped[k - begin], rig.masks[k], rig.corners[k]);
+      }
+      warped[k - begin].release();
+    }
+    if (preview_enabled && preview.Due()) {
+      signal_preview(preview.Preview());
+    }
+  }
+  if (missing) {
+    LOG(ERROR) << "Compositing aborted, a source image could not be decoded";
+    return nullptr;
+  }
+  Mat result, result_mask;
+  rig.blender->blend(result, result_mask);
+  ImagePtr pano = new Image();
+  result.convertTo(*pano, CV_8U);
+  return pano;
+}
+
+auto ImageStitcher::LazyStitch() -> std::vector<ImagePtr> {
+  std::vector<ImagePtr> results;
+  std::vector<Image> previews;
+  std::vector<cv::Size> full_sizes;
+  for (const auto &image : _images) {
+    previews.push_back(*image->Preview());
+    full_sizes.push_back(image->FullSize());
+  }
+  FinalStitchImages().resize(previews.size());
+  _regist_scales.resize(previews.size());
+  for (int i = 0; i < previews.size(); ++i) {
+    _regist_scales[i] =
+        ResolScale(_cv_stitcher->registrationResol(), previews[i].size());
+    resize(previews[i], FinalStitchImages()[i], cv::Size(), _regist_scales[i],
+           _regist_scales[i], cv::INTER_LINEAR_EXACT);
+  }
+  signal_run_message("开始拼接", -1);
+  UpdateImageHashes(previews);
+  // 配准只使用预览图
+  auto status = _cv_stitcher->estimateTransform(previews);
+  if (status != cv::Stitcher::OK) {
+    signal_run_message("拼接失败,错误代码: " + std::to_string(status), -1);
+    return results;
+  }
+  _comp = _cv_stitcher->component();
+  FinalCameraParams() = _cv_stitcher->cameras();
+
+  // 相机参数位于预览图的配准尺度下，换算到相对原图的尺度
+  double work_scale =
+      _images[0]->PreviewScale() *
+      ResolScale(_cv_stitcher->registrationResol(), previews[0].size());
+  RigCalibration rig;
+  if (!BuildRig(previews, full_sizes, _comp, _cv_stitcher->cameras(),
+                work_scale, rig)) {
+    signal_run_message("拼接失败", -1);
+    return results;
+  }
+  // 曝光补偿只记录在融合阶段，按需解码的原图不保留副本，中间数据中没有补偿图像
+  signal_run_message("融合中", -1);
+  auto pano =
+      ComposeRig(rig, [this](int index) { return _images[index]->Full(); });
+  if (pano.empty()) {
+    signal_run_message("拼接失败: 融合时无法读取原图", -1);
+    return results;
+  }
+  results.push_back(pano);
+  std::string str = "已完成拼接:";
+  for (int i : _comp) {
+    str += ImageLabel(i) + ", ";
+  }
+  signal_run_message(str, -1);
+  return results;
+}
+
+auto ImageStitcher::UpdateImageHashes(const std::vector<Image> &images)
+    -> void {
+  _image_hashes.clear();
+  if (!_warm_start) {
+    return;
+  }
+  _image_hashes.resize(images.size());
+  // 保存的参数是配准尺度下、按当前相机模型估计的，配准分辨率或估计器、平差器、
+  // 投影模型不同时不能复用(如仿射模型的R不能作为旋转交给光线平差器)
+  const double registration_resol = _cv_stitcher->registrationResol();
+  const std::string model =
+      _params.GetParam("Estimator", std::string()) + "/" +
+      _params.GetParam("BundleAdjuster", std::string()) + "/" +
+      _params.GetParam("Warper", std::string());
+  const uint64_t seed =
+      HashBytes(model.data(), model.size(),
+                HashBytes(&registration_resol, sizeof(registration_resol)));
+#pragma omp parallel for
+  for (int i = 0; i < images.size(); ++i) {
+    _image_hashes[i] = HashImage(images[i], seed);
+  }
+}
+
+auto ImageStitcher::SaveCameraParams() -> void {
+  if (_warm_start && !_camera_params_file.empty() &&
+      _camera_params_store.Dirty()) {
+    _camera_params_store.Save(_camera_params_file);
+  }
+}
+
+auto ImageStitcher::ImageLabel(const int index) const -> std::string {
+  if (_mode == ALL && (_divide_images == 1 || _divide_images == 2)) {
+    return std::to_string(index / _divide_count + 1) + "-" +
+           std::to_string(index % _divide_count + 1);
+  }
+  return std::to_string(index + 1);
+}
+
 auto ImageStitcher::ImageSize() -> int { return _images.size(); }
 
+auto ImageStitcher::SaveRemapCache(const std::string &file_name) -> bool {
+  return _remap_cache.Save(file_name);
+}
+
+auto ImageStitcher::LoadRemapCache(const std::string &file_name) -> bool {
+  return _remap_cache.Load(file_name);
+}
+
 auto ImageStitcher::DetectFeatures(const Image &image) -> ImageFeatures {
   if (!_cv_stitcher.empty()) {
     ImageFeatures image_features;
@@ -1434,17 +2827,31 @@ auto ImageStitcher::RemoveImage(int index) -> bool {
     return false;
   }
   _images.erase(_images.begin() + index);
+  _prefetched_features.clear();
   return true;
 }
 auto ImageStitcher::RemoveAllImages() -> bool {
   _images.clear();
+  _prefetched_features.clear();
   return true;
 }
 auto ImageStitcher::GetImage(int index) -> ImagePtr {
+  if (index < 0 || index >= _images.size()) {
+    return nullptr;
+  }
+  return _images[index]->Preview();
+}
+auto ImageStitcher::GetImages() -> std::vector<ImagePtr> {
+  std::vector<ImagePtr> images;
+  for (const auto &handle : _images) {
+    images.push_back(handle->Preview());
+  }
+  return images;
+}
+auto ImageStitcher::GetImageHandle(int index) -> ImageHandlePtr {
   if (index < 0 || index >= _images.size()) {
     return nullptr;
   }
   return _images[index];
 }
-auto ImageStitcher::GetImages() -> std::vector<ImagePtr> { return _images; }
 };  // namespace ImageStitch
\ No newline at end of file
@@ -1,146 +1,278 @@
-#pragma once
-
-#include <memory>
-#include <opencv2/opencv.hpp>
-#include <vector>
-
-#include "../../signal/trackable.hpp"
-#include "../common/cvTypeDef.hpp"
-#include "../common/parameters.hpp"
-
-namespace ImageStitch {
-
-struct ConfigItem {
-  enum Type { STRING = 0, FLOAT = 1, INT = 2 };
-  ConfigItem(
-      const std::string &title = "", const Type &type = STRING,
-      const std::string &desc = "",
-      const std::vector<std::string> &options = std::vector<std::string>())
-      : title(title), type(type), description(desc), options(options) {}
-  std::string title;
-  Type type;
-  std::string description;
-  std::vector<std::string> options;
-  double range[2];
-};
-
-class ImageStitcher {
- public:
-  enum Mode { ALL = 0, INCREMENTAL = 1, MERGE = 2 };
-
- public:
-  ImageStitcher();
-  auto SetParams(const Parameters &params = Parameters()) -> void;
-  auto SetImages(std::vector<ImagePtr> images) -> bool;
-  auto SetImages(std::vector<std::string> image_files) -> bool;
-  auto RemoveImage(int index) -> bool;
-  auto RemoveAllImages() -> bool;
-  auto GetImage(int index) -> ImagePtr;
-  auto GetImages() -> std::vector<ImagePtr>;
-  auto Stitch() -> std::vector<ImagePtr>;
-  auto DetectFeatures(const Image &image) -> ImageFeatures;
-  auto MatchesFeatures(const ImageFeatures &features1,
-                       const ImageFeatures &features2)
-      -> std::vector<MatchesInfo>;
-  auto EstimateCameraParams(const std::vector<ImageFeatures> &features,
-                            const std::vector<MatchesInfo> &pairwise_matches)
-      -> std::vector<CameraParams>;
-  auto ImageSize() -> int;
-  auto Clean() -> bool;
-  inline const Parameters &GetParams() const { return _params; }
-  inline Parameters &GetParams() { return _params; }
-
-  static auto ParamTable() -> std::vector<ConfigItem>;
-
- public:
-  Signal<void(std::string, int)> signal_run_message;
-  Signal<void(float)> signal_run_progress;
-  Signal<void(std::vector<ImagePtr>)> signal_result;
-
- public:
-  Image DrawKeypoint(const Image &image, const ImageFeatures &image_features);
-  Image DrawMatches(const Image &image1, const ImageFeatures &f1,
-                    const Image &image2, const ImageFeatures &f2,
-                    MatchesInfo &matches);
-  double Distance(double lat1, double lon1, double lat2, double lon2);
-
-  inline std::vector<Image> &FinalStitchImages() { return _final_images; }
-  inline const std::vector<Image> &FinalStitchImages() const {
-    return _final_images;
-  }
-  const Image WarperImageByCameraParams(const int index1, const int index2);
-  const Image WarperImageByHomography(const int index1, const int index2);
-  inline std::vector<ImageFeatures> &ImagesFeatures() {
-    return _images_features;
-  }
-  inline const std::vector<ImageFeatures> &ImagesFeatures() const {
-    return _images_features;
-  }
-  inline std::map<std::pair<int, int>, MatchesInfo> &FeaturesMatches() {
-    return _features_matches;
-  }
-  inline const std::map<std::pair<int, int>, MatchesInfo> &FeaturesMatches()
-      const {
-    return _features_matches;
-  }
-  inline std::vector<CameraParams> &FinalCameraParams() {
-    return _final_camera_params;
-  }
-  inline const std::vector<CameraParams> &FinalCameraParams() const {
-    return _final_camera_params;
-  }
-  inline std::vector<std::vector<Image>> &CompensatorImages() {
-    return _compensator_images;
-  }
-  inline const std::vector<std::vector<Image>> &CompensatorImages() const {
-    return _compensator_images;
-  }
-  inline const std::vector<int> &component() { return _comp; }
-  inline std::vector<Image> &SeamMasks() { return _seam_masks; }
-  inline const std::vector<Image> &SeamMasks() const { return _seam_masks; }
-
- private:
-  /**
-   * @brief 直接使用所有的图像进行拼接操作。同时会自动舍弃无法完成拼接的图像。
-   *
-   * @param image
-   * @return ImagePtr
-   */
-  auto Stitch(std::vector<Image> &images) -> std::vector<ImagePtr>;
-  /**
-   * @brief
-   * 假设图像顺序已经有序，将会按顺序逐张拼接。同时该方法在无法完全拼接的情况下会给出多个拼接结果。
-   *
-   * @param image
-   * @return ImagePtr
-   */
-  auto IncrementalStitch(std::vector<Image> &images) -> std::vector<ImagePtr>;
-  /**
-   * @brief
-   * 假设图像顺序已经有序，将会按归并的方式拼接。同时该方法在无法完全拼接的情况下会给出多个拼接结果。
-   *
-   * @param images
-   * @return std::vector<ImagePtr>
-   */
-  auto MergeStitch(std::vector<Image> &images, const int s, const int e)
-      -> std::vector<ImagePtr>;
-
- private:
-  Parameters _params;
-  cv::Ptr<cv::Stitcher> _cv_stitcher;
-  std::vector<ImagePtr> _images;
-  std::vector<Image> _final_images;
-  std::vector<std::vector<Image>> _compensator_images;
-  std::vector<Image> _seam_masks;
-  std::vector<ImageFeatures> _images_features;
-  std::map<std::pair<int, int>, MatchesInfo> _features_matches;
-  std::vector<CameraParams> _final_camera_params;
-  std::vector<std::vector<MatchesInfo>> _pairwise_matches;
-  std::vector<std::vector<CameraParams>> _camera_params;
-  std::vector<double> _regist_scales;
-  std::vector<int> _comp;
-  std::string _current_stitcher_mode;
-  int _divide_images;
-  Mode _mode;
-};
-}  // namespace ImageStitch
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <opencv2/opencv.hpp>
+#include <vector>
+
+#include "../../signal/trackable.hpp"
+#include "../common/cvTypeDef.hpp"
+#include "../common/imageHandle.hpp"
+#include "../common/parameters.hpp"
+#include "cameraParamsStore.hpp"
+#include "remapCache.hpp"
+#include "rigCalibration.hpp"
+#include "seamCache.hpp"
+
+namespace ImageStitch {
+
+struct ConfigItem {
+  enum Type { STRING = 0, FLOAT = 1, INT = 2 };
+  ConfigItem(
+      const std::string &title = "", const Type &type = STRING,
+      const std::string &desc = "",
+      const std::vector<std::string> &options = std::vector<std::string>())
+      : title(title), type(type), description(desc), options(options) {}
+  std::string title;
+  Type type;
+  std::string description;
+  std::vector<std::string> options;
+  double range[2];
+};
+
+class ImageStitcher {
+ public:
+  enum Mode { ALL = 0, INCREMENTAL = 1, MERGE = 2 };
+  enum RigMode { RIG_NONE = 0, RIG_CALIBRATE = 1, RIG_APPLY = 2 };
+
+ public:
+  ImageStitcher();
+  auto SetParams(const Parameters &params = Parameters()) -> void;
+  auto SetImages(std::vector<ImagePtr> images) -> bool;
+  auto SetImages(std::vector<std::string> image_files) -> bool;
+  auto RemoveImage(int index) -> bool;
+  auto RemoveAllImages() -> bool;
+  auto GetImage(int index) -> ImagePtr;
+  auto GetImages() -> std::vector<ImagePtr>;
+  auto GetImageHandle(int index) -> ImageHandlePtr;
+  auto Stitch() -> std::vector<ImagePtr>;
+  auto DetectFeatures(const Image &image) -> ImageFeatures;
+  auto MatchesFeatures(const ImageFeatures &features1,
+                       const ImageFeatures &features2)
+      -> std::vector<MatchesInfo>;
+  auto EstimateCameraParams(const std::vector<ImageFeatures> &features,
+                            const std::vector<MatchesInfo> &pairwise_matches)
+      -> std::vector<CameraParams>;
+  auto ImageSize() -> int;
+  auto Clean() -> bool;
+  /**
+   * @brief
+   * 固定机位标定：完整估计一次相机参数，并记录融合所需的映射表、拼接缝掩码和曝光增益。
+   *
+   * @param frames 一组同步拍摄的帧
+   * @return bool
+   */
+  auto CalibrateRig(const std::vector<Image> &frames) -> bool;
+  /**
+   * @brief
+   * 使用标定结果拼接新的帧组，帧的数量和尺寸必须与标定时一致。不可并发调用。
+   *
+   * @param frames
+   * @return ImagePtr 失败时为空
+   */
+  auto StitchRig(const std::vector<Image> &frames) -> ImagePtr;
+  auto SaveRig(const std::string &file_name) -> bool;
+  auto LoadRig(const std::string &file_name) -> bool;
+  auto SaveRemapCache(const std::string &file_name) -> bool;
+  auto LoadRemapCache(const std::string &file_name) -> bool;
+  inline const Parameters &GetParams() const { return _params; }
+  inline Parameters &GetParams() { return _params; }
+
+  static auto ParamTable() -> std::vector<ConfigItem>;
+
+ public:
+  Signal<void(std::string, int)> signal_run_message;
+  Signal<void(float)> signal_run_progress;
+  Signal<void(std::vector<ImagePtr>)> signal_result;
+  /**
+   * @brief 融合过程中的低分辨率预览，包含已送入融合器的图像，节流后在拼接线程发出
+   */
+  Signal<void(ImagePtr)> signal_preview;
+
+ public:
+  Image DrawKeypoint(const Image &image, const ImageFeatures &image_features);
+  Image DrawMatches(const Image &image1, const ImageFeatures &f1,
+                    const Image &image2, const ImageFeatures &f2,
+                    MatchesInfo &matches);
+  double Distance(double lat1, double lon1, double lat2, double lon2);
+
+  inline std::vector<Image> &FinalStitchImages() { return _final_images; }
+  inline const std::vector<Image> &FinalStitchImages() const {
+    return _final_images;
+  }
+  const Image WarperImageByCameraParams(const int index1, const int index2);
+  const Image WarperImageByHomography(const int index1, const int index2);
+  inline std::vector<ImageFeatures> &ImagesFeatures() {
+    return _images_features;
+  }
+  inline const std::vector<ImageFeatures> &ImagesFeatures() const {
+    return _images_features;
+  }
+  inline std::map<std::pair<int, int>, MatchesInfo> &FeaturesMatches() {
+    return _features_matches;
+  }
+  inline const std::map<std::pair<int, int>, MatchesInfo> &FeaturesMatches()
+      const {
+    return _features_matches;
+  }
+  inline std::vector<CameraParams> &FinalCameraParams() {
+    return _final_camera_params;
+  }
+  inline const std::vector<CameraParams> &FinalCameraParams() const {
+    return _final_camera_params;
+  }
+  inline std::vector<std::vector<Image>> &CompensatorImages() {
+    return _compensator_images;
+  }
+  inline const std::vector<std::vector<Image>> &CompensatorImages() const {
+    return _compensator_images;
+  }
+  inline RemapCache &GetRemapCache() { return _remap_cache; }
+  inline bool FixedPointRemap() const { return _fixed_point_remap; }
+  inline SeamCache &GetSeamCache() { return _seam_cache; }
+  inline bool IncrementalSeam() const { return _incremental_seam; }
+  inline CameraParamsStore &GetCameraParamsStore() {
+    return _camera_params_store;
+  }
+  inline bool WarmStart() const { return _warm_start; }
+  inline bool AffineModel() const { return _affine_model; }
+  inline const std::vector<uint64_t> &ImageHashes() const {
+    return _image_hashes;
+  }
+  inline const RigCalibration &Rig() const { return _rig; }
+  /**
+   * @brief 本次切割得到的各个条带对应的(原图下标, 原图中的区域)，未切割时为空
+   */
+  inline const std::vector<std::pair<int, cv::Rect>> &DivideLayout() const {
+    return _divide_layout;
+  }
+  /**
+   * @brief 本次被切割的原图，下标与DivideLayout中的原图下标一致
+   */
+  inline const std::vector<ImagePtr> &DivideSources() const {
+    return _divide_sources;
+  }
+  /**
+   * @brief SetImages加载图像时在配准尺度下预先提取的特征，图像或参数变化后清空
+   */
+  inline const std::vector<ImageFeatures> &PrefetchedFeatures() const {
+    return _prefetched_features;
+  }
+  inline const std::vector<int> &component() const { return _comp; }
+  inline std::vector<Image> &SeamMasks() { return _seam_masks; }
+  inline const std::vector<Image> &SeamMasks() const { return _seam_masks; }
+
+ private:
+  /**
+   * @brief 直接使用所有的图像进行拼接操作。同时会自动舍弃无法完成拼接的图像。
+   *
+   * @param image
+   * @return ImagePtr
+   */
+  auto Stitch(std::vector<Image> &images) -> std::vector<ImagePtr>;
+  /**
+   * @brief
+   * 假设图像顺序已经有序，将会按顺序逐张拼接。同时该方法在无法完全拼接的情况下会给出多个拼接结果。
+   *
+   * @param image
+   * @return ImagePtr
+   */
+  auto IncrementalStitch(std::vector<Image> &images) -> std::vector<ImagePtr>;
+  /**
+   * @brief
+   * 特征提取和匹配只做一次，按匹配图的连通分量并行拼接，每个分量输出一张全景图。
+   * 多于一个分量需要拼接时各分量并行，分量内部的并行循环串行执行；只有一个时
+   * 分量内部并行。中间数据只记录图像最多的成功分量的相机参数，不记录拼接缝和
+   * 曝光补偿。
+   *
+   * @param images
+   * @return std::vector<ImagePtr>
+   */
+  auto ComponentsStitch(std::vector<Image> &images) -> std::vector<ImagePtr>;
+  /**
+   * @brief
+   * 假设图像顺序已经有序，将会按归并的方式拼接。同时该方法在无法完全拼接的情况下会给出多个拼接结果。
+   *
+   * @param images
+   * @return std::vector<ImagePtr>
+   */
+  auto MergeStitch(std::vector<Image> &images, const int s, const int e)
+      -> std::vector<ImagePtr>;
+  auto BuildRig(const std::vector<Image> &images,
+                const std::vector<cv::Size> &full_sizes,
+                const std::vector<int> &indices,
+                std::vector<CameraParams> cameras, const double work_scale,
+                RigCalibration &rig,
+                cv::Ptr<cv::detail::SeamFinder> seam_finder = nullptr)
+      -> bool;
+  auto ComposeRig(RigCalibration &rig, const std::vector<Image> &frames)
+      -> ImagePtr;
+  /**
+   * @brief 按批次向frame_at请求原图并投影，同一时刻最多持有线程数张原图。
+   * 不在并行区域内时通过signal_preview发出融合进度预览
+   */
+  auto ComposeRig(RigCalibration &rig,
+                  const std::function<Image(int)> &frame_at) -> ImagePtr;
+  /**
+   * @brief 延迟加载的图像只用预览图配准、求拼接缝和曝光增益，融合时逐批解码原图
+   */
+  auto LazyStitch() -> std::vector<ImagePtr>;
+  auto CreateRigComponents(RigCalibration &rig) -> void;
+  /**
+   * @brief 计算本次交给cv::Stitcher的图像的哈希，下标与ImageFeatures::img_idx一致
+   */
+  auto UpdateImageHashes(const std::vector<Image> &images) -> void;
+  auto SaveCameraParams() -> void;
+  /**
+   * @brief 传给cv::Stitcher的图像下标对应的显示名称，切割时为"原图-条带"
+   */
+  auto ImageLabel(const int index) const -> std::string;
+  /**
+   * @brief 拼接各阶段需要的最大图像面积(百万像素)，需要全分辨率时返回-1。
+   * 切割图像时按条带占原图的比例换算为原图的面积
+   */
+  auto RequiredMegapix() const -> double;
+  /**
+   * @brief 当前配置下从文件加载时是否只解码预览图
+   */
+  auto LazyImagesEnabled() const -> bool;
+
+ private:
+  Parameters _params;
+  cv::Ptr<cv::Stitcher> _cv_stitcher;
+  std::vector<ImageHandlePtr> _images;
+  std::vector<Image> _final_images;
+  std::vector<std::vector<Image>> _compensator_images;
+  std::vector<Image> _seam_masks;
+  std::vector<ImageFeatures> _images_features;
+  std::map<std::pair<int, int>, MatchesInfo> _features_matches;
+  std::vector<CameraParams> _final_camera_params;
+  std::vector<std::vector<MatchesInfo>> _pairwise_matches;
+  std::vector<std::vector<CameraParams>> _camera_params;
+  std::vector<double> _regist_scales;
+  std::vector<int> _comp;
+  RemapCache _remap_cache;
+  std::string _remap_cache_file;
+  bool _fixed_point_remap = false;
+  SeamCache _seam_cache;
+  bool _incremental_seam = false;
+  CameraParamsStore _camera_params_store;
+  std::vector<uint64_t> _image_hashes;
+  std::string _camera_params_file;
+  bool _warm_start = false;
+  bool _affine_model = false;
+  bool _split_components = false;
+  RigCalibration _rig;
+  std::string _rig_file;
+  RigMode _rig_mode = RIG_NONE;
+  std::string _current_stitcher_mode;
+  int _divide_images;
+  int _divide_count = 3;
+  double _divide_overlap = 0.5;
+  std::vector<std::pair<int, cv::Rect>> _divide_layout;
+  std::vector<ImagePtr> _divide_sources;
+  int _prefetch_count = 4;
+  std::vector<ImageFeatures> _prefetched_features;
+  Mode _mode;
+};
+}  // namespace ImageStitch
@@ -0,0 +1,114 @@
+#include "parallelSeamFinder.hpp"
+
+#include <glog/logging.h>
+#include <omp.h>
+
+#include <algorithm>
+
+namespace ImageStitch {
+
+ParallelPairwiseSeamFinder::ParallelPairwiseSeamFinder(Creator creator,
+                                                       Order order)
+    : _creator(std::move(creator)), _order(order) {}
+
+auto ParallelPairwiseSeamFinder::SerialPairs(
+    const std::vector<cv::Point> &corners, const std::vector<cv::Size> &sizes,
+    Order order) -> std::vector<Pair> {
+  // 与DpSeamFinder::find一样先列出全部图像对再排序，不能先剔除不重叠的图像对，
+  // 否则不稳定排序中距离相同的图像对的先后可能改变
+  std::vector<std::pair<size_t, size_t>> pairs;
+  for (size_t i = 0; i + 1 < corners.size(); ++i) {
+    for (size_t j = i + 1; j < corners.size(); ++j) {
+      pairs.emplace_back(i, j);
+    }
+  }
+  if (order == DP) {
+    // 同DpSeamFinder中的ImagePairLess
+    auto center = [&corners, &sizes](size_t i) {
+      return corners[i] + cv::Point(sizes[i].width / 2, sizes[i].height / 2);
+    };
+    auto distance = [&center](const std::pair<size_t, size_t> &pair) {
+      cv::Point d = center(pair.first) - center(pair.second);
+      return d.dot(d);
+    };
+    std::sort(pairs.begin(), pairs.end(),
+              [&distance](const std::pair<size_t, size_t> &l,
+                          const std::pair<size_t, size_t> &r) {
+                return distance(l) < distance(r);
+              });
+    std::reverse(pairs.begin(), pairs.end());
+  }
+  std::vector<Pair> result;
+  for (const auto &pair : pairs) {
+    result.emplace_back((int)pair.first, (int)pair.second);
+  }
+  return result;
+}
+
+auto ParallelPairwiseSeamFinder::ScheduleRounds(
+    const std::vector<Pair> &pairs, const std::vector<cv::Point> &corners,
+    const std::vector<cv::Size> &sizes) -> std::vector<std::vector<Pair>> {
+  std::vector<std::vector<Pair>> rounds;
+  // 每张图像下一次可以参与的轮次
+  std::vector<int> next_round(corners.size(), 0);
+  for (const auto &pair : pairs) {
+    const int i = pair.first, j = pair.second;
+    cv::Rect roi;
+    if (!cv::detail::overlapRoi(corners[i], corners[j], sizes[i], sizes[j],
+                                roi)) {
+      continue;
+    }
+    int round = (std::max)(next_round[i], next_round[j]);
+    if (round == (int)rounds.size()) {
+      rounds.emplace_back();
+    }
+    rounds[round].emplace_back(i, j);
+    next_round[i] = next_round[j] = round + 1;
+  }
+  return rounds;
+}
+
+auto ParallelPairwiseSeamFinder::ScheduleRounds(
+    const std::vector<cv::Point> &corners, const std::vector<cv::Size> &sizes)
+    -> std::vector<std::vector<Pair>> {
+  return ScheduleRounds(SerialPairs(corners, sizes, LEXICOGRAPHIC), corners,
+                        sizes);
+}
+
+void ParallelPairwiseSeamFinder::find(const std::vector<cv::UMat> &src,
+                                      const std::vector<cv::Point> &corners,
+                                      std::vector<cv::UMat> &masks) {
+  LOG(INFO) << "Finding seams in parallel...";
+  if (src.size() == 0) {
+    return;
+  }
+  int64 start = cv::getTickCount();
+  std::vector<cv::Size> sizes(src.size());
+  for (size_t i = 0; i < src.size(); ++i) {
+    sizes[i] = src[i].size();
+  }
+  auto rounds =
+      ScheduleRounds(SerialPairs(corners, sizes, _order), corners, sizes);
+  for (const auto &pairs : rounds) {
+#pragma omp parallel for schedule(dynamic)
+    for (int k = 0; k < (int)pairs.size(); ++k) {
+      const int i = pairs[k].first, j = pairs[k].second;
+      std::vector<cv::UMat> pair_src{src[i], src[j]};
+      std::vector<cv::Point> pair_corners{corners[i], corners[j]};
+      // UMat浅拷贝，查找器直接修改原掩码
+      std::vector<cv::UMat> pair_masks{masks[i], masks[j]};
+      _creator()->find(pair_src, pair_corners, pair_masks);
+      if (pair_masks[0].u != masks[i].u) {
+        pair_masks[0].copyTo(masks[i]);
+      }
+      if (pair_masks[1].u != masks[j].u) {
+        pair_masks[1].copyTo(masks[j]);
+      }
+    }
+  }
+  LOG(INFO) << "Finding seams in parallel, " << rounds.size()
+            << " rounds, time: "
+            << ((cv::getTickCount() - start) / cv::getTickFrequency())
+            << " sec";
+}
+}  // namespace ImageStitch
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <functional>
+#include <utility>
+#include <vector>
+
+#include "../common/cvTypeDef.hpp"
+
+namespace ImageStitch {
+
+/**
+ * @brief 并行的逐对拼接缝查找器。
+ * GraphCutSeamFinder等逐对查找器串行处理每一对重叠图像，每一对只读写这两张图像
+ * 的掩码。这里把所有重叠图像对分成若干轮，同一轮内的图像对不共享图像，因此可以
+ * 并行处理；每张图像参与的图像对仍按串行查找器的先后顺序处理，所以order必须与
+ * creator创建的查找器一致：GraphCutSeamFinder按字典序，DpSeamFinder按图像中心
+ * 距离从远到近。顺序一致时结果与串行相同。
+ * 每一对都交给creator新建的查找器处理，查找器之间不共享状态。
+ */
+class ParallelPairwiseSeamFinder : public cv::detail::SeamFinder {
+ public:
+  using Creator = std::function<cv::Ptr<cv::detail::SeamFinder>()>;
+  using Pair = std::pair<int, int>;
+  enum Order { LEXICOGRAPHIC = 0, DP = 1 };
+
+ public:
+  explicit ParallelPairwiseSeamFinder(Creator creator,
+                                      Order order = LEXICOGRAPHIC);
+  void find(const std::vector<cv::UMat> &src,
+            const std::vector<cv::Point> &corners,
+            std::vector<cv::UMat> &masks) override;
+  /**
+   * @brief 按串行查找器的顺序列出全部图像对。
+   * DP顺序与cv::detail::DpSeamFinder::find相同：按图像中心距离的平方用std::sort
+   * 排序后反转。std::sort不稳定，这里对同样的输入调用同样的排序，距离相同的
+   * 图像对也保持相同的先后。
+   */
+  static auto SerialPairs(const std::vector<cv::Point> &corners,
+                          const std::vector<cv::Size> &sizes, Order order)
+      -> std::vector<Pair>;
+  /**
+   * @brief 按给定的串行顺序把有重叠的图像对分轮，同一轮内的图像对互不冲突，
+   * 每张图像参与的图像对保持原来的先后。
+   *
+   * @param pairs 串行查找器处理图像对的顺序
+   * @param corners
+   * @param sizes
+   * @return std::vector<std::vector<Pair>>
+   */
+  static auto ScheduleRounds(const std::vector<Pair> &pairs,
+                             const std::vector<cv::Point> &corners,
+                             const std::vector<cv::Size> &sizes)
+      -> std::vector<std::vector<Pair>>;
+  /**
+   * @brief 按字典序分轮
+   */
+  static auto ScheduleRounds(const std::vector<cv::Point> &corners,
+                             const std::vector<cv::Size> &sizes)
+      -> std::vector<std::vector<Pair>>;
+
+ private:
+  Creator _creator;
+  Order _order;
+};
+}  // namespace ImageStitch
@@ -0,0 +1,52 @@
+#include "previewCanvas.hpp"
+
+#include <algorithm>
+
+namespace ImageStitch {
+
+auto PreviewCanvas::Prepare(const cv::Rect &dst_roi) -> void {
+  _roi = dst_roi;
+  _scale = (std::min)(1.0, double(kMaxSide) /
+                               (std::max)(dst_roi.width, dst_roi.height));
+  _canvas = Image::zeros((std::max)(1, cvRound(dst_roi.height * _scale)),
+                         (std::max)(1, cvRound(dst_roi.width * _scale)),
+                         CV_8UC3);
+  _last = std::chrono::steady_clock::time_point();
+}
+
+auto PreviewCanvas::Feed(cv::InputArray img, cv::InputArray mask,
+                         cv::Point tl) -> void {
+  if (_canvas.empty() || img.empty()) {
+    return;
+  }
+  const cv::Size img_size = img.size();
+  cv::Rect dst(cvRound((tl.x - _roi.x) * _scale),
+               cvRound((tl.y - _roi.y) * _scale),
+               (std::max)(1, cvRound(img_size.width * _scale)),
+               (std::max)(1, cvRound(img_size.height * _scale)));
+  cv::Rect clipped = dst & cv::Rect(0, 0, _canvas.cols, _canvas.rows);
+  if (clipped.empty()) {
+    return;
+  }
+  Mat small, small_mask;
+  cv::resize(img, small, dst.size(), 0, 0, cv::INTER_AREA);
+  cv::resize(mask, small_mask, dst.size(), 0, 0, cv::INTER_NEAREST);
+  // 融合器的输入是CV_16S，饱和转换回8位
+  small.convertTo(small, CV_8U);
+  cv::Rect src(clipped.tl() - dst.tl(), clipped.size());
+  small(src).copyTo(_canvas(clipped), small_mask(src));
+}
+
+auto PreviewCanvas::Due() -> bool {
+  auto now = std::chrono::steady_clock::now();
+  if (now - _last < std::chrono::milliseconds(kIntervalMs)) {
+    return false;
+  }
+  _last = now;
+  return true;
+}
+
+auto PreviewCanvas::Preview() const -> ImagePtr {
+  return new Image(_canvas.clone());
+}
+}  // namespace ImageStitch
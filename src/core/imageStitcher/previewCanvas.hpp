@@ -0,0 +1,43 @@
+#pragma once
+
+#include <chrono>
+
+#include "../common/cvTypeDef.hpp"
+
+namespace ImageStitch {
+
+/**
+ * @brief 融合进度预览。
+ * 把送入融合器的投影图像缩小后直接覆盖到低分辨率画布上，不做融合，
+ * 只用于在最终结果出来前尽早显示全景的大致样子。
+ */
+class PreviewCanvas {
+ public:
+  static constexpr int kMaxSide = 2048;
+  static constexpr int kIntervalMs = 250;
+
+  /**
+   * @brief 按全景范围创建画布，长边不超过kMaxSide
+   */
+  auto Prepare(const cv::Rect &dst_roi) -> void;
+  /**
+   * @brief 缩小后按掩码覆盖到画布上，超出画布的部分被裁掉
+   *
+   * @param img 融合器的输入，CV_16S或8位
+   * @param mask
+   * @param tl 在全景中的左上角
+   */
+  auto Feed(cv::InputArray img, cv::InputArray mask, cv::Point tl) -> void;
+  /**
+   * @brief 距离上次发出预览已超过节流间隔
+   */
+  auto Due() -> bool;
+  auto Preview() const -> ImagePtr;
+
+ private:
+  cv::Rect _roi;
+  double _scale = 1.0;
+  Image _canvas;
+  std::chrono::steady_clock::time_point _last;
+};
+}  // namespace ImageStitch
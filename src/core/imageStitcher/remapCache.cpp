@@ -0,0 +1,205 @@
+#include "remapCache.hpp"
+
+#include <glog/logging.h>
+
+#include <cstring>
+#include <fstream>
+
+#include "../common/matIO.hpp"
+
+namespace ImageStitch {
+
+namespace {
+const char kRemapCacheMagic[4] = {'I', 'S', 'R', 'C'};
+const int32_t kRemapCacheVersion = 1;
+
+void AppendMat(std::string &key, cv::InputArray array) {
+  Mat mat;
+  array.getMat().convertTo(mat, CV_32F);
+  mat = mat.reshape(1, 1).clone();
+  key.append(reinterpret_cast<const char *>(mat.data),
+             mat.total() * mat.elemSize());
+}
+}  // namespace
+
+RemapCache::RemapCache(size_t max_bytes)
+    : _max_bytes(max_bytes), _bytes(0), _dirty(false) {}
+
+auto RemapCache::FixedPointApplicable(int depth, int interp_mode) -> bool {
+  return depth == CV_8U && (interp_mode & cv::INTER_MAX) != cv::INTER_NEAREST;
+}
+
+auto RemapCache::ToFixedPoint(Entry &entry) -> void {
+  Mat xy_map, interp_table;
+  cv::convertMaps(entry.xmap, entry.ymap, xy_map, interp_table, CV_16SC2);
+  entry.xmap = xy_map;
+  entry.ymap = interp_table;
+}
+
+auto RemapCache::MakeKey(cv::Size src_size, cv::InputArray K, cv::InputArray R,
+                         const std::string &warper_type, float scale) -> Key {
+  Key key;
+  key.reserve(warper_type.size() + 96);
+  key.append(warper_type);
+  key.push_back('\0');
+  key.append(reinterpret_cast<const char *>(&src_size.width), sizeof(int));
+  key.append(reinterpret_cast<const char *>(&src_size.height), sizeof(int));
+  key.append(reinterpret_cast<const char *>(&scale), sizeof(float));
+  AppendMat(key, K);
+  AppendMat(key, R);
+  return key;
+}
+
+auto RemapCache::Find(const Key &key, Entry &entry) -> bool {
+  std::lock_guard<std::mutex> locker(_mutex);
+  auto item = _index.find(key);
+  if (item == _index.end()) {
+    return false;
+  }
+  // 最近使用的放到队首
+  _items.splice(_items.begin(), _items, item->second);
+  entry = item->second->second;
+  return true;
+}
+
+auto RemapCache::Insert(const Key &key, const Entry &entry) -> void {
+  size_t bytes = EntryBytes(entry);
+  std::lock_guard<std::mutex> locker(_mutex);
+  if (bytes > _max_bytes) {
+    return;
+  }
+  auto item = _index.find(key);
+  if (item != _index.end()) {
+    _bytes -= EntryBytes(item->second->second);
+    _items.erase(item->second);
+    _index.erase(item);
+  }
+  _items.emplace_front(key, entry);
+  _index[key] = _items.begin();
+  _bytes += bytes;
+  _dirty = true;
+  Evict();
+}
+
+auto RemapCache::Clear() -> void {
+  std::lock_guard<std::mutex> locker(_mutex);
+  _items.clear();
+  _index.clear();
+  _bytes = 0;
+  _dirty = false;
+}
+
+auto RemapCache::Save(const std::string &file_name) -> bool {
+  std::lock_guard<std::mutex> locker(_mutex);
+  std::ofstream out(file_name, std::ios::binary);
+  if (!out.is_open()) {
+    LOG(WARNING) << "Couldn't open remap cache file : " << file_name;
+    return false;
+  }
+  out.write(kRemapCacheMagic, sizeof(kRemapCacheMagic));
+  WritePod(out, kRemapCacheVersion);
+  WritePod<int32_t>(out, _items.size());
+  // 从最久未使用的开始写，读回时按顺序插入可以还原LRU顺序
+  for (auto item = _items.rbegin(); item != _items.rend(); ++item) {
+    WritePod<int32_t>(out, item->first.size());
+    out.write(item->first.data(), item->first.size());
+    WritePod<int32_t>(out, item->second.roi.x);
+    WritePod<int32_t>(out, item->second.roi.y);
+    WritePod<int32_t>(out, item->second.roi.width);
+    WritePod<int32_t>(out, item->second.roi.height);
+    WriteMat(out, item->second.xmap);
+    WriteMat(out, item->second.ymap);
+  }
+  if (!out.good()) {
+    LOG(WARNING) << "Write remap cache failed : " << file_name;
+    return false;
+  }
+  _dirty = false;
+  LOG(INFO) << "Remap cache saved : " << file_name << " (" << _items.size()
+            << " entries, " << _bytes << " bytes)";
+  return true;
+}
+
+auto RemapCache::Load(const std::string &file_name) -> bool {
+  std::ifstream in(file_name, std::ios::binary);
+  if (!in.is_open()) {
+    LOG(WARNING) << "Couldn't open remap cache file : " << file_name;
+    return false;
+  }
+  char magic[sizeof(kRemapCacheMagic)];
+  int32_t version, count;
+  in.read(magic, sizeof(magic));
+  if (!in.good() ||
+      std::memcmp(magic, kRemapCacheMagic, sizeof(kRemapCacheMagic)) != 0 ||
+      !ReadPod(in, version) || version != kRemapCacheVersion ||
+      !ReadPod(in, count)) {
+    LOG(WARNING) << "Invalid remap cache file : " << file_name;
+    return false;
+  }
+  for (int i = 0; i < count; ++i) {
+    int32_t key_size;
+    if (!ReadPod(in, key_size) || key_size < 0) {
+      return false;
+    }
+    Key key(key_size, '\0');
+    in.read(&key[0], key_size);
+    Entry entry;
+    if (!ReadPod(in, entry.roi.x) || !ReadPod(in, entry.roi.y) ||
+        !ReadPod(in, entry.roi.width) || !ReadPod(in, entry.roi.height) ||
+        !ReadMat(in, entry.xmap) || !ReadMat(in, entry.ymap)) {
+      LOG(WARNING) << "Remap cache file truncated : " << file_name;
+      return false;
+    }
+    Insert(key, entry);
+  }
+  std::lock_guard<std::mutex> locker(_mutex);
+  _dirty = false;
+  LOG(INFO) << "Remap cache loaded : " << file_name << " (" << _items.size()
+            << " entries, " << _bytes << " bytes)";
+  return true;
+}
+
+auto RemapCache::SetMemoryLimit(size_t max_bytes) -> void {
+  std::lock_guard<std::mutex> locker(_mutex);
+  _max_bytes = max_bytes;
+  Evict();
+}
+
+auto RemapCache::MemoryLimit() const -> size_t {
+  std::lock_guard<std::mutex> locker(_mutex);
+  return _max_bytes;
+}
+
+auto RemapCache::MemoryUsage() const -> size_t {
+  std::lock_guard<std::mutex> locker(_mutex);
+  return _bytes;
+}
+
+auto RemapCache::Size() const -> size_t {
+  std::lock_guard<std::mutex> locker(_mutex);
+  return _items.size();
+}
+
+auto RemapCache::Enabled() const -> bool {
+  std::lock_guard<std::mutex> locker(_mutex);
+  return _max_bytes > 0;
+}
+
+auto RemapCache::Dirty() const -> bool {
+  std::lock_guard<std::mutex> locker(_mutex);
+  return _dirty;
+}
+
+auto RemapCache::EntryBytes(const Entry &entry) -> size_t {
+  return entry.xmap.total() * entry.xmap.elemSize() +
+         entry.ymap.total() * entry.ymap.elemSize();
+}
+
+auto RemapCache::Evict() -> void {
+  while (_bytes > _max_bytes && !_items.empty()) {
+    _bytes -= EntryBytes(_items.back().second);
+    _index.erase(_items.back().first);
+    _items.pop_back();
+  }
+}
+}  // namespace ImageStitch
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "../common/cvTypeDef.hpp"
+
+namespace ImageStitch {
+
+/**
+ * @brief 投影映射表缓存。
+ * 以(源图尺寸, K, R, 投影类型, 缩放系数)为键缓存RotationWarper::buildMaps
+ * 生成的xmap/ymap，相机几何不变时直接通过remap复用，避免逐像素重复计算投影。
+ * 缓存按字节数做LRU淘汰，并可以保存到磁盘供下次启动使用。
+ */
+class RemapCache {
+ public:
+  using Key = std::string;
+  struct Entry {
+    cv::Rect roi;
+    Mat xmap;
+    Mat ymap;
+  };
+
+ public:
+  explicit RemapCache(size_t max_bytes = 0);
+  static auto MakeKey(cv::Size src_size, cv::InputArray K, cv::InputArray R,
+                      const std::string &warper_type, float scale) -> Key;
+  /**
+   * @brief 定点映射表只用于8位图像的非最近邻插值。CV_16SC2的整数部分向下取整，
+   * 最近邻插值(如掩码投影)会偏移一个像素，仍使用浮点映射表
+   */
+  static auto FixedPointApplicable(int depth, int interp_mode) -> bool;
+  /**
+   * @brief 把浮点映射表转换为CV_16SC2定点格式，线性插值的误差不超过1/32像素
+   */
+  static auto ToFixedPoint(Entry &entry) -> void;
+  auto Find(const Key &key, Entry &entry) -> bool;
+  auto Insert(const Key &key, const Entry &entry) -> void;
+  auto Clear() -> void;
+  auto Save(const std::string &file_name) -> bool;
+  auto Load(const std::string &file_name) -> bool;
+  auto SetMemoryLimit(size_t max_bytes) -> void;
+  auto MemoryLimit() const -> size_t;
+  auto MemoryUsage() const -> size_t;
+  auto Size() const -> size_t;
+  auto Enabled() const -> bool;
+  auto Dirty() const -> bool;
+
+ private:
+  using Item = std::pair<Key, Entry>;
+  static auto EntryBytes(const Entry &entry) -> size_t;
+  auto Evict() -> void;
+
+ private:
+  mutable std::mutex _mutex;
+  std::list<Item> _items;
+  std::unordered_map<Key, std::list<Item>::iterator> _index;
+  size_t _max_bytes;
+  size_t _bytes;
+  bool _dirty;
+};
+}  // namespace ImageStitch
@@ -0,0 +1,152 @@
+#include "rigCalibration.hpp"
+
+#include <glog/logging.h>
+
+#include <cstring>
+#include <fstream>
+
+#include "../common/matIO.hpp"
+
+namespace ImageStitch {
+
+namespace {
+const char kRigMagic[4] = {'I', 'S', 'R', 'G'};
+const int32_t kRigVersion = 1;
+
+void WriteString(std::ofstream &out, const std::string &str) {
+  WritePod<int32_t>(out, str.size());
+  out.write(str.data(), str.size());
+}
+bool ReadString(std::ifstream &in, std::string &str) {
+  int32_t size;
+  if (!ReadPod(in, size) || size < 0) {
+    return false;
+  }
+  str.assign(size, '\0');
+  in.read(&str[0], size);
+  return in.good();
+}
+}  // namespace
+
+auto RigCalibration::Valid() const -> bool {
+  size_t n = indices.size();
+  return n > 0 && frame_count > 0 && frame_sizes.size() == n &&
+         corners.size() == n && sizes.size() == n && xmaps.size() == n &&
+         ymaps.size() == n && masks.size() == n;
+}
+
+auto RigCalibration::Clear() -> void {
+  frame_count = 0;
+  indices.clear();
+  frame_sizes.clear();
+  cameras.clear();
+  compose_scale = 1.0;
+  corners.clear();
+  sizes.clear();
+  xmaps.clear();
+  ymaps.clear();
+  masks.clear();
+  gains.clear();
+  exposure_compensator_name.clear();
+  blender_name.clear();
+  exposure_compensator.release();
+  blender.release();
+}
+
+auto RigCalibration::Save(const std::string &file_name) const -> bool {
+  if (!Valid()) {
+    LOG(WARNING) << "Rig calibration is empty, nothing to save";
+    return false;
+  }
+  std::ofstream out(file_name, std::ios::binary);
+  if (!out.is_open()) {
+    LOG(WARNING) << "Couldn't open rig calibration file : " << file_name;
+    return false;
+  }
+  out.write(kRigMagic, sizeof(kRigMagic));
+  WritePod(out, kRigVersion);
+  WritePod<int32_t>(out, frame_count);
+  WritePod<int32_t>(out, indices.size());
+  WritePod(out, compose_scale);
+  WritePod<int32_t>(out, interp_flags);
+  WriteString(out, exposure_compensator_name);
+  WriteString(out, blender_name);
+  for (size_t i = 0; i < indices.size(); ++i) {
+    WritePod<int32_t>(out, indices[i]);
+    WritePod<int32_t>(out, frame_sizes[i].width);
+    WritePod<int32_t>(out, frame_sizes[i].height);
+    WritePod<int32_t>(out, corners[i].x);
+    WritePod<int32_t>(out, corners[i].y);
+    WritePod<int32_t>(out, sizes[i].width);
+    WritePod<int32_t>(out, sizes[i].height);
+    const auto &camera =
+        i < cameras.size() ? cameras[i] : cv::detail::CameraParams();
+    WritePod(out, camera.focal);
+    WritePod(out, camera.aspect);
+    WritePod(out, camera.ppx);
+    WritePod(out, camera.ppy);
+    WriteMat(out, camera.R);
+    WriteMat(out, camera.t);
+    WriteMat(out, xmaps[i]);
+    WriteMat(out, ymaps[i]);
+    WriteMat(out, masks[i]);
+    WriteMat(out, i < gains.size() ? gains[i] : Mat());
+  }
+  if (!out.good()) {
+    LOG(WARNING) << "Write rig calibration failed : " << file_name;
+    return false;
+  }
+  LOG(INFO) << "Rig calibration saved : " << file_name;
+  return true;
+}
+
+auto RigCalibration::Load(const std::string &file_name) -> bool {
+  Clear();
+  std::ifstream in(file_name, std::ios::binary);
+  if (!in.is_open()) {
+    LOG(WARNING) << "Couldn't open rig calibration file : " << file_name;
+    return false;
+  }
+  char magic[sizeof(kRigMagic)];
+  int32_t version, count;
+  in.read(magic, sizeof(magic));
+  if (!in.good() || std::memcmp(magic, kRigMagic, sizeof(kRigMagic)) != 0 ||
+      !ReadPod(in, version) || version != kRigVersion ||
+      !ReadPod(in, frame_count) || !ReadPod(in, count) || count < 0 ||
+      !ReadPod(in, compose_scale) || !ReadPod(in, interp_flags) ||
+      !ReadString(in, exposure_compensator_name) ||
+      !ReadString(in, blender_name)) {
+    LOG(WARNING) << "Invalid rig calibration file : " << file_name;
+    Clear();
+    return false;
+  }
+  indices.resize(count);
+  frame_sizes.resize(count);
+  cameras.resize(count);
+  corners.resize(count);
+  sizes.resize(count);
+  xmaps.resize(count);
+  ymaps.resize(count);
+  masks.resize(count);
+  gains.resize(count);
+  for (int i = 0; i < count; ++i) {
+    auto &camera = cameras[i];
+    if (!ReadPod(in, indices[i]) || !ReadPod(in, frame_sizes[i].width) ||
+        !ReadPod(in, frame_sizes[i].height) || !ReadPod(in, corners[i].x) ||
+        !ReadPod(in, corners[i].y) || !ReadPod(in, sizes[i].width) ||
+        !ReadPod(in, sizes[i].height) || !ReadPod(in, camera.focal) ||
+        !ReadPod(in, camera.aspect) || !ReadPod(in, camera.ppx) ||
+        !ReadPod(in, camera.ppy) || !ReadMat(in, camera.R) ||
+        !ReadMat(in, camera.t) || !ReadMat(in, xmaps[i]) ||
+        !ReadMat(in, ymaps[i]) || !ReadMat(in, masks[i]) ||
+        !ReadMat(in, gains[i])) {
+      LOG(WARNING) << "Rig calibration file truncated : " << file_name;
+      Clear();
+      return false;
+    }
+  }
+  LOG(INFO) << "Rig calibration loaded : " << file_name << " (" << count
+            << " cameras)";
+  return true;
+}
+}  // namespace ImageStitch
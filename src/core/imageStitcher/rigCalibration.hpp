@@ -0,0 +1,41 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "../common/cvTypeDef.hpp"
+
+namespace ImageStitch {
+
+/**
+ * @brief 固定机位拼接的标定结果。
+ * 标定时记录相机参数、融合分辨率下的投影映射表、拼接缝掩码与曝光增益，
+ * 之后的帧组只需按映射表投影、补偿并融合，不再做特征提取、匹配和参数估计。
+ */
+struct RigCalibration {
+  // 标定时输入的帧数，以及参与拼接的帧下标(对应component)
+  int frame_count = 0;
+  std::vector<int> indices;
+  std::vector<cv::Size> frame_sizes;
+  std::vector<CameraParams> cameras;
+  double compose_scale = 1.0;
+  int interp_flags = cv::INTER_LINEAR;
+  std::vector<cv::Point> corners;
+  std::vector<cv::Size> sizes;
+  std::vector<Mat> xmaps;
+  std::vector<Mat> ymaps;
+  std::vector<Mat> masks;
+  std::vector<Mat> gains;
+  std::string exposure_compensator_name;
+  std::string blender_name;
+
+  // 运行期对象，不参与保存
+  cv::Ptr<cv::detail::ExposureCompensator> exposure_compensator;
+  cv::Ptr<cv::detail::Blender> blender;
+
+  auto Valid() const -> bool;
+  auto Clear() -> void;
+  auto Save(const std::string &file_name) const -> bool;
+  auto Load(const std::string &file_name) -> bool;
+};
+}  // namespace ImageStitch
@@ -0,0 +1,102 @@
+#include "seamCache.hpp"
+
+#include <glog/logging.h>
+
+namespace ImageStitch {
+
+auto SeamCache::ChangedImages(const std::vector<uint64_t> &hashes,
+                              const std::vector<cv::Point> &corners,
+                              std::vector<int> &changed) const -> bool {
+  changed.clear();
+  if (_hashes.empty() || hashes.size() != _hashes.size() ||
+      corners.size() != _corners.size()) {
+    return false;
+  }
+  for (int i = 0; i < (int)hashes.size(); ++i) {
+    if (hashes[i] != _hashes[i] || corners[i] != _corners[i]) {
+      changed.push_back(i);
+    }
+  }
+  return true;
+}
+
+auto SeamCache::Refind(cv::detail::SeamFinder &finder,
+                       const std::vector<cv::UMat> &src,
+                       const std::vector<cv::Point> &corners,
+                       std::vector<cv::UMat> &masks,
+                       const std::vector<int> &changed) const -> void {
+  const int n = src.size();
+  std::vector<bool> is_changed(n, false);
+  for (int c : changed) {
+    is_changed[c] = true;
+  }
+  std::vector<Mat> input_masks(n);
+  for (int i = 0; i < n; ++i) {
+    if (!is_changed[i]) {
+      input_masks[i] = masks[i].getMat(cv::ACCESS_READ).clone();
+      _masks[i].copyTo(masks[i]);
+    }
+  }
+  // 旧图像占据的像素重新交给未变化的邻居参与查找
+  for (int c : changed) {
+    cv::Rect old_rect(_corners[c], _masks[c].size());
+    for (int i = 0; i < n; ++i) {
+      if (is_changed[i]) {
+        continue;
+      }
+      cv::Rect roi = old_rect & cv::Rect(corners[i], masks[i].size());
+      if (roi.empty()) {
+        continue;
+      }
+      Mat reopen;
+      cv::bitwise_and(_masks[c](roi - _corners[c]),
+                      input_masks[i](roi - corners[i]), reopen);
+      Mat mask = masks[i].getMat(cv::ACCESS_RW);
+      mask(roi - corners[i]).setTo(cv::Scalar::all(255), reopen);
+    }
+  }
+  int pair_count = 0;
+  for (int i = 0; i < n; ++i) {
+    for (int j = i + 1; j < n; ++j) {
+      cv::Rect roi;
+      if ((!is_changed[i] && !is_changed[j]) ||
+          !cv::detail::overlapRoi(corners[i], corners[j], src[i].size(),
+                                  src[j].size(), roi)) {
+        continue;
+      }
+      std::vector<cv::UMat> pair_src{src[i], src[j]};
+      std::vector<cv::Point> pair_corners{corners[i], corners[j]};
+      std::vector<cv::UMat> pair_masks{masks[i], masks[j]};
+      finder.find(pair_src, pair_corners, pair_masks);
+      if (pair_masks[0].u != masks[i].u) {
+        pair_masks[0].copyTo(masks[i]);
+      }
+      if (pair_masks[1].u != masks[j].u) {
+        pair_masks[1].copyTo(masks[j]);
+      }
+      ++pair_count;
+    }
+  }
+  LOG(INFO) << "Seams refound for " << changed.size() << " changed images, "
+            << pair_count << " pairs";
+}
+
+auto SeamCache::Update(const std::vector<uint64_t> &hashes,
+                       const std::vector<cv::Point> &corners,
+                       const std::vector<cv::UMat> &masks) -> void {
+  _hashes = hashes;
+  _corners = corners;
+  _masks.resize(masks.size());
+  for (size_t i = 0; i < masks.size(); ++i) {
+    _masks[i] = masks[i].getMat(cv::ACCESS_READ).clone();
+  }
+}
+
+auto SeamCache::Clear() -> void {
+  _hashes.clear();
+  _corners.clear();
+  _masks.clear();
+}
+
+auto SeamCache::Empty() const -> bool { return _hashes.empty(); }
+}  // namespace ImageStitch
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "../common/cvTypeDef.hpp"
+
+namespace ImageStitch {
+
+/**
+ * @brief 拼接缝缓存。
+ * 记录上一次查找时每张图像的内容哈希、位置和最终的拼接缝掩码。只有少数图像
+ * 被替换时，其余图像直接复用缓存的掩码，只对与被替换图像重叠的图像对重新查找。
+ */
+class SeamCache {
+ public:
+  /**
+   * @brief 对比缓存，找出内容或位置变化的图像。
+   *
+   * @param hashes 每张图像的哈希
+   * @param corners
+   * @param changed 变化的图像下标
+   * @return bool 缓存为空或图像数量不同时无法比较，返回false
+   */
+  auto ChangedImages(const std::vector<uint64_t> &hashes,
+                     const std::vector<cv::Point> &corners,
+                     std::vector<int> &changed) const -> bool;
+  /**
+   * @brief
+   * 未变化的图像恢复缓存的掩码；与变化图像重叠的区域中，原先属于旧图像的像素
+   * 重新放开，然后只对涉及变化图像的重叠图像对逐对调用finder。
+   * 结果与全量查找不完全一致，但接缝只在变化图像附近改变。
+   */
+  auto Refind(cv::detail::SeamFinder &finder,
+              const std::vector<cv::UMat> &src,
+              const std::vector<cv::Point> &corners,
+              std::vector<cv::UMat> &masks,
+              const std::vector<int> &changed) const -> void;
+  auto Update(const std::vector<uint64_t> &hashes,
+              const std::vector<cv::Point> &corners,
+              const std::vector<cv::UMat> &masks) -> void;
+  auto Clear() -> void;
+  auto Empty() const -> bool;
+
+ private:
+  std::vector<uint64_t> _hashes;
+  std::vector<cv::Point> _corners;
+  std::vector<Mat> _masks;
+};
+}  // namespace ImageStitch
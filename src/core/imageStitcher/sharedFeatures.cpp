@@ -0,0 +1,51 @@
+#include "sharedFeatures.hpp"
+
+#include <algorithm>
+
+namespace ImageStitch {
+
+auto SharedFeatureDetector(const cv::Ptr<Feature2D> &detector,
+                           int strip_count) -> cv::Ptr<Feature2D> {
+  if (detector.empty()) {
+    return detector;
+  }
+  if (auto orb = detector.dynamicCast<cv::ORB>(); !orb.empty()) {
+    // 新建检测器，不修改并行使用中的原检测器
+    return cv::ORB::create(orb->getMaxFeatures() * (std::max)(1, strip_count),
+                           orb->getScaleFactor(), orb->getNLevels(),
+                           orb->getEdgeThreshold(), orb->getFirstLevel(),
+                           orb->getWTA_K(), orb->getScoreType(),
+                           orb->getPatchSize(), orb->getFastThreshold());
+  }
+  const auto name = detector->getDefaultName();
+  if (name == "Feature2D.AKAZE" || name == "Feature2D.KAZE" ||
+      name == "Feature2D.BRISK" || name == "Feature2D.SURF") {
+    return detector;
+  }
+  return cv::Ptr<Feature2D>();
+}
+
+auto SplitFeatures(const KeyPoints &keypoints, const Mat &descriptors,
+                   const std::vector<cv::Rect2f> &areas,
+                   std::vector<KeyPoints> &strip_keypoints,
+                   std::vector<Mat> &strip_descriptors) -> void {
+  strip_keypoints.assign(areas.size(), KeyPoints());
+  strip_descriptors.assign(areas.size(), Mat());
+  for (size_t i = 0; i < areas.size(); ++i) {
+    std::vector<int> rows;
+    for (int k = 0; k < (int)keypoints.size(); ++k) {
+      if (areas[i].contains(keypoints[k].pt)) {
+        KeyPoint keypoint = keypoints[k];
+        keypoint.pt -= areas[i].tl();
+        strip_keypoints[i].push_back(keypoint);
+        rows.push_back(k);
+      }
+    }
+    strip_descriptors[i].create(rows.size(), descriptors.cols,
+                                descriptors.type());
+    for (int r = 0; r < (int)rows.size(); ++r) {
+      descriptors.row(rows[r]).copyTo(strip_descriptors[i].row(r));
+    }
+  }
+}
+}  // namespace ImageStitch
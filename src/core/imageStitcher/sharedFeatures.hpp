@@ -0,0 +1,35 @@
+#pragma once
+
+#include <vector>
+
+#include "../common/cvTypeDef.hpp"
+
+namespace ImageStitch {
+
+/**
+ * @brief 在整张原图上一次提取所有条带的特征时使用的检测器。
+ * 有特征数量上限的检测器(ORB)按条带数放大上限，每个条带得到的特征数与单独提取
+ * 时相当；没有上限的(AKAZE、KAZE、BRISK、SURF)直接复用；无法确定上限的(如SIFT)
+ * 返回空，调用方应逐条带提取。
+ *
+ * @param detector
+ * @param strip_count 同一张原图切出的条带数
+ * @return cv::Ptr<Feature2D>
+ */
+auto SharedFeatureDetector(const cv::Ptr<Feature2D> &detector,
+                           int strip_count) -> cv::Ptr<Feature2D>;
+/**
+ * @brief 把原图上提取的特征按条带区域分配，坐标换算到条带内，描述子按行对应。
+ * 落在重叠区域的特征同时分给每个包含它的条带。
+ *
+ * @param keypoints 原图(缩放到条带尺度后)上的特征点
+ * @param descriptors 与keypoints逐行对应的描述子
+ * @param areas 各条带在缩放后原图中的区域
+ * @param strip_keypoints
+ * @param strip_descriptors
+ */
+auto SplitFeatures(const KeyPoints &keypoints, const Mat &descriptors,
+                   const std::vector<cv::Rect2f> &areas,
+                   std::vector<KeyPoints> &strip_keypoints,
+                   std::vector<Mat> &strip_descriptors) -> void;
+}  // namespace ImageStitch
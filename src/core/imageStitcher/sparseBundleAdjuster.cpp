@@ -0,0 +1,344 @@
+#include "sparseBundleAdjuster.hpp"
+
+#include <glog/logging.h>
+#include <omp.h>
+
+#include <Eigen/Dense>
+#include <Eigen/Sparse>
+#include <cfloat>
+#include <cmath>
+
+namespace ImageStitch {
+
+namespace {
+const double kInitialLambda = 1e-3;
+const double kMaxLambda = 1e12;
+
+// 仿射模型的参数转换为2x3矩阵
+cv::Matx33d AffineMatrix(const double *params, bool partial) {
+  if (partial) {
+    return cv::Matx33d(params[0], -params[1], params[2], params[1], params[0],
+                       params[3], 0, 0, 1);
+  }
+  return cv::Matx33d(params[0], params[1], params[2], params[3], params[4],
+                     params[5], 0, 0, 1);
+}
+
+// 射线模型：焦距和旋转向量
+cv::Matx33d RayMatrix(const double *params, const cv::Size &img_size) {
+  cv::Matx33d R;
+  cv::Rodrigues(cv::Vec3d(params[1], params[2], params[3]), R);
+  cv::Matx33d K(params[0], 0, img_size.width * 0.5, 0, params[0],
+                img_size.height * 0.5, 0, 0, 1);
+  return R * K.inv();
+}
+
+struct EdgeBlocks {
+  Eigen::MatrixXd H11, H22, H12;
+  Eigen::VectorXd g1, g2;
+};
+}  // namespace
+
+SparseBundleAdjuster::SparseBundleAdjuster(Model model)
+    : cv::detail::BundleAdjusterBase(model == AFFINE ? 6 : 4,
+                                     model == RAY ? 3 : 2),
+      _model(model) {}
+
+auto SparseBundleAdjuster::ParamsPerCamera() const -> int {
+  return _model == AFFINE ? 6 : 4;
+}
+
+auto SparseBundleAdjuster::ErrorsPerPoint() const -> int {
+  return _model == RAY ? 3 : 2;
+}
+
+auto SparseBundleAdjuster::SetUpParams(const std::vector<CameraParams> &cameras,
+                                       std::vector<double> &params) const
+    -> void {
+  const int p = ParamsPerCamera();
+  params.resize(cameras.size() * p);
+  for (size_t i = 0; i < cameras.size(); ++i) {
+    double *param = params.data() + i * p;
+    cv::Mat_<double> R;
+    cameras[i].R.convertTo(R, CV_64F);
+    switch (_model) {
+      case AFFINE:
+        for (int k = 0; k < 6; ++k) {
+          param[k] = R(k / 3, k % 3);
+        }
+        break;
+      case AFFINE_PARTIAL:
+        param[0] = R(0, 0);
+        param[1] = R(1, 0);
+        param[2] = R(0, 2);
+        param[3] = R(1, 2);
+        break;
+      case RAY: {
+        param[0] = cameras[i].focal;
+        cv::SVD svd(R, cv::SVD::FULL_UV);
+        Mat rotation = svd.u * svd.vt;
+        if (cv::determinant(rotation) < 0) {
+          rotation *= -1;
+        }
+        cv::Vec3d rvec;
+        cv::Rodrigues(rotation, rvec);
+        param[1] = rvec[0];
+        param[2] = rvec[1];
+        param[3] = rvec[2];
+        break;
+      }
+    }
+  }
+}
+
+auto SparseBundleAdjuster::RefinedCameras(const std::vector<double> &params,
+                                          std::vector<CameraParams> &cameras)
+    const -> void {
+  const int p = ParamsPerCamera();
+  for (size_t i = 0; i < cameras.size(); ++i) {
+    const double *param = params.data() + i * p;
+    if (_model == RAY) {
+      cameras[i].focal = param[0];
+      Mat R;
+      cv::Rodrigues(cv::Vec3d(param[1], param[2], param[3]), R);
+      R.convertTo(cameras[i].R, CV_32F);
+    } else {
+      Mat(AffineMatrix(param, _model == AFFINE_PARTIAL))
+          .convertTo(cameras[i].R, CV_32F);
+    }
+  }
+}
+
+auto SparseBundleAdjuster::EdgeErrors(const Edge &edge, const double *params1,
+                                      const double *params2, double *err) const
+    -> void {
+  if (_model == RAY) {
+    const cv::Matx33d H1 = RayMatrix(params1, _img_sizes[edge.i]);
+    const cv::Matx33d H2 = RayMatrix(params2, _img_sizes[edge.j]);
+    const double mult = std::sqrt(params1[0] * params2[0]);
+    for (size_t k = 0; k < edge.points1.size(); ++k) {
+      cv::Vec3d ray1 = H1 * cv::Vec3d(edge.points1[k].x, edge.points1[k].y, 1);
+      cv::Vec3d ray2 = H2 * cv::Vec3d(edge.points2[k].x, edge.points2[k].y, 1);
+      ray1 /= cv::norm(ray1);
+      ray2 /= cv::norm(ray2);
+      err[k * 3] = mult * (ray1[0] - ray2[0]);
+      err[k * 3 + 1] = mult * (ray1[1] - ray2[1]);
+      err[k * 3 + 2] = mult * (ray1[2] - ray2[2]);
+    }
+    return;
+  }
+  const bool partial = _model == AFFINE_PARTIAL;
+  const cv::Matx33d H = AffineMatrix(params1, partial).inv() *
+                        AffineMatrix(params2, partial);
+  for (size_t k = 0; k < edge.points1.size(); ++k) {
+    const auto &p1 = edge.points1[k];
+    const auto &p2 = edge.points2[k];
+    err[k * 2] = p1.x - (H(0, 0) * p2.x + H(0, 1) * p2.y + H(0, 2));
+    err[k * 2 + 1] = p1.y - (H(1, 0) * p2.x + H(1, 1) * p2.y + H(1, 2));
+  }
+}
+
+auto SparseBundleAdjuster::TotalCost(const std::vector<Edge> &edges,
+                                     const std::vector<double> &params) const
+    -> double {
+  const int p = ParamsPerCamera();
+  double cost = 0;
+#pragma omp parallel for reduction(+ : cost) schedule(dynamic)
+  for (int k = 0; k < (int)edges.size(); ++k) {
+    const auto &edge = edges[k];
+    std::vector<double> err(edge.points1.size() * ErrorsPerPoint());
+    EdgeErrors(edge, params.data() + edge.i * p, params.data() + edge.j * p,
+               err.data());
+    for (double value : err) {
+      cost += value * value;
+    }
+  }
+  return cost;
+}
+
+bool SparseBundleAdjuster::estimate(
+    const std::vector<ImageFeatures> &features,
+    const std::vector<MatchesInfo> &pairwise_matches,
+    std::vector<CameraParams> &cameras) {
+  LOG(INFO) << "Sparse bundle adjustment";
+  int64 start = cv::getTickCount();
+  const int n = features.size();
+  const int p = ParamsPerCamera();
+  const int e = ErrorsPerPoint();
+  // 与RAY模型的雅可比步长一致
+  const double step = _model == RAY ? 1e-3 : 1e-4;
+
+  _img_sizes.resize(n);
+  for (int i = 0; i < n; ++i) {
+    _img_sizes[i] = features[i].img_size;
+  }
+  std::vector<Edge> edges;
+  for (int i = 0; i < n; ++i) {
+    for (int j = i + 1; j < n; ++j) {
+      const MatchesInfo &matches_info = pairwise_matches[i * n + j];
+      if (matches_info.confidence < confThresh()) {
+        continue;
+      }
+      Edge edge{i, j};
+      for (size_t k = 0; k < matches_info.matches.size(); ++k) {
+        if (!matches_info.inliers_mask[k]) {
+          continue;
+        }
+        const cv::DMatch &m = matches_info.matches[k];
+        edge.points1.emplace_back(features[i].keypoints[m.queryIdx].pt);
+        edge.points2.emplace_back(features[j].keypoints[m.trainIdx].pt);
+      }
+      if (!edge.points1.empty()) {
+        edges.push_back(std::move(edge));
+      }
+    }
+  }
+  size_t total_points = 0;
+  for (const auto &edge : edges) {
+    total_points += edge.points1.size();
+  }
+  if (edges.empty()) {
+    LOG(WARNING) << "Sparse bundle adjustment has no consistent image pairs";
+    return true;
+  }
+
+  std::vector<double> params;
+  SetUpParams(cameras, params);
+  double cost = TotalCost(edges, params);
+  LOG(INFO) << "Sparse bundle adjustment initial RMS error: "
+            << std::sqrt(cost / total_points);
+
+  const cv::TermCriteria criteria = termCriteria();
+  const int max_iter = (criteria.type & cv::TermCriteria::COUNT)
+                           ? criteria.maxCount
+                           : 1000;
+  const double eps =
+      (criteria.type & cv::TermCriteria::EPS) ? criteria.epsilon : DBL_EPSILON;
+  Eigen::SimplicialLDLT<Eigen::SparseMatrix<double>> solver;
+  bool analyzed = false;
+  double lambda = kInitialLambda;
+  int iter = 0;
+  std::vector<EdgeBlocks> blocks(edges.size());
+  for (; iter < max_iter; ++iter) {
+    // 每条边只影响两台相机，分块数值求导
+#pragma omp parallel for schedule(dynamic)
+    for (int k = 0; k < (int)edges.size(); ++k) {
+      const auto &edge = edges[k];
+      const int m = edge.points1.size() * e;
+      std::vector<double> params1(params.begin() + edge.i * p,
+                                  params.begin() + (edge.i + 1) * p);
+      std::vector<double> params2(params.begin() + edge.j * p,
+                                  params.begin() + (edge.j + 1) * p);
+      Eigen::VectorXd err(m), err1(m), err2(m);
+      Eigen::MatrixXd J1(m, p), J2(m, p);
+      EdgeErrors(edge, params1.data(), params2.data(), err.data());
+      for (int c = 0; c < 2; ++c) {
+        auto &param = c == 0 ? params1 : params2;
+        auto &J = c == 0 ? J1 : J2;
+        for (int d = 0; d < p; ++d) {
+          const double value = param[d];
+          param[d] = value - step;
+          EdgeErrors(edge, params1.data(), params2.data(), err1.data());
+          param[d] = value + step;
+          EdgeErrors(edge, params1.data(), params2.data(), err2.data());
+          param[d] = value;
+          J.col(d) = (err2 - err1) / (2 * step);
+        }
+      }
+      auto &block = blocks[k];
+      block.H11 = J1.transpose() * J1;
+      block.H22 = J2.transpose() * J2;
+      block.H12 = J1.transpose() * J2;
+      block.g1 = J1.transpose() * err;
+      block.g2 = J2.transpose() * err;
+    }
+
+    std::vector<Eigen::Triplet<double>> triplets;
+    Eigen::VectorXd g = Eigen::VectorXd::Zero(n * p);
+    triplets.reserve(edges.size() * p * p * 4 + n * p);
+    for (int d = 0; d < n * p; ++d) {
+      triplets.emplace_back(d, d, 0.0);
+    }
+    for (size_t k = 0; k < edges.size(); ++k) {
+      const int o1 = edges[k].i * p, o2 = edges[k].j * p;
+      const auto &block = blocks[k];
+      for (int r = 0; r < p; ++r) {
+        for (int c = 0; c < p; ++c) {
+          triplets.emplace_back(o1 + r, o1 + c, block.H11(r, c));
+          triplets.emplace_back(o2 + r, o2 + c, block.H22(r, c));
+          triplets.emplace_back(o1 + r, o2 + c, block.H12(r, c));
+          triplets.emplace_back(o2 + c, o1 + r, block.H12(r, c));
+        }
+      }
+      g.segment(o1, p) += block.g1;
+      g.segment(o2, p) += block.g2;
+    }
+    Eigen::SparseMatrix<double> H(n * p, n * p);
+    H.setFromTriplets(triplets.begin(), triplets.end());
+    const Eigen::VectorXd diagonal = H.diagonal();
+
+    bool improved = false;
+    bool converged = false;
+    while (lambda < kMaxLambda) {
+      Eigen::SparseMatrix<double> A = H;
+      for (int d = 0; d < n * p; ++d) {
+        // 没有约束的参数(例如整体的仿射自由度)也保持正定
+        A.coeffRef(d, d) += lambda * (diagonal(d) + 1e-9);
+      }
+      if (!analyzed) {
+        solver.analyzePattern(A);
+        analyzed = true;
+      }
+      solver.factorize(A);
+      if (solver.info() != Eigen::Success) {
+        lambda *= 10;
+        continue;
+      }
+      Eigen::VectorXd delta = solver.solve(-g);
+      std::vector<double> new_params(params);
+      for (int d = 0; d < n * p; ++d) {
+        new_params[d] += delta(d);
+      }
+      double new_cost = TotalCost(edges, new_params);
+      if (std::isfinite(new_cost) && new_cost < cost) {
+        converged = (cost - new_cost) <= eps * cost ||
+                    delta.norm() <= eps * (Eigen::Map<Eigen::VectorXd>(
+                                               params.data(), params.size())
+                                               .norm() +
+                                           eps);
+        params.swap(new_params);
+        cost = new_cost;
+        lambda = std::max(lambda / 10, 1e-12);
+        improved = true;
+        break;
+      }
+      lambda *= 10;
+    }
+    if (!improved || converged) {
+      break;
+    }
+  }
+  LOG(INFO) << "Sparse bundle adjustment final RMS error: "
+            << std::sqrt(cost / total_points) << ", iterations: " << iter
+            << ", time: "
+            << ((cv::getTickCount() - start) / cv::getTickFrequency())
+            << " sec";
+
+  RefinedCameras(params, cameras);
+  for (const auto &camera : cameras) {
+    if (!cv::checkRange(camera.R) || !std::isfinite(camera.focal)) {
+      return false;
+    }
+  }
+  // 与BundleAdjusterBase一致，以最大生成树的中心图像为参考
+  cv::detail::Graph span_tree;
+  std::vector<int> span_tree_centers;
+  cv::detail::findMaxSpanningTree(n, pairwise_matches, span_tree,
+                                  span_tree_centers);
+  Mat R_inv = cameras[span_tree_centers[0]].R.inv();
+  for (int i = 0; i < n; ++i) {
+    cameras[i].R = R_inv * cameras[i].R;
+  }
+  return true;
+}
+}  // namespace ImageStitch
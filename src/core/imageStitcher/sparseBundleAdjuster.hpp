@@ -0,0 +1,58 @@
+#pragma once
+
+#include <vector>
+
+#include "../common/cvTypeDef.hpp"
+
+namespace ImageStitch {
+
+/**
+ * @brief 稀疏LM光束平差。
+ * 误差模型与cv::detail::BundleAdjusterAffine/AffinePartial/Ray一致，但每条边
+ * 的残差只依赖两台相机的参数：雅可比按边分块、多线程数值求导，法方程只在有
+ * 匹配的相机之间有非零块，用稀疏Cholesky(SimplicialLDLT)求解，符号分解只做
+ * 一次。相机之间没有共享的三维点，因此不需要Schur补。
+ */
+class SparseBundleAdjuster : public cv::detail::BundleAdjusterBase {
+ public:
+  enum Model { AFFINE = 0, AFFINE_PARTIAL = 1, RAY = 2 };
+
+ public:
+  explicit SparseBundleAdjuster(Model model = AFFINE);
+  inline Model GetModel() const { return _model; }
+
+ protected:
+  bool estimate(const std::vector<ImageFeatures> &features,
+                const std::vector<MatchesInfo> &pairwise_matches,
+                std::vector<CameraParams> &cameras) override;
+  void setUpInitialCameraParams(const std::vector<CameraParams> &) override {}
+  void obtainRefinedCameraParams(std::vector<CameraParams> &) const override {}
+  void calcError(Mat &) override {}
+  void calcJacobian(Mat &) override {}
+
+ private:
+  struct Edge {
+    int i;
+    int j;
+    std::vector<cv::Point2d> points1;
+    std::vector<cv::Point2d> points2;
+  };
+  auto ParamsPerCamera() const -> int;
+  auto ErrorsPerPoint() const -> int;
+  auto SetUpParams(const std::vector<CameraParams> &cameras,
+                   std::vector<double> &params) const -> void;
+  auto RefinedCameras(const std::vector<double> &params,
+                      std::vector<CameraParams> &cameras) const -> void;
+  /**
+   * @brief 计算一条边上所有内点的残差，写入err(长度为点数*ErrorsPerPoint())。
+   */
+  auto EdgeErrors(const Edge &edge, const double *params1,
+                  const double *params2, double *err) const -> void;
+  auto TotalCost(const std::vector<Edge> &edges,
+                 const std::vector<double> &params) const -> double;
+
+ private:
+  Model _model;
+  std::vector<cv::Size> _img_sizes;
+};
+}  // namespace ImageStitch
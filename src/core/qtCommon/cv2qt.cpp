@@ -2,54 +2,52 @@
 
 #include <QDebug>
 #include <QPainter>
-#include <filesystem>
-#include <sstream>
 #include <vector>
 
 namespace cv2qt {
+namespace {
+// QImage析构时释放对cv::Mat数据的引用
+void ReleaseMat(void *info) { delete static_cast<cv::Mat *>(info); }
+
+// 以只读方式共享cv::Mat的数据，QImage被修改时才会深拷贝
+QImage WrapMat(const cv::Mat &mat, QImage::Format format) {
+  auto holder = new cv::Mat(mat);
+  return QImage(static_cast<const uchar *>(holder->data), holder->cols,
+                holder->rows, static_cast<int>(holder->step), format,
+                ReleaseMat, holder);
+}
+
+QImage WrapBGR(const cv::Mat &mat) {
+#if QT_VERSION >= QT_VERSION_CHECK(5, 14, 0)
+  return WrapMat(mat, QImage::Format_BGR888);
+#else
+  // 没有BGR888格式时用OpenCV的向量化实现交换通道
+  cv::Mat rgb;
+  cv::cvtColor(mat, rgb, cv::COLOR_BGR2RGB);
+  return WrapMat(rgb, QImage::Format_RGB888);
+#endif
+}
+}  // namespace
+
 QImage CvMat2QImage(const cv::Mat &cvImage) {
   if (cvImage.empty()) {
     return QImage();
   }
-
-#ifdef WIN
-  auto tmp_path = std::filesystem::temp_directory_path().string();
-  std::stringstream tmp_filename;
-  tmp_filename << tmp_path << std::hex << (rand() % 1000000)
-               << (rand() % 1000000) << ".jpg";
-  qDebug() << "temp file : " << tmp_filename.str().c_str();
-  cv::imwrite(tmp_filename.str(), cvImage);
-  return QImage(tmp_filename.str().c_str());
-#endif
-
-  QImage image;
-  switch (cvImage.type()) {
-    case CV_8UC1: {
-      image = QImage((const uchar *)(cvImage.data), cvImage.cols, cvImage.rows,
-                     cvImage.step, QImage::Format_Grayscale8);
-      return image.copy();
-    }
-    case CV_8UC3: {
-      // Copy input cv::Mat
-      const uchar *pSrc = (const uchar *)cvImage.data;
-      // Create QImage with same dimensions as input cv::Mat
-      QImage image(pSrc, cvImage.cols, cvImage.rows, cvImage.step,
-                   QImage::Format_RGB888);
-      return image.rgbSwapped();
-    }
-    case CV_8UC4: {
-      // Copy input cv::Mat
-      const uchar *pSrc = (const uchar *)cvImage.data;
-      // Create QImage with same dimensions as input cv::Mat
-      QImage image(pSrc, cvImage.cols, cvImage.rows, cvImage.step,
-                   QImage::Format_ARGB32);
-      return image.copy();
-    }
+  cv::Mat image = cvImage;
+  if (image.depth() != CV_8U) {
+    image.convertTo(image, CV_8U);
+  }
+  switch (image.channels()) {
+    case 1:
+      return WrapMat(image, QImage::Format_Grayscale8);
+    case 3:
+      return WrapBGR(image);
+    case 4:
+      // 小端序下BGRA的内存布局与ARGB32一致
+      return WrapMat(image, QImage::Format_ARGB32);
     default:
-      cvImage.convertTo(cvImage, CV_8UC3);
-      QImage image((const uchar *)cvImage.data, cvImage.cols, cvImage.rows,
-                   cvImage.step, QImage::Format_RGB888);
-      return image.rgbSwapped();
+      qWarning() << "Unsupported channels : " << image.channels();
+      return QImage();
   }
 }
 
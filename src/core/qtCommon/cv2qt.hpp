@@ -4,6 +4,11 @@
 #include <opencv2/opencv.hpp>
 
 namespace cv2qt {
+/**
+ * @brief 不复制像素地把cv::Mat包装为QImage，QImage持有Mat数据的引用直到析构。
+ * 8位三通道使用Format_BGR888，非8位图像先饱和转换为8位。
+ * 转换后不应再原地修改cvImage的数据。
+ */
 QImage CvMat2QImage(const cv::Mat& cvImage);
 cv::Mat QImage2CvMat(const QImage& image);
 }
\ No newline at end of file
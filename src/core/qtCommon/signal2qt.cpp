@@ -0,0 +1,21 @@
+#include "signal2qt.hpp"
+
+#include <QCoreApplication>
+#include <QMetaObject>
+
+#include "../../signal/trackable.hpp"
+
+namespace signal2qt {
+namespace {
+// 每批调用在发出信号的线程中调用一次，投递到安装队列的线程成批执行
+void Notify(void *user) {
+  QMetaObject::invokeMethod(
+      static_cast<QObject *>(user), []() { DispatchQueuedCalls(); },
+      Qt::QueuedConnection);
+}
+}  // namespace
+
+void InstallCallQueue() {
+  ::InstallCallQueue(Notify, QCoreApplication::instance());
+}
+}  // namespace signal2qt
@@ -0,0 +1,12 @@
+#pragma once
+
+namespace signal2qt {
+/**
+ * @brief 为当前线程(界面线程)安装信号的调用队列并接入Qt事件循环。
+ * 之后在其他线程发出的信号，若槽所属的Trackable在当前线程创建，
+ * 槽会排队到当前线程由事件循环调用，因而可以直接操作界面。
+ * 发出线程只做无锁入队，一批排队的调用只投递一次事件，由事件循环成批执行。
+ * 必须在QCoreApplication创建后、对应线程的事件循环中使用。
+ */
+void InstallCallQueue();
+}  // namespace signal2qt
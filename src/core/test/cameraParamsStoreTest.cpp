@@ -0,0 +1,75 @@
+#include <gtest/gtest.h>
+
+#include <filesystem>
+
+#include "../imageStitcher/cameraParamsStore.hpp"
+
+namespace Test {
+
+using namespace ImageStitch;
+
+static CameraParams AffineCamera(const double tx, const double ty) {
+  CameraParams camera;
+  camera.R = (cv::Mat_<float>(3, 3) << 1, 0, tx, 0, 1, ty, 0, 0, 1);
+  return camera;
+}
+
+TEST(CameraParamsStoreTest, WarmStartAlignsNewCameras) {
+  CameraParamsStore store;
+  store.Set(1, AffineCamera(0, 0));
+  store.Set(2, AffineCamera(100, 0));
+  // 估计器的结果与保存的结果相差一个整体平移
+  std::vector<CameraParams> cameras{AffineCamera(50, 10), AffineCamera(150, 10),
+                                    AffineCamera(250, 10)};
+  EXPECT_EQ(store.WarmStart({1, 2, 3}, cameras, false), 2);
+  EXPECT_NEAR(cameras[0].R.at<float>(0, 2), 0, 1e-3);
+  EXPECT_NEAR(cameras[1].R.at<float>(0, 2), 100, 1e-3);
+  EXPECT_NEAR(cameras[2].R.at<float>(0, 2), 200, 1e-3);
+  EXPECT_NEAR(cameras[2].R.at<float>(1, 2), 0, 1e-3);
+}
+
+TEST(CameraParamsStoreTest, WarmStartRotatesNewCameras) {
+  CameraParamsStore store;
+  CameraParams camera;
+  camera.focal = 500;
+  camera.R = cv::Mat::eye(3, 3, CV_32F);
+  store.Set(1, camera);
+  // 估计器的结果整体绕y轴旋转了0.2弧度
+  cv::Mat offset, yaw;
+  cv::Rodrigues(cv::Vec3d(0, 0.2, 0), offset);
+  cv::Rodrigues(cv::Vec3d(0, 0.5, 0), yaw);
+  std::vector<CameraParams> cameras(2, camera);
+  Mat(offset).convertTo(cameras[0].R, CV_32F);
+  Mat(offset * yaw).convertTo(cameras[1].R, CV_32F);
+  EXPECT_EQ(store.WarmStart({1, 2}, cameras, true), 1);
+  Mat R;
+  cameras[1].R.convertTo(R, CV_64F);
+  EXPECT_LT(cv::norm(R, yaw, cv::NORM_INF), 1e-5);
+  EXPECT_LT(cv::norm(R * R.t(), Mat::eye(3, 3, CV_64F), cv::NORM_INF), 1e-5);
+}
+
+TEST(CameraParamsStoreTest, SaveAndLoad) {
+  CameraParamsStore store;
+  auto camera = AffineCamera(12.5, -3);
+  camera.focal = 800;
+  camera.ppx = 320;
+  store.Set(0xFFFFFFFFFFFFFFF1ULL, camera);
+  EXPECT_TRUE(store.Dirty());
+  auto file_name = (std::filesystem::temp_directory_path() /
+                    "cameraParamsStoreTest.json")
+                       .string();
+  ASSERT_TRUE(store.Save(file_name));
+  EXPECT_FALSE(store.Dirty());
+
+  CameraParamsStore loaded;
+  ASSERT_TRUE(loaded.Load(file_name));
+  CameraParams result;
+  ASSERT_TRUE(loaded.Find(0xFFFFFFFFFFFFFFF1ULL, result));
+  EXPECT_DOUBLE_EQ(result.focal, 800);
+  EXPECT_DOUBLE_EQ(result.ppx, 320);
+  EXPECT_EQ(cv::norm(result.R, camera.R, cv::NORM_INF), 0);
+  EXPECT_FALSE(loaded.Find(1, result));
+  std::filesystem::remove(file_name);
+}
+
+}  // namespace Test
@@ -0,0 +1,40 @@
+#include <gtest/gtest.h>
+
+#include "../qtCommon/cv2qt.hpp"
+
+namespace Test {
+
+TEST(Cv2QtTest, SharesBgrData) {
+  cv::Mat image(31, 17, CV_8UC3, cv::Scalar(10, 20, 30));
+  QImage qimage = cv2qt::CvMat2QImage(image);
+  ASSERT_EQ(qimage.width(), image.cols);
+  ASSERT_EQ(qimage.height(), image.rows);
+  // 不复制像素数据
+  EXPECT_EQ(qimage.constBits(), image.data);
+  EXPECT_EQ(qimage.pixelColor(3, 5), QColor(30, 20, 10));
+}
+
+TEST(Cv2QtTest, OutlivesMat) {
+  QImage qimage;
+  {
+    cv::Mat image(8, 8, CV_8UC1, cv::Scalar(77));
+    qimage = cv2qt::CvMat2QImage(image);
+  }
+  EXPECT_EQ(qGray(qimage.pixel(7, 7)), 77);
+}
+
+TEST(Cv2QtTest, DetachOnWrite) {
+  cv::Mat image(4, 4, CV_8UC3, cv::Scalar(1, 2, 3));
+  QImage qimage = cv2qt::CvMat2QImage(image);
+  qimage.setPixelColor(0, 0, QColor(255, 255, 255));
+  // 修改QImage不能写回cv::Mat
+  EXPECT_EQ(image.at<cv::Vec3b>(0, 0), cv::Vec3b(1, 2, 3));
+}
+
+TEST(Cv2QtTest, ConvertsDepth) {
+  cv::Mat image(5, 6, CV_16SC3, cv::Scalar(-5, 100, 300));
+  QImage qimage = cv2qt::CvMat2QImage(image);
+  ASSERT_FALSE(qimage.isNull());
+  EXPECT_EQ(qimage.pixelColor(0, 0), QColor(255, 100, 0));
+}
+}  // namespace Test
@@ -0,0 +1,85 @@
+#include <gtest/gtest.h>
+
+#include "../imageStitcher/divideRects.hpp"
+
+namespace Test {
+
+using namespace ImageStitch;
+
+// 条带在图像内，第一条从0开始，最后一条结束于图像边界，起点递增
+static void ExpectCovers(const std::vector<cv::Rect> &rects,
+                         const cv::Size &size) {
+  ASSERT_FALSE(rects.empty());
+  const cv::Rect image(cv::Point(), size);
+  for (size_t k = 0; k < rects.size(); ++k) {
+    EXPECT_EQ(rects[k] & image, rects[k]) << "strip " << k;
+    EXPECT_EQ(rects[k].size(), rects[0].size()) << "strip " << k;
+    if (k > 0) {
+      EXPECT_GE(rects[k].tl().x + rects[k].tl().y,
+                rects[k - 1].tl().x + rects[k - 1].tl().y);
+    }
+  }
+  EXPECT_EQ(rects.front().tl(), cv::Point());
+  EXPECT_EQ(rects.back().br(), image.br());
+}
+
+TEST(DivideRectsTest, DefaultLayout) {
+  // 默认3条、重叠0.5：条带长L/2，起点0、L/4、L/2
+  const cv::Size size(1000, 600);
+  auto cols = DivideRects(size, 2, 3, 0.5);
+  ASSERT_EQ(cols.size(), 3u);
+  EXPECT_EQ(cols[0], cv::Rect(0, 0, 500, 600));
+  EXPECT_EQ(cols[1], cv::Rect(250, 0, 500, 600));
+  EXPECT_EQ(cols[2], cv::Rect(500, 0, 500, 600));
+  ExpectCovers(cols, size);
+
+  auto rows = DivideRects(size, 1, 3, 0.5);
+  ASSERT_EQ(rows.size(), 3u);
+  EXPECT_EQ(rows[0], cv::Rect(0, 0, 1000, 300));
+  EXPECT_EQ(rows[1], cv::Rect(0, 150, 1000, 300));
+  EXPECT_EQ(rows[2], cv::Rect(0, 300, 1000, 300));
+  ExpectCovers(rows, size);
+}
+
+TEST(DivideRectsTest, LastStripEndsAtLength) {
+  // 长度不能整除时条带向上取整，最后一条仍然结束于边界
+  for (int length : {997, 1000, 1003}) {
+    for (int count = 2; count <= 7; ++count) {
+      for (double overlap : {0.0, 0.3, 0.5, 0.9}) {
+        const cv::Size size(length, 200);
+        auto rects = DivideRects(size, 2, count, overlap);
+        ASSERT_EQ(rects.size(), (size_t)count);
+        ExpectCovers(rects, size);
+        // 相邻条带不留空隙
+        for (int k = 1; k < count; ++k) {
+          EXPECT_LE(rects[k].x, rects[k - 1].br().x);
+        }
+      }
+    }
+  }
+}
+
+TEST(DivideRectsTest, SingleStrip) {
+  const cv::Size size(640, 480);
+  for (double overlap : {0.0, 0.5, 1.0}) {
+    auto rects = DivideRects(size, 1, 1, overlap);
+    ASSERT_EQ(rects.size(), 1u);
+    EXPECT_EQ(rects[0], cv::Rect(cv::Point(), size));
+  }
+}
+
+TEST(DivideRectsTest, OverlapBounds) {
+  const cv::Size size(900, 300);
+  // 不重叠时等分
+  auto rects = DivideRects(size, 2, 3, 0);
+  ASSERT_EQ(rects.size(), 3u);
+  EXPECT_EQ(rects[0], cv::Rect(0, 0, 300, 300));
+  EXPECT_EQ(rects[1], cv::Rect(300, 0, 300, 300));
+  EXPECT_EQ(rects[2], cv::Rect(600, 0, 300, 300));
+  // 完全重叠时每条都是整张图像
+  for (const auto &rect : DivideRects(size, 2, 3, 1)) {
+    EXPECT_EQ(rect, cv::Rect(cv::Point(), size));
+  }
+}
+
+}  // namespace Test
@@ -0,0 +1,67 @@
+#include <gtest/gtest.h>
+
+#include "../imageStitcher/fastGainCompensator.hpp"
+
+namespace Test {
+
+using namespace ImageStitch;
+
+// 从同一场景截取两张重叠的图像，第二张整体变暗
+static void BuildPair(std::vector<cv::Point> &corners,
+                      std::vector<cv::UMat> &images,
+                      std::vector<std::pair<cv::UMat, uchar>> &masks) {
+  cv::RNG rng(5);
+  Mat scene(200, 400, CV_8UC3);
+  rng.fill(scene, cv::RNG::UNIFORM, 60, 200);
+  cv::GaussianBlur(scene, scene, cv::Size(0, 0), 2);
+  Mat first = scene(cv::Rect(0, 0, 250, 200)).clone();
+  Mat second;
+  scene(cv::Rect(150, 0, 250, 200)).convertTo(second, CV_8U, 0.7);
+  corners = {cv::Point(0, 0), cv::Point(150, 0)};
+  images = {first.getUMat(cv::ACCESS_READ).clone(),
+            second.getUMat(cv::ACCESS_READ).clone()};
+  for (int i = 0; i < 2; ++i) {
+    masks.emplace_back(cv::UMat(first.size(), CV_8U, cv::Scalar::all(255)),
+                       255);
+  }
+}
+
+TEST(FastGainCompensatorTest, ImageGains) {
+  std::vector<cv::Point> corners;
+  std::vector<cv::UMat> images;
+  std::vector<std::pair<cv::UMat, uchar>> masks;
+  BuildPair(corners, images, masks);
+  FastGainCompensator compensator;
+  compensator.feed(corners, images, masks);
+  std::vector<Mat> gains;
+  compensator.getMatGains(gains);
+  ASSERT_EQ(gains.size(), 2u);
+  double ratio = gains[1].at<float>(0, 0) / gains[0].at<float>(0, 0);
+  EXPECT_NEAR(ratio, 1 / 0.7, 0.05);
+}
+
+TEST(FastGainCompensatorTest, BlockGains) {
+  std::vector<cv::Point> corners;
+  std::vector<cv::UMat> images;
+  std::vector<std::pair<cv::UMat, uchar>> masks;
+  BuildPair(corners, images, masks);
+  FastGainCompensator compensator(32, 32, 0.5);
+  compensator.feed(corners, images, masks);
+  std::vector<Mat> gains;
+  compensator.getMatGains(gains);
+  ASSERT_EQ(gains.size(), 2u);
+  EXPECT_EQ(gains[0].size(), cv::Size(8, 7));
+  double ratio = cv::mean(gains[1])[0] / cv::mean(gains[0])[0];
+  EXPECT_GT(ratio, 1.2);
+
+  // 补偿后重叠区域的亮度接近
+  Mat first = images[0].getMat(cv::ACCESS_READ).clone();
+  Mat second = images[1].getMat(cv::ACCESS_READ).clone();
+  compensator.apply(0, corners[0], first, Mat());
+  compensator.apply(1, corners[1], second, Mat());
+  double mean1 = cv::mean(first(cv::Rect(150, 0, 100, 200)))[0];
+  double mean2 = cv::mean(second(cv::Rect(0, 0, 100, 200)))[0];
+  EXPECT_NEAR(mean1, mean2, mean1 * 0.1);
+}
+
+}  // namespace Test
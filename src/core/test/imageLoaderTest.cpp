@@ -0,0 +1,153 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <thread>
+
+#include "../common/imageCache.hpp"
+#include "../common/imageHandle.hpp"
+#include "../common/imageLoader.hpp"
+#include "../common/prefetchLoader.hpp"
+
+namespace Test {
+
+using namespace ImageStitch;
+
+static std::string WriteTestImage(const std::string &name,
+                                  const cv::Size &size) {
+  Image image(size, CV_8UC3);
+  cv::RNG rng(5);
+  rng.fill(image, cv::RNG::UNIFORM, 0, 255);
+  cv::GaussianBlur(image, image, cv::Size(0, 0), 2);
+  auto file_name = (std::filesystem::temp_directory_path() / name).string();
+  cv::imwrite(file_name, image);
+  return file_name;
+}
+
+TEST(ImageLoaderTest, ReadHeaderSize) {
+  const cv::Size size(1601, 1203);
+  for (const auto &name : {"imageLoaderTest.jpg", "imageLoaderTest.png"}) {
+    auto file_name = WriteTestImage(name, size);
+    MappedFile file(file_name);
+    ASSERT_TRUE(file.IsOpen());
+    cv::Size header_size;
+    ASSERT_TRUE(ReadImageSize(file.Data(), file.Size(), header_size));
+    EXPECT_EQ(header_size, size);
+    file.Close();
+    std::filesystem::remove(file_name);
+  }
+  const uchar garbage[16] = {1, 2, 3, 4};
+  cv::Size header_size;
+  EXPECT_FALSE(ReadImageSize(garbage, sizeof(garbage), header_size));
+}
+
+TEST(ImageLoaderTest, ReducedDecodeFlag) {
+  const cv::Size size(8000, 5000);  // 40MP
+  EXPECT_EQ(ReducedDecodeFlag(size, -1), cv::IMREAD_COLOR);
+  EXPECT_EQ(ReducedDecodeFlag(size, 0.6), cv::IMREAD_REDUCED_COLOR_8);
+  EXPECT_EQ(ReducedDecodeFlag(size, 1.0), cv::IMREAD_REDUCED_COLOR_4);
+  EXPECT_EQ(ReducedDecodeFlag(size, 5.0), cv::IMREAD_REDUCED_COLOR_2);
+  EXPECT_EQ(ReducedDecodeFlag(size, 20.0), cv::IMREAD_COLOR);
+}
+
+TEST(ImageLoaderTest, DecodeReduced) {
+  const cv::Size size(1600, 1200);
+  auto file_name = WriteTestImage("imageLoaderTest.jpg", size);
+  cv::Size full_size;
+  auto full = DecodeImageFile(file_name, -1, &full_size);
+  EXPECT_EQ(full.size(), size);
+  EXPECT_EQ(full_size, size);
+  auto reduced = DecodeImageFile(file_name, 0.1, &full_size);
+  EXPECT_EQ(reduced.size(), cv::Size(400, 300));
+  EXPECT_EQ(full_size, size);
+  EXPECT_TRUE(DecodeImageFile(file_name + ".missing").empty());
+  std::filesystem::remove(file_name);
+}
+
+TEST(ImageLoaderTest, LazyHandle) {
+  const cv::Size size(1600, 1200);
+  auto file_name = WriteTestImage("imageLoaderTest.jpg", size);
+  auto handle = ImageHandle::Open(file_name, 0.3);
+  ASSERT_NE(handle, nullptr);
+  EXPECT_TRUE(handle->Lazy());
+  EXPECT_EQ(handle->FullSize(), size);
+  EXPECT_EQ(handle->Preview()->size(), cv::Size(480, 360));
+  auto full = handle->Full();
+  EXPECT_EQ(full.size(), size);
+  EXPECT_EQ(cv::norm(full, DecodeImageFile(file_name), cv::NORM_INF), 0);
+  std::filesystem::remove(file_name);
+  // 打开后文件被删除，重新解码失败时返回空图像而不是抛出异常
+  EXPECT_TRUE(handle->Full().empty());
+
+  ImagePtr image = new Image(size, CV_8UC3, cv::Scalar::all(7));
+  ImageHandle eager(image);
+  EXPECT_FALSE(eager.Lazy());
+  EXPECT_EQ(eager.Full().data, image->data);
+  EXPECT_EQ(eager.Preview(), image);
+}
+
+TEST(ImageLoaderTest, PrefetchInOrderWithinWindow) {
+  const int kCount = 20;
+  const int kDepth = 3;
+  std::atomic<int> loaded(0);
+  std::atomic<int> taken(0);
+  std::atomic<int> max_ahead(0);
+  PrefetchLoader loader(
+      kCount,
+      [&](int index) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        ++loaded;
+        int ahead = index - taken;
+        int current = max_ahead;
+        while (ahead > current &&
+               !max_ahead.compare_exchange_weak(current, ahead)) {
+        }
+        return std::make_shared<ImageHandle>(
+            ImagePtr(new Image(1, 1, CV_8UC1, cv::Scalar::all(index))));
+      },
+      kDepth, 2);
+  for (int i = 0; i < kCount; ++i) {
+    auto handle = loader.Take(i);
+    ASSERT_NE(handle, nullptr);
+    EXPECT_EQ(handle->Preview()->at<uchar>(0, 0), i);
+    ++taken;
+    // 模拟特征提取
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  EXPECT_EQ(loaded, kCount);
+  EXPECT_LE(max_ahead, kDepth);
+}
+
+TEST(ImageLoaderTest, ImageCacheSharesDecodedImages) {
+  const cv::Size size(320, 240);
+  auto file1 = WriteTestImage("imageCacheTest1.png", size);
+  auto file2 = WriteTestImage("imageCacheTest2.png", size);
+  const size_t image_bytes = size.area() * 3;
+  ImageCache cache(image_bytes * 3 / 2);
+
+  Image image;
+  EXPECT_FALSE(cache.Find(file1, image));
+  auto loaded = cache.Load(file1);
+  ASSERT_FALSE(loaded.empty());
+  ASSERT_TRUE(cache.Find(file1, image));
+  // 命中时与第一次解码的结果共享数据
+  EXPECT_EQ(image.data, loaded.data);
+  EXPECT_EQ(cache.MemoryUsage(), image_bytes);
+
+  // 超出上限时淘汰最久未使用的
+  cache.Load(file2);
+  EXPECT_EQ(cache.Size(), 1);
+  EXPECT_FALSE(cache.Find(file1, image));
+  EXPECT_TRUE(cache.Find(file2, image));
+
+  // 文件修改后缓存失效
+  std::filesystem::last_write_time(
+      file2, std::filesystem::last_write_time(file2) + std::chrono::hours(1));
+  EXPECT_FALSE(cache.Find(file2, image));
+  EXPECT_EQ(cache.MemoryUsage(), 0);
+  std::filesystem::remove(file1);
+  std::filesystem::remove(file2);
+}
+
+}  // namespace Test
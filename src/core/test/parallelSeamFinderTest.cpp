@@ -0,0 +1,122 @@
+#include <gtest/gtest.h>
+
+#include "../imageStitcher/parallelSeamFinder.hpp"
+
+namespace Test {
+
+using namespace ImageStitch;
+
+TEST(ParallelSeamFinderTest, ScheduleRounds) {
+  // 一行5张图像，相邻的重叠
+  std::vector<cv::Point> corners;
+  std::vector<cv::Size> sizes;
+  for (int i = 0; i < 5; ++i) {
+    corners.emplace_back(i * 80, 0);
+    sizes.emplace_back(100, 100);
+  }
+  auto rounds = ParallelPairwiseSeamFinder::ScheduleRounds(corners, sizes);
+  ASSERT_EQ(rounds.size(), 2u);
+  EXPECT_EQ(rounds[0], (std::vector<ParallelPairwiseSeamFinder::Pair>{
+                           {0, 1}, {2, 3}}));
+  EXPECT_EQ(rounds[1], (std::vector<ParallelPairwiseSeamFinder::Pair>{
+                           {1, 2}, {3, 4}}));
+  for (const auto &pairs : rounds) {
+    std::vector<int> used(corners.size(), 0);
+    for (const auto &pair : pairs) {
+      EXPECT_EQ(used[pair.first]++, 0);
+      EXPECT_EQ(used[pair.second]++, 0);
+    }
+  }
+}
+
+static void BuildGrid(std::vector<cv::UMat> &images,
+                      std::vector<cv::Point> &corners,
+                      std::vector<cv::UMat> &serial_masks,
+                      std::vector<cv::UMat> &parallel_masks) {
+  cv::RNG rng(7);
+  for (int i = 0; i < 6; ++i) {
+    Mat image(120, 150, CV_32FC3);
+    rng.fill(image, cv::RNG::UNIFORM, 0, 255);
+    images.push_back(image.getUMat(cv::ACCESS_READ).clone());
+    corners.emplace_back((i % 3) * 110, (i / 3) * 90);
+    Mat mask(image.size(), CV_8U, cv::Scalar::all(255));
+    serial_masks.push_back(mask.getUMat(cv::ACCESS_READ).clone());
+    parallel_masks.push_back(mask.getUMat(cv::ACCESS_READ).clone());
+  }
+}
+
+TEST(ParallelSeamFinderTest, SameAsSerial) {
+  std::vector<cv::UMat> images;
+  std::vector<cv::Point> corners;
+  std::vector<cv::UMat> serial_masks, parallel_masks;
+  BuildGrid(images, corners, serial_masks, parallel_masks);
+  cv::detail::GraphCutSeamFinder serial;
+  serial.find(images, corners, serial_masks);
+  ParallelPairwiseSeamFinder parallel(
+      []() -> cv::Ptr<cv::detail::SeamFinder> {
+        return cv::makePtr<cv::detail::GraphCutSeamFinder>();
+      });
+  parallel.find(images, corners, parallel_masks);
+  for (size_t i = 0; i < images.size(); ++i) {
+    EXPECT_EQ(cv::norm(serial_masks[i], parallel_masks[i], cv::NORM_INF), 0)
+        << "mask " << i;
+  }
+}
+
+TEST(ParallelSeamFinderTest, DpOrder) {
+  // 一行4张图像，DpSeamFinder先处理中心距离最远的图像对
+  std::vector<cv::Point> corners;
+  std::vector<cv::Size> sizes;
+  for (int i = 0; i < 4; ++i) {
+    corners.emplace_back(i * 80, 0);
+    sizes.emplace_back(100, 100);
+  }
+  auto pairs = ParallelPairwiseSeamFinder::SerialPairs(
+      corners, sizes, ParallelPairwiseSeamFinder::DP);
+  ASSERT_EQ(pairs.size(), 6u);
+  EXPECT_EQ(pairs.front(), ParallelPairwiseSeamFinder::Pair(0, 3));
+  // 只有相邻的图像重叠，每张图像的图像对保持上面的先后
+  auto rounds =
+      ParallelPairwiseSeamFinder::ScheduleRounds(pairs, corners, sizes);
+  std::vector<ParallelPairwiseSeamFinder::Pair> scheduled;
+  for (const auto &round : rounds) {
+    scheduled.insert(scheduled.end(), round.begin(), round.end());
+  }
+  EXPECT_EQ(scheduled.size(), 3u);
+  for (int image = 0; image < 4; ++image) {
+    std::vector<ParallelPairwiseSeamFinder::Pair> expected, actual;
+    for (const auto &pair : pairs) {
+      if ((pair.first == image || pair.second == image) &&
+          pair.second - pair.first == 1) {
+        expected.push_back(pair);
+      }
+    }
+    for (const auto &pair : scheduled) {
+      if (pair.first == image || pair.second == image) {
+        actual.push_back(pair);
+      }
+    }
+    EXPECT_EQ(actual, expected) << "image " << image;
+  }
+}
+
+TEST(ParallelSeamFinderTest, DpSameAsSerial) {
+  std::vector<cv::UMat> images;
+  std::vector<cv::Point> corners;
+  std::vector<cv::UMat> serial_masks, parallel_masks;
+  BuildGrid(images, corners, serial_masks, parallel_masks);
+  cv::detail::DpSeamFinder serial;
+  serial.find(images, corners, serial_masks);
+  ParallelPairwiseSeamFinder parallel(
+      []() -> cv::Ptr<cv::detail::SeamFinder> {
+        return cv::makePtr<cv::detail::DpSeamFinder>();
+      },
+      ParallelPairwiseSeamFinder::DP);
+  parallel.find(images, corners, parallel_masks);
+  for (size_t i = 0; i < images.size(); ++i) {
+    EXPECT_EQ(cv::norm(serial_masks[i], parallel_masks[i], cv::NORM_INF), 0)
+        << "mask " << i;
+  }
+}
+
+}  // namespace Test
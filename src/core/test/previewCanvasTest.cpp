@@ -0,0 +1,56 @@
+#include <gtest/gtest.h>
+
+#include "../imageStitcher/previewCanvas.hpp"
+
+namespace Test {
+
+using namespace ImageStitch;
+
+TEST(PreviewCanvasTest, FeedDownscaledTiles) {
+  // 全景长边4096，画布缩小一半为2048x512
+  PreviewCanvas canvas;
+  canvas.Prepare(cv::Rect(-100, 200, 4096, 1024));
+
+  // 融合器的输入是CV_16S，超出8位的值饱和
+  Mat left(1024, 2000, CV_16SC3, cv::Scalar(10, 20, 300));
+  Mat left_mask(left.size(), CV_8U, cv::Scalar::all(255));
+  canvas.Feed(left, left_mask, cv::Point(-100, 200));
+  // 第二块与第一块重叠，只有上半部分有效，右侧超出全景范围
+  Mat right(1024, 2396, CV_16SC3, cv::Scalar(200, 100, 50));
+  Mat right_mask(right.size(), CV_8U, cv::Scalar::all(0));
+  right_mask.rowRange(0, 512).setTo(255);
+  canvas.Feed(right, right_mask, cv::Point(1700, 200));
+
+  ImagePtr preview = canvas.Preview();
+  ASSERT_FALSE(preview.empty());
+  ASSERT_EQ(preview->size(), cv::Size(2048, 512));
+  ASSERT_EQ(preview->type(), CV_8UC3);
+  const cv::Vec3b kLeft(10, 20, 255), kRight(200, 100, 50), kEmpty(0, 0, 0);
+  EXPECT_EQ(preview->at<cv::Vec3b>(100, 450), kLeft);
+  // 重叠区域中后送入的图像按掩码覆盖
+  EXPECT_EQ(preview->at<cv::Vec3b>(100, 950), kRight);
+  EXPECT_EQ(preview->at<cv::Vec3b>(400, 950), kLeft);
+  EXPECT_EQ(preview->at<cv::Vec3b>(100, 2047), kRight);
+  EXPECT_EQ(preview->at<cv::Vec3b>(400, 1500), kEmpty);
+
+  // 预览是画布的副本，继续送入不影响已发出的预览
+  canvas.Feed(left, left_mask, cv::Point(2000, 200));
+  EXPECT_EQ(preview->at<cv::Vec3b>(400, 1500), kEmpty);
+}
+
+TEST(PreviewCanvasTest, SmallPanoramaKeepsResolution) {
+  PreviewCanvas canvas;
+  canvas.Prepare(cv::Rect(0, 0, 300, 200));
+  Mat tile(100, 100, CV_8UC3, cv::Scalar(1, 2, 3));
+  Mat mask(tile.size(), CV_8U, cv::Scalar::all(255));
+  canvas.Feed(tile, mask, cv::Point(150, 50));
+  ImagePtr preview = canvas.Preview();
+  ASSERT_EQ(preview->size(), cv::Size(300, 200));
+  EXPECT_EQ(cv::countNonZero(preview->reshape(1)), 100 * 100 * 3);
+  EXPECT_EQ(preview->at<cv::Vec3b>(50, 150), cv::Vec3b(1, 2, 3));
+  EXPECT_EQ(preview->at<cv::Vec3b>(149, 249), cv::Vec3b(1, 2, 3));
+  // 节流：刚发出过预览时不再到期
+  EXPECT_TRUE(canvas.Due());
+  EXPECT_FALSE(canvas.Due());
+}
+}  // namespace Test
@@ -0,0 +1,107 @@
+#include <gtest/gtest.h>
+
+#include <filesystem>
+
+#include "../imageStitcher/remapCache.hpp"
+
+namespace Test {
+
+using namespace ImageStitch;
+
+static RemapCache::Entry BuildEntry(cv::detail::RotationWarper &warper,
+                                    cv::Size size, const Mat &K,
+                                    const Mat &R) {
+  RemapCache::Entry entry;
+  entry.roi = warper.buildMaps(size, K, R, entry.xmap, entry.ymap);
+  return entry;
+}
+
+TEST(RemapCacheTest, FindAndEvict) {
+  cv::detail::SphericalWarper warper(500);
+  Mat K = (cv::Mat_<float>(3, 3) << 500, 0, 160, 0, 500, 120, 0, 0, 1);
+  Mat R = Mat::eye(3, 3, CV_32F);
+  cv::Size size(320, 240);
+  auto entry = BuildEntry(warper, size, K, R);
+  size_t entry_bytes = entry.xmap.total() * entry.xmap.elemSize() * 2;
+
+  RemapCache cache(entry_bytes * 2);
+  auto key1 = RemapCache::MakeKey(size, K, R, "SphericalWarper", 500);
+  auto key2 = RemapCache::MakeKey(size, K, R, "SphericalWarper", 400);
+  auto key3 = RemapCache::MakeKey(size, K, R, "CylindricalWarper", 500);
+  EXPECT_NE(key1, key2);
+  EXPECT_NE(key1, key3);
+
+  cache.Insert(key1, entry);
+  cache.Insert(key2, entry);
+  RemapCache::Entry found;
+  EXPECT_TRUE(cache.Find(key1, found));
+  EXPECT_EQ(found.roi, entry.roi);
+  EXPECT_EQ(cv::norm(found.xmap, entry.xmap, cv::NORM_INF), 0);
+
+  // key2最久未使用，插入key3后应被淘汰
+  cache.Insert(key3, entry);
+  EXPECT_EQ(cache.Size(), 2);
+  EXPECT_LE(cache.MemoryUsage(), cache.MemoryLimit());
+  EXPECT_TRUE(cache.Find(key1, found));
+  EXPECT_FALSE(cache.Find(key2, found));
+  EXPECT_TRUE(cache.Find(key3, found));
+}
+
+TEST(RemapCacheTest, SaveAndLoad) {
+  cv::detail::CylindricalWarper warper(300);
+  Mat K = (cv::Mat_<float>(3, 3) << 300, 0, 100, 0, 300, 80, 0, 0, 1);
+  Mat R = Mat::eye(3, 3, CV_32F);
+  cv::Size size(200, 160);
+  auto entry = BuildEntry(warper, size, K, R);
+  auto key = RemapCache::MakeKey(size, K, R, "CylindricalWarper", 300);
+
+  RemapCache cache(64 * 1024 * 1024);
+  cache.Insert(key, entry);
+  EXPECT_TRUE(cache.Dirty());
+  ASSERT_TRUE(cache.Save("./remap_cache_test.bin"));
+  EXPECT_FALSE(cache.Dirty());
+
+  RemapCache cache1(64 * 1024 * 1024);
+  ASSERT_TRUE(cache1.Load("./remap_cache_test.bin"));
+  RemapCache::Entry found;
+  ASSERT_TRUE(cache1.Find(key, found));
+  EXPECT_EQ(found.roi, entry.roi);
+  EXPECT_EQ(cv::norm(found.xmap, entry.xmap, cv::NORM_INF), 0);
+  EXPECT_EQ(cv::norm(found.ymap, entry.ymap, cv::NORM_INF), 0);
+  std::filesystem::remove("./remap_cache_test.bin");
+}
+
+TEST(RemapCacheTest, FixedPointMatchesFloat) {
+  cv::detail::SphericalWarper warper(500);
+  Mat K = (cv::Mat_<float>(3, 3) << 500, 0, 160, 0, 500, 120, 0, 0, 1);
+  Mat R;
+  cv::Rodrigues(cv::Vec3f(0.05f, 0.2f, 0.02f), R);
+  cv::Size size(320, 240);
+  auto entry = BuildEntry(warper, size, K, R);
+  auto fixed = entry;
+  RemapCache::ToFixedPoint(fixed);
+  EXPECT_EQ(fixed.xmap.type(), CV_16SC2);
+  EXPECT_EQ(fixed.xmap.size(), entry.xmap.size());
+
+  // 平滑的渐变图像上，1/32像素的坐标误差只带来不超过1的灰度差
+  Image src(size, CV_8UC3);
+  for (int y = 0; y < src.rows; ++y) {
+    for (int x = 0; x < src.cols; ++x) {
+      src.at<cv::Vec3b>(y, x) = cv::Vec3b(x * 255 / src.cols,
+                                          y * 255 / src.rows, (x + y) / 3);
+    }
+  }
+  Image float_warped, fixed_warped;
+  cv::remap(src, float_warped, entry.xmap, entry.ymap, cv::INTER_LINEAR,
+            cv::BORDER_REFLECT);
+  cv::remap(src, fixed_warped, fixed.xmap, fixed.ymap, cv::INTER_LINEAR,
+            cv::BORDER_REFLECT);
+  EXPECT_LE(cv::norm(float_warped, fixed_warped, cv::NORM_INF), 1);
+
+  // 最近邻插值和非8位图像不使用定点映射表
+  EXPECT_TRUE(RemapCache::FixedPointApplicable(CV_8U, cv::INTER_LINEAR));
+  EXPECT_FALSE(RemapCache::FixedPointApplicable(CV_8U, cv::INTER_NEAREST));
+  EXPECT_FALSE(RemapCache::FixedPointApplicable(CV_16S, cv::INTER_LINEAR));
+}
+
+}  // namespace Test
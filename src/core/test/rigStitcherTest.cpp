@@ -0,0 +1,274 @@
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <filesystem>
+
+#include "../common/imageCache.hpp"
+#include "../imageStitcher/imageStitcher.hpp"
+
+namespace Test {
+
+using namespace ImageStitch;
+
+// 生成一张纹理丰富的场景图，从中截取相互重叠的帧模拟固定机位的多路相机
+static Image SyntheticScene(const cv::Size &size, const int seed) {
+  cv::RNG rng(seed);
+  Image scene(size, CV_8UC3);
+  rng.fill(scene, cv::RNG::UNIFORM, 0, 255);
+  cv::GaussianBlur(scene, scene, cv::Size(0, 0), 3);
+  for (int i = 0; i < 600; ++i) {
+    cv::Point center(rng.uniform(0, size.width), rng.uniform(0, size.height));
+    cv::Scalar color(rng.uniform(0, 255), rng.uniform(0, 255),
+                     rng.uniform(0, 255));
+    if (i % 2 == 0) {
+      cv::circle(scene, center, rng.uniform(3, 30), color, cv::FILLED);
+    } else {
+      cv::rectangle(scene, center,
+                    center + cv::Point(rng.uniform(5, 40), rng.uniform(5, 40)),
+                    color, 2);
+    }
+  }
+  return scene;
+}
+
+static std::vector<Image> CropFrames(const Image &scene, const int count,
+                                     const int width, const int step) {
+  std::vector<Image> frames;
+  for (int i = 0; i < count; ++i) {
+    frames.push_back(scene(cv::Rect(i * step, 0, width, scene.rows)).clone());
+  }
+  return frames;
+}
+
+static Parameters RigParameters() {
+  Parameters params;
+  params.FromString(
+      "{"
+      "\"CompositingResol\": {\"value\": -1.0},"
+      "\"DivideImage\": {\"value\": \"NO\"},"
+      "\"PanoConfidenceThresh\": {\"value\": 0.5},"
+      "\"RegistrationResol\": {\"value\": 0.6},"
+      "\"RemapCacheLimit\": {\"value\": 0.0},"
+      "\"RigMode\": {\"value\": \"NO\"},"
+      "\"SeamEstimationResol\": {\"value\": 0.1},"
+      "\"Blender\": {\"value\": \"MultiBandBlender\"},"
+      "\"BundleAdjuster\": {\"value\": \"BundleAdjusterAffinePartial\"},"
+      "\"Estimator\": {\"value\": \"AffineBasedEstimator\"},"
+      "\"ExposureCompensator\": {\"value\": \"GainCompensator\"},"
+      "\"FeaturesFinder\": {\"value\": \"ORB\"},"
+      "\"FeaturesMatcher\": {\"value\": \"AffineBestOf2NearestMatcher\"},"
+      "\"InterpolationFlags\": {\"value\": \"INTER_LINEAR\"},"
+      "\"Mode\": {\"value\": \"SCANS\"},"
+      "\"SeamFinder\": {\"value\": \"GraphCutSeamFinder\"},"
+      "\"Warper\": {\"value\": \"AffineWarper\"}"
+      "}");
+  return params;
+}
+
+TEST(RigStitcherTest, SaveAndLoad) {
+  ImageStitcher stitcher;
+  stitcher.SetParams(RigParameters());
+  auto frames = CropFrames(SyntheticScene(cv::Size(1200, 480), 1), 3, 480, 360);
+  ASSERT_TRUE(stitcher.CalibrateRig(frames));
+  auto pano = stitcher.StitchRig(frames);
+  ASSERT_FALSE(pano.empty());
+
+  auto file_name =
+      (std::filesystem::temp_directory_path() / "rigStitcherTest.rig").string();
+  ASSERT_TRUE(stitcher.SaveRig(file_name));
+  ImageStitcher restored;
+  restored.SetParams(RigParameters());
+  ASSERT_TRUE(restored.LoadRig(file_name));
+  auto restored_pano = restored.StitchRig(frames);
+  ASSERT_FALSE(restored_pano.empty());
+  EXPECT_EQ(pano->size(), restored_pano->size());
+  EXPECT_LT(cv::norm(*pano, *restored_pano, cv::NORM_INF), 2);
+  std::filesystem::remove(file_name);
+
+  // 帧尺寸与标定不一致时拒绝拼接
+  std::vector<Image> wrong_frames = frames;
+  wrong_frames[0] = wrong_frames[0](cv::Rect(0, 0, 100, 100)).clone();
+  EXPECT_TRUE(stitcher.StitchRig(wrong_frames).empty());
+}
+
+TEST(RigStitcherTest, ApplyWithoutRig) {
+  ImageStitcher stitcher;
+  auto params = RigParameters();
+  params.SetParam("RigMode", std::string("APPLY"));
+  stitcher.SetParams(params);
+  std::vector<ImagePtr> images;
+  for (const auto &frame :
+       CropFrames(SyntheticScene(cv::Size(1200, 480), 7), 3, 480, 360)) {
+    images.push_back(new Image(frame));
+  }
+  stitcher.SetImages(images);
+  // 没有标定结果时不退回完整拼接
+  EXPECT_TRUE(stitcher.Stitch().empty());
+  EXPECT_TRUE(stitcher.component().empty());
+}
+
+TEST(RigStitcherTest, WarmStartKeyedByModel) {
+  std::vector<ImagePtr> images;
+  for (const auto &frame :
+       CropFrames(SyntheticScene(cv::Size(1200, 480), 8), 3, 480, 360)) {
+    images.push_back(new Image(frame));
+  }
+  auto hashes = [&images](Parameters params) {
+    params.SetParam("WarmStart", std::string("YES"));
+    ImageStitcher stitcher;
+    stitcher.SetParams(params);
+    stitcher.SetImages(images);
+    stitcher.Stitch();
+    return stitcher.ImageHashes();
+  };
+  auto params = RigParameters();
+  auto affine = hashes(params);
+  ASSERT_EQ(affine.size(), images.size());
+  EXPECT_EQ(hashes(params), affine);
+  // 换了投影或平差模型后，保存的相机参数不再命中
+  auto plane_params = RigParameters();
+  plane_params.SetParam("Warper", std::string("PlaneWarper"));
+  auto plane = hashes(plane_params);
+  ASSERT_EQ(plane.size(), images.size());
+  EXPECT_NE(plane[0], affine[0]);
+  auto ray_params = RigParameters();
+  ray_params.SetParam("BundleAdjuster", std::string("BundleAdjusterRay"));
+  EXPECT_NE(hashes(ray_params)[0], affine[0]);
+}
+
+TEST(RigStitcherTest, SplitComponents) {
+  ImageStitcher stitcher;
+  auto params = RigParameters();
+  params.SetParam("SplitComponents", std::string("YES"));
+  stitcher.SetParams(params);
+  // 两个互不重叠的场景，匹配图分成两个连通分量
+  std::vector<ImagePtr> images;
+  for (const auto &frame :
+       CropFrames(SyntheticScene(cv::Size(1200, 480), 4), 3, 480, 360)) {
+    images.push_back(new Image(frame));
+  }
+  for (const auto &frame :
+       CropFrames(SyntheticScene(cv::Size(900, 480), 5), 2, 480, 360)) {
+    images.push_back(new Image(frame));
+  }
+  stitcher.SetImages(images);
+  auto results = stitcher.Stitch();
+  EXPECT_EQ(results.size(), 2);
+  // 中间数据对应最大的部分，没有记录的数据保持为空
+  EXPECT_EQ(stitcher.component(), (std::vector<int>{0, 1, 2}));
+  EXPECT_EQ(stitcher.FinalCameraParams().size(), stitcher.component().size());
+  EXPECT_TRUE(stitcher.SeamMasks().empty());
+  EXPECT_TRUE(stitcher.CompensatorImages().empty());
+}
+
+TEST(RigStitcherTest, LazyStitch) {
+  ImageStitcher stitcher;
+  stitcher.SetParams(RigParameters());
+  // 原图大于配准分辨率，只解码预览图，融合时再按需解码原图
+  auto frames =
+      CropFrames(SyntheticScene(cv::Size(3000, 1000), 6), 3, 1200, 900);
+  std::vector<std::string> files;
+  for (int i = 0; i < frames.size(); ++i) {
+    files.push_back((std::filesystem::temp_directory_path() /
+                     ("lazyStitchTest" + std::to_string(i) + ".png"))
+                        .string());
+    ASSERT_TRUE(cv::imwrite(files.back(), frames[i]));
+  }
+  stitcher.SetImages(files);
+  ASSERT_EQ(stitcher.ImageSize(), 3);
+  EXPECT_TRUE(stitcher.GetImageHandle(0)->Lazy());
+  auto results = stitcher.Stitch();
+  ASSERT_EQ(results.size(), 1);
+  EXPECT_GT(results[0]->cols, frames[0].cols);
+  // 中间数据与参与拼接的图像一一对应
+  const auto &comp = stitcher.component();
+  EXPECT_EQ(comp.size(), 3);
+  EXPECT_EQ(stitcher.FinalCameraParams().size(), comp.size());
+  EXPECT_EQ(stitcher.SeamMasks().size(), comp.size());
+  EXPECT_TRUE(stitcher.CompensatorImages().empty());
+  // 再次拼接不会累积上一次的拼接缝
+  stitcher.Stitch();
+  EXPECT_EQ(stitcher.SeamMasks().size(), comp.size());
+  for (const auto &file : files) {
+    std::filesystem::remove(file);
+  }
+}
+
+TEST(RigStitcherTest, FullLoadFillsImageCache) {
+  ImageStitcher stitcher;
+  stitcher.SetParams(RigParameters());
+  // 原图不大于配准分辨率时全分辨率解码，结果放入共享缓存供下一次加载复用
+  auto frames = CropFrames(SyntheticScene(cv::Size(900, 300), 7), 3, 400, 250);
+  std::vector<std::string> files;
+  for (int i = 0; i < frames.size(); ++i) {
+    files.push_back((std::filesystem::temp_directory_path() /
+                     ("imageCacheStitchTest" + std::to_string(i) + ".png"))
+                        .string());
+    ASSERT_TRUE(cv::imwrite(files.back(), frames[i]));
+    ImageCache::Instance().Erase(files.back());
+  }
+  stitcher.SetImages(files);
+  ASSERT_EQ(stitcher.ImageSize(), 3);
+  for (int i = 0; i < files.size(); ++i) {
+    EXPECT_FALSE(stitcher.GetImageHandle(i)->Lazy());
+    Image cached;
+    ASSERT_TRUE(ImageCache::Instance().Find(files[i], cached));
+    EXPECT_EQ(cached.data, stitcher.GetImageHandle(i)->Full().data);
+  }
+  // 再次加载直接共享缓存中的图像
+  ImageStitcher reloaded;
+  reloaded.SetParams(RigParameters());
+  reloaded.SetImages(files);
+  ASSERT_EQ(reloaded.ImageSize(), 3);
+  EXPECT_EQ(reloaded.GetImageHandle(0)->Full().data,
+            stitcher.GetImageHandle(0)->Full().data);
+  for (const auto &file : files) {
+    ImageCache::Instance().Erase(file);
+    std::filesystem::remove(file);
+  }
+}
+
+TEST(RigStitcherTest, FrameRateBenchmark) {
+  const int kCameras = 4;
+  const int kFrameSets = 50;
+
+  ImageStitcher stitcher;
+  stitcher.SetParams(RigParameters());
+  auto scene = SyntheticScene(cv::Size(2000, 600), 2);
+  auto frames = CropFrames(scene, kCameras, 640, 440);
+  ASSERT_TRUE(stitcher.CalibrateRig(frames));
+
+  // 预先生成若干组带噪声的帧，计时只包含拼接本身
+  std::vector<std::vector<Image>> frame_sets;
+  cv::RNG rng(3);
+  for (int i = 0; i < 5; ++i) {
+    std::vector<Image> frame_set;
+    for (const auto &frame : frames) {
+      Image noise(frame.size(), frame.type()), noisy;
+      rng.fill(noise, cv::RNG::NORMAL, 0, 4);
+      cv::add(frame, noise, noisy);
+      frame_set.push_back(noisy);
+    }
+    frame_sets.push_back(frame_set);
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < kFrameSets; ++i) {
+    auto pano = stitcher.StitchRig(frame_sets[i % frame_sets.size()]);
+    ASSERT_FALSE(pano.empty());
+  }
+  std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+  double fps = kFrameSets / elapsed.count();
+  LOG(INFO) << "Rig stitching " << kCameras << "x640x600 : "
+            << elapsed.count() * 1000 / kFrameSets << " ms/frame, " << fps
+            << " fps";
+#ifdef RIG_BENCHMARK
+  // 只在release构建中检查10Hz的目标，调试和插桩构建的耗时没有参考意义
+  const double kTargetFps = 10;
+  EXPECT_GE(fps, kTargetFps);
+#endif
+}
+
+}  // namespace Test
@@ -0,0 +1,72 @@
+#include <gtest/gtest.h>
+
+#include "../common/hash.hpp"
+#include "../imageStitcher/seamCache.hpp"
+
+namespace Test {
+
+using namespace ImageStitch;
+
+static void BuildRow(cv::RNG &rng, const int count, std::vector<cv::UMat> &src,
+                     std::vector<cv::Point> &corners,
+                     std::vector<cv::UMat> &masks) {
+  for (int i = 0; i < count; ++i) {
+    Mat image(100, 120, CV_32FC3);
+    rng.fill(image, cv::RNG::UNIFORM, 0, 255);
+    src.push_back(image.getUMat(cv::ACCESS_READ).clone());
+    corners.emplace_back(i * 90, 0);
+    masks.push_back(cv::UMat(image.size(), CV_8U, cv::Scalar::all(255)));
+  }
+}
+
+static std::vector<uint64_t> Hashes(const std::vector<cv::UMat> &src) {
+  std::vector<uint64_t> hashes;
+  for (const auto &image : src) {
+    hashes.push_back(HashImage(image.getMat(cv::ACCESS_READ)));
+  }
+  return hashes;
+}
+
+TEST(SeamCacheTest, RefindChangedImage) {
+  cv::RNG rng(11);
+  std::vector<cv::UMat> src, masks;
+  std::vector<cv::Point> corners;
+  BuildRow(rng, 5, src, corners, masks);
+  cv::detail::GraphCutSeamFinder finder;
+  finder.find(src, corners, masks);
+
+  SeamCache cache;
+  std::vector<int> changed;
+  EXPECT_FALSE(cache.ChangedImages(Hashes(src), corners, changed));
+  cache.Update(Hashes(src), corners, masks);
+  std::vector<Mat> old_masks;
+  for (const auto &mask : masks) {
+    old_masks.push_back(mask.getMat(cv::ACCESS_READ).clone());
+  }
+
+  // 替换中间的一张图像
+  Mat image(100, 120, CV_32FC3);
+  rng.fill(image, cv::RNG::UNIFORM, 0, 255);
+  src[2] = image.getUMat(cv::ACCESS_READ).clone();
+  std::vector<cv::UMat> new_masks;
+  for (size_t i = 0; i < src.size(); ++i) {
+    new_masks.push_back(
+        cv::UMat(src[i].size(), CV_8U, cv::Scalar::all(255)));
+  }
+  ASSERT_TRUE(cache.ChangedImages(Hashes(src), corners, changed));
+  ASSERT_EQ(changed, std::vector<int>{2});
+  cache.Refind(finder, src, corners, new_masks, changed);
+
+  // 不与变化图像重叠的掩码保持不变
+  EXPECT_EQ(cv::norm(old_masks[0], new_masks[0], cv::NORM_INF), 0);
+  EXPECT_EQ(cv::norm(old_masks[4], new_masks[4], cv::NORM_INF), 0);
+  // 拼接缝重新划分后全景仍被完整覆盖
+  Mat coverage(100, 90 * 4 + 120, CV_8U, cv::Scalar::all(0));
+  for (size_t i = 0; i < src.size(); ++i) {
+    Mat roi = coverage(cv::Rect(corners[i], src[i].size()));
+    cv::bitwise_or(roi, new_masks[i].getMat(cv::ACCESS_READ), roi);
+  }
+  EXPECT_EQ(cv::countNonZero(coverage), (int)coverage.total());
+}
+
+}  // namespace Test
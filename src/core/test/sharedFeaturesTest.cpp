@@ -0,0 +1,84 @@
+#include <gtest/gtest.h>
+
+#include "../imageStitcher/sharedFeatures.hpp"
+
+namespace Test {
+
+using namespace ImageStitch;
+
+TEST(SharedFeaturesTest, SplitByStrip) {
+  // 宽300的原图切成两条宽200的条带，[100, 200)为重叠区域
+  const std::vector<cv::Rect2f> areas{{0, 0, 200, 100}, {100, 0, 200, 100}};
+  KeyPoints keypoints;
+  Mat descriptors(0, 4, CV_8U);
+  for (float x : {10.f, 99.f, 100.f, 150.f, 199.f, 200.f, 250.f}) {
+    keypoints.emplace_back(cv::Point2f(x, 50), 1.f);
+    // 每行描述子记录特征点的横坐标，方便核对对应关系
+    Mat row(1, 4, CV_8U, cv::Scalar::all(x));
+    descriptors.push_back(row);
+  }
+  std::vector<KeyPoints> strip_keypoints;
+  std::vector<Mat> strip_descriptors;
+  SplitFeatures(keypoints, descriptors, areas, strip_keypoints,
+                strip_descriptors);
+  ASSERT_EQ(strip_keypoints.size(), 2u);
+  ASSERT_EQ(strip_descriptors.size(), 2u);
+
+  const std::vector<std::vector<float>> expected{
+      {10, 99, 100, 150, 199}, {100, 150, 199, 200, 250}};
+  for (size_t i = 0; i < areas.size(); ++i) {
+    ASSERT_EQ(strip_keypoints[i].size(), expected[i].size()) << "strip " << i;
+    ASSERT_EQ(strip_descriptors[i].rows, (int)expected[i].size());
+    EXPECT_EQ(strip_descriptors[i].type(), descriptors.type());
+    for (size_t k = 0; k < expected[i].size(); ++k) {
+      // 坐标换算到条带内，描述子行与特征点一一对应
+      EXPECT_FLOAT_EQ(strip_keypoints[i][k].pt.x + areas[i].x,
+                      expected[i][k]);
+      EXPECT_FLOAT_EQ(strip_keypoints[i][k].pt.y, 50);
+      EXPECT_EQ(strip_descriptors[i].at<uchar>(k, 0),
+                (uchar)expected[i][k]);
+    }
+  }
+}
+
+TEST(SharedFeaturesTest, DetectorBudget) {
+  // ORB按条带数放大特征数量上限，不修改原检测器
+  auto orb = cv::ORB::create(500);
+  auto shared = SharedFeatureDetector(orb, 3).dynamicCast<cv::ORB>();
+  ASSERT_FALSE(shared.empty());
+  EXPECT_EQ(shared->getMaxFeatures(), 1500);
+  EXPECT_EQ(orb->getMaxFeatures(), 500);
+  EXPECT_EQ(shared->getNLevels(), orb->getNLevels());
+  // 没有上限的检测器直接复用
+  cv::Ptr<Feature2D> akaze = cv::AKAZE::create();
+  EXPECT_EQ(SharedFeatureDetector(akaze, 3).get(), akaze.get());
+  // 无法确定上限的检测器不共享
+  EXPECT_TRUE(SharedFeatureDetector(cv::SIFT::create(), 3).empty());
+}
+
+TEST(SharedFeaturesTest, SharedOrbKeepsPerStripCount) {
+  // 与逐条带提取相比，共享提取后每个条带的特征数不应明显减少
+  cv::RNG rng(11);
+  Mat image(400, 1200, CV_8U);
+  rng.fill(image, cv::RNG::UNIFORM, 0, 255);
+  cv::GaussianBlur(image, image, cv::Size(5, 5), 1.5);
+  auto orb = cv::ORB::create(300);
+  const std::vector<cv::Rect> rects{
+      {0, 0, 600, 400}, {300, 0, 600, 400}, {600, 0, 600, 400}};
+  std::vector<cv::Rect2f> areas(rects.begin(), rects.end());
+  KeyPoints keypoints;
+  Mat descriptors;
+  SharedFeatureDetector(orb, rects.size())
+      ->detectAndCompute(image, cv::noArray(), keypoints, descriptors);
+  std::vector<KeyPoints> strip_keypoints;
+  std::vector<Mat> strip_descriptors;
+  SplitFeatures(keypoints, descriptors, areas, strip_keypoints,
+                strip_descriptors);
+  for (size_t i = 0; i < rects.size(); ++i) {
+    KeyPoints own;
+    orb->detect(image(rects[i]), own);
+    EXPECT_GE(strip_keypoints[i].size() * 2, own.size()) << "strip " << i;
+  }
+}
+
+}  // namespace Test
@@ -0,0 +1,137 @@
+#include <gtest/gtest.h>
+
+#include "../imageStitcher/hierarchicalBundleAdjuster.hpp"
+#include "../imageStitcher/sparseBundleAdjuster.hpp"
+
+namespace Test {
+
+using namespace ImageStitch;
+
+// 一行图像，每张图像到全景的变换为平移加轻微的旋转缩放
+static cv::Matx33d TruthTransform(const int index) {
+  double angle = 0.02 * index, scale = 1 + 0.01 * index;
+  return cv::Matx33d(scale * std::cos(angle), -scale * std::sin(angle),
+                     index * 300.0, scale * std::sin(angle),
+                     scale * std::cos(angle), 5.0 * index, 0, 0, 1);
+}
+
+static void BuildProblem(const int count, std::vector<ImageFeatures> &features,
+                         std::vector<MatchesInfo> &pairwise_matches,
+                         std::vector<CameraParams> &cameras) {
+  features.resize(count);
+  pairwise_matches.resize(count * count);
+  cameras.resize(count);
+  cv::RNG rng(9);
+  for (int i = 0; i < count; ++i) {
+    features[i].img_idx = i;
+    features[i].img_size = cv::Size(400, 300);
+  }
+  for (int i = 0; i + 1 < count; ++i) {
+    const int j = i + 1;
+    // 全景坐标下落在两张图像重叠区域的点
+    auto inv_i = TruthTransform(i).inv(), inv_j = TruthTransform(j).inv();
+    MatchesInfo &info = pairwise_matches[i * count + j];
+    info.src_img_idx = i;
+    info.dst_img_idx = j;
+    for (int k = 0; k < 40; ++k) {
+      cv::Vec3d P(i * 300.0 + rng.uniform(320.0, 380.0),
+                  rng.uniform(20.0, 280.0), 1);
+      cv::Vec3d p1 = inv_i * P, p2 = inv_j * P;
+      info.matches.emplace_back(features[i].keypoints.size(),
+                                features[j].keypoints.size(), 0.f);
+      info.inliers_mask.push_back(1);
+      features[i].keypoints.emplace_back(cv::Point2f(p1[0], p1[1]), 1.f);
+      features[j].keypoints.emplace_back(cv::Point2f(p2[0], p2[1]), 1.f);
+    }
+    info.num_inliers = info.matches.size();
+    info.confidence = 2;
+    MatchesInfo &reverse = pairwise_matches[j * count + i];
+    reverse = info;
+    std::swap(reverse.src_img_idx, reverse.dst_img_idx);
+    for (auto &m : reverse.matches) {
+      std::swap(m.queryIdx, m.trainIdx);
+    }
+  }
+  // 初值：只有平移
+  for (int i = 0; i < count; ++i) {
+    cameras[i].R = (cv::Mat_<float>(3, 3) << 1, 0, i * 300.f + 7, 0, 1, 0, 0,
+                    0, 1);
+  }
+}
+
+static void ExpectRelativeTransforms(const std::vector<CameraParams> &cameras) {
+  for (int i = 0; i + 1 < (int)cameras.size(); ++i) {
+    cv::Matx33d Ri, Rj;
+    cameras[i].R.convertTo(Ri, CV_64F);
+    cameras[i + 1].R.convertTo(Rj, CV_64F);
+    cv::Matx33d relative = Ri.inv() * Rj;
+    cv::Matx33d truth = TruthTransform(i).inv() * TruthTransform(i + 1);
+    EXPECT_LT(cv::norm(relative.get_minor<2, 2>(0, 0) -
+                       truth.get_minor<2, 2>(0, 0)),
+              1e-3);
+    EXPECT_LT(cv::norm(relative.get_minor<2, 1>(0, 2) -
+                       truth.get_minor<2, 1>(0, 2)),
+              0.1);
+  }
+}
+
+TEST(SparseBundleAdjusterTest, AffineRecoversRelativeTransforms) {
+  const int kCount = 6;
+  std::vector<ImageFeatures> features;
+  std::vector<MatchesInfo> pairwise_matches;
+  std::vector<CameraParams> cameras;
+  BuildProblem(kCount, features, pairwise_matches, cameras);
+
+  SparseBundleAdjuster adjuster(SparseBundleAdjuster::AFFINE);
+  ASSERT_TRUE(adjuster(features, pairwise_matches, cameras));
+  ExpectRelativeTransforms(cameras);
+}
+
+TEST(SparseBundleAdjusterTest, PartitionClusters) {
+  const int kCount = 10;
+  std::vector<ImageFeatures> features;
+  std::vector<MatchesInfo> pairwise_matches;
+  std::vector<CameraParams> cameras;
+  BuildProblem(kCount, features, pairwise_matches, cameras);
+  auto clusters =
+      HierarchicalBundleAdjuster::Partition(kCount, pairwise_matches, 1, 4);
+  std::vector<int> count(kCount, 0);
+  for (const auto &cluster : clusters) {
+    EXPECT_LE(cluster.size(), 4u);
+    for (int node : cluster) {
+      count[node]++;
+    }
+  }
+  EXPECT_EQ(count, std::vector<int>(kCount, 1));
+}
+
+TEST(SparseBundleAdjusterTest, HierarchicalRecoversRelativeTransforms) {
+  const int kCount = 10;
+  std::vector<ImageFeatures> features;
+  std::vector<MatchesInfo> pairwise_matches;
+  std::vector<CameraParams> cameras;
+  BuildProblem(kCount, features, pairwise_matches, cameras);
+
+  HierarchicalBundleAdjuster adjuster(SparseBundleAdjuster::AFFINE, 3);
+  ASSERT_TRUE(adjuster(features, pairwise_matches, cameras));
+  EXPECT_GT(adjuster.ClusterTimes().size(), 1u);
+  ExpectRelativeTransforms(cameras);
+}
+
+TEST(SparseBundleAdjusterTest, HierarchicalManyParallelClusters) {
+  // 每块2张图像，十几个块在并行循环中同时写各自的结果
+  const int kCount = 24;
+  std::vector<ImageFeatures> features;
+  std::vector<MatchesInfo> pairwise_matches;
+  std::vector<CameraParams> initial;
+  BuildProblem(kCount, features, pairwise_matches, initial);
+  for (int run = 0; run < 5; ++run) {
+    auto cameras = initial;
+    HierarchicalBundleAdjuster adjuster(SparseBundleAdjuster::AFFINE, 2);
+    ASSERT_TRUE(adjuster(features, pairwise_matches, cameras)) << "run " << run;
+    EXPECT_EQ(adjuster.ClusterTimes().size(), (size_t)(kCount / 2));
+    ExpectRelativeTransforms(cameras);
+  }
+}
+
+}  // namespace Test
@@ -1,6 +1,7 @@
 add_rules("mode.debug", "mode.release")
 
 add_requires("opencv", "eigen", "glog","gtest", "qt5base", "nlohmann_json")
+add_requires("openmp")
 add_cxxflags("cl::/utf-8")
 set_languages("c++17")
 
@@ -16,11 +17,15 @@ target("common")
     add_packages("opencv", "eigen", "glog", "nlohmann_json")
     add_headerfiles("common/*.hpp")
     add_files("common/*.cpp")
+    if is_plat("linux") then
+        add_syslinks("pthread")
+    end
 
 target("qtCommon")
     add_rules("qt.static")
     add_packages("opencv", "qt5base", "glog")
     add_headerfiles("qtCommon/*.hpp")
+    add_deps("signal")
     add_files("qtCommon/*.cpp")
     add_frameworks("QtGui")
 
@@ -45,4 +50,80 @@ target("stitcherTest")
     add_packages("opencv", "eigen", "glog", "gtest", "qt5base", "nlohmann_json")
     add_deps("ImageStitchCore", "MUI", "qtCommon")
     add_files("test/stitcherTest.cpp")
-    add_files("../gtest/uiTestMain.cpp")
\ No newline at end of file
+    add_files("../gtest/uiTestMain.cpp")
+target("remapCacheTest")
+    set_kind("binary")
+    add_packages("opencv", "glog", "gtest")
+    add_files("imageStitcher/remapCache.cpp")
+    add_files("test/remapCacheTest.cpp")
+    add_files("../gtest/testMain.cpp")
+target("rigStitcherTest")
+    set_kind("binary")
+    add_packages("opencv", "eigen", "glog", "gtest", "nlohmann_json")
+    add_deps("ImageStitchCore")
+    add_files("test/rigStitcherTest.cpp")
+    if is_mode("release") then
+        add_defines("RIG_BENCHMARK")
+    end
+    add_files("../gtest/testMain.cpp")
+target("parallelSeamFinderTest")
+    set_kind("binary")
+    add_packages("opencv", "glog", "gtest")
+    add_files("imageStitcher/parallelSeamFinder.cpp")
+    add_files("test/parallelSeamFinderTest.cpp")
+    add_files("../gtest/testMain.cpp")
+target("divideRectsTest")
+    set_kind("binary")
+    add_packages("opencv", "glog", "gtest")
+    add_files("imageStitcher/divideRects.cpp")
+    add_files("test/divideRectsTest.cpp")
+    add_files("../gtest/testMain.cpp")
+target("previewCanvasTest")
+    set_kind("binary")
+    add_packages("opencv", "glog", "gtest")
+    add_files("imageStitcher/previewCanvas.cpp")
+    add_files("test/previewCanvasTest.cpp")
+    add_files("../gtest/testMain.cpp")
+target("sharedFeaturesTest")
+    set_kind("binary")
+    add_packages("opencv", "glog", "gtest")
+    add_files("imageStitcher/sharedFeatures.cpp")
+    add_files("test/sharedFeaturesTest.cpp")
+    add_files("../gtest/testMain.cpp")
+target("seamCacheTest")
+    set_kind("binary")
+    add_packages("opencv", "glog", "gtest")
+    add_files("imageStitcher/seamCache.cpp")
+    add_files("test/seamCacheTest.cpp")
+    add_files("../gtest/testMain.cpp")
+target("fastGainCompensatorTest")
+    set_kind("binary")
+    add_packages("opencv", "eigen", "glog", "gtest")
+    add_files("imageStitcher/fastGainCompensator.cpp")
+    add_files("test/fastGainCompensatorTest.cpp")
+    add_files("../gtest/testMain.cpp")
+target("sparseBundleAdjusterTest")
+    set_kind("binary")
+    add_packages("opencv", "eigen", "glog", "gtest", "openmp")
+    add_files("imageStitcher/sparseBundleAdjuster.cpp")
+    add_files("imageStitcher/hierarchicalBundleAdjuster.cpp")
+    add_files("test/sparseBundleAdjusterTest.cpp")
+    add_files("../gtest/testMain.cpp")
+target("cameraParamsStoreTest")
+    set_kind("binary")
+    add_packages("opencv", "eigen", "glog", "gtest", "nlohmann_json")
+    add_files("imageStitcher/cameraParamsStore.cpp")
+    add_files("test/cameraParamsStoreTest.cpp")
+    add_files("../gtest/testMain.cpp")
+target("cv2qtTest")
+    add_rules("qt.console")
+    add_packages("opencv", "glog", "gtest", "qt5base")
+    add_deps("qtCommon")
+    add_files("test/cv2qtTest.cpp")
+    add_files("../gtest/testMain.cpp")
+target("imageLoaderTest")
+    set_kind("binary")
+    add_packages("opencv", "glog", "gtest")
+    add_deps("common")
+    add_files("test/imageLoaderTest.cpp")
+    add_files("../gtest/testMain.cpp")
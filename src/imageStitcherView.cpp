@@ -8,14 +8,20 @@
 #include <QDebug>
 #include <QDir>
 #include <QGridLayout>
+#include <QHeaderView>
 #include <QImage>
+#include <QScrollBar>
 #include <QSpinBox>
 #include <QStatusBar>
 #include <QTextEdit>
+#include <algorithm>
+#include <limits>
 #include <sstream>
 #include <string>
 #include <thread>
+#include <utility>
 
+#include "core/common/imageCache.hpp"
 #include "core/qtCommon/cv2qt.hpp"
 
 namespace ImageStitch {
@@ -23,6 +29,10 @@ namespace ImageStitch {
 const bool kUseThread = true;
 
 ImageStitcherView::ImageStitcherView(QWidget *parent) : QWidget(parent) {
+  // 界面与拼接器共用解码缓存，同一文件只解码一次
+  ImageItemModel::setImageLoader([](const QString &file) {
+    return cv2qt::CvMat2QImage(ImageCache::Instance().Load(file.toStdString()));
+  });
   SetupUi(420, 290);
 }
 void ImageStitcherView::SetupUi(const int width, const int height) {
@@ -88,6 +98,8 @@ void ImageStitcherView::SetupUi(const int width, const int height) {
       &ImageStitcherView::_Solts::SetProgress, &_solts);
   image_stitcher.signal_result.connect(&ImageStitcherView::_Solts::Result,
                                        &_solts);
+  image_stitcher.signal_preview.connect(&ImageStitcherView::_Solts::Preview,
+                                        &_solts);
 
   connect(stitch_button, &QPushButton::clicked, this,
           &ImageStitcherView::Stitch);
@@ -207,15 +219,12 @@ void ImageStitcherView::CreateFromDirectory(const QString &path) {
     dir.setFilter(QDir::Files);
     dir.setNameFilters(QStringList{"*.png", "*.jpg", ".jpeg"});
     QFileInfoList list = dir.entryInfoList();
-    std::vector<QPixmap> pixmap(list.size());
-#pragma omp parallel for
-    for (int i = 0; i < list.size(); ++i) {
-      QFileInfo file_info = list.at(i);
-      pixmap[i] = QPixmap(file_info.filePath());
-    }
-    for (int i = 0; i < list.size(); ++i) {
-      m_model->addItem(pixmap[i], list[i].filePath());
+    // 只登记路径，缩略图由列表在显示时后台生成
+    QStringList files;
+    for (const auto &file_info : list) {
+      files.append(file_info.filePath());
     }
+    m_model->addItems(files);
     Message(tr("文件夹: ") + path + tr(" .中的图片已成功导入"), 10000);
   } else {
     Message(tr("文件夹: ") + path + tr(" .不存在"), 10000);
@@ -229,6 +238,14 @@ void ImageStitcherView::ShowImage(const QImage &image) {
   result_view_widget->SetImage(image);
 }
 
+void ImageStitcherView::ShowPreview(const QImage &image) {
+  if (!_previewing) {
+    return;
+  }
+  // 预览尺寸不变，保持用户当前的缩放和位置
+  result_view_widget->UpdateImage(image);
+}
+
 void ImageStitcherView::ShowMessage(const QString &message) {
   result_view_widget->SetPixmap(QPixmap());
   result_view_widget->ShowMessage(message);
@@ -246,7 +263,12 @@ void ImageStitcherView::_Solts::ShowMessage(const std::string &message,
   current_message = message.c_str();
   parent->Message(current_message, timeout);
 }
+void ImageStitcherView::_Solts::Preview(ImagePtr image) {
+  // 信号在拼接线程发出，槽经调用队列在界面线程执行
+  parent->ShowPreview(cv2qt::CvMat2QImage(*image));
+}
 void ImageStitcherView::_Solts::Result(std::vector<ImagePtr> imgs) {
+  parent->_previewing = false;
   parent->stitch_button->setEnabled(true);
   LOG(INFO) << "stitcher finished";
   LOG(INFO) << "result size : " << imgs.size();
@@ -263,7 +285,7 @@ void ImageStitcherView::_Solts::Result(std::vector<ImagePtr> imgs) {
 void ImageStitcherView::Stitch(bool checked) {
   auto Items = m_model->getItems(0, m_model->rowCount());
   std::vector<std::string> image_files;
-  for (const auto &[file_name, pixmap] : Items) {
+  for (const auto &[file_name, image] : Items) {
     image_files.push_back(file_name.toStdString());
   }
   if (image_files.size() <= 0) {
@@ -320,6 +342,7 @@ void ImageStitcherView::paintEvent(QPaintEvent *event) {
 }
 
 void ImageStitcherView::StartStitcher() {
+  _previewing = true;
   stitch_button->setEnabled(false);
   config_button->setEnabled(false);
 }
@@ -504,6 +527,238 @@ void ConfigDialog::AddItem(const QString &title, const int &min_value,
   view->adjustSize();
 }
 
+PagedTableModel::PagedTableModel(const QStringList &headers, QObject *parent)
+    : QAbstractTableModel(parent), _headers(headers) {}
+int PagedTableModel::rowCount(const QModelIndex &parent) const {
+  return parent.isValid() ? 0 : (std::min)(TotalRows(), _loaded_rows);
+}
+int PagedTableModel::columnCount(const QModelIndex &parent) const {
+  return parent.isValid() ? 0 : _headers.size();
+}
+QVariant PagedTableModel::data(const QModelIndex &index, int role) const {
+  if (!index.isValid() || index.row() >= rowCount() ||
+      index.column() >= columnCount()) {
+    return QVariant();
+  }
+  if (role == Qt::DisplayRole) {
+    return Cell(index.row(), index.column());
+  }
+  return QVariant();
+}
+QVariant PagedTableModel::headerData(int section, Qt::Orientation orientation,
+                                     int role) const {
+  if (role != Qt::DisplayRole) {
+    return QVariant();
+  }
+  if (orientation == Qt::Horizontal) {
+    return section < _headers.size() ? _headers[section] : QVariant();
+  }
+  return section;
+}
+bool PagedTableModel::canFetchMore(const QModelIndex &parent) const {
+  return !parent.isValid() && _loaded_rows < TotalRows();
+}
+void PagedTableModel::fetchMore(const QModelIndex &parent) {
+  if (!canFetchMore(parent)) {
+    return;
+  }
+  const int rows = rowCount();
+  const int count = (std::min)(kPageSize, TotalRows() - rows);
+  beginInsertRows(QModelIndex(), rows, rows + count - 1);
+  _loaded_rows = rows + count;
+  endInsertRows();
+}
+
+KeypointsTableModel::KeypointsTableModel(const ImageFeatures &features,
+                                         QObject *parent)
+    : PagedTableModel(
+          {"x", "y", "size", "angle", "response", "octave", "descriptor"},
+          parent),
+      _keypoints(features.keypoints) {
+  if (!features.descriptors.empty()) {
+    _descriptors = features.descriptors.getMat(cv::ACCESS_READ).clone();
+  }
+}
+int KeypointsTableModel::TotalRows() const { return _keypoints.size(); }
+QVariant KeypointsTableModel::Cell(const int row, const int column) const {
+  const auto &keypoint = _keypoints[row];
+  switch (column) {
+    case 0:
+      return keypoint.pt.x;
+    case 1:
+      return keypoint.pt.y;
+    case 2:
+      return keypoint.size;
+    case 3:
+      return keypoint.angle;
+    case 4:
+      return keypoint.response;
+    case 5:
+      return keypoint.octave;
+    case 6: {
+      if (row >= _descriptors.rows) {
+        return QVariant();
+      }
+      std::ostringstream text;
+      text << _descriptors.row(row);
+      return QString(text.str().c_str());
+    }
+  }
+  return QVariant();
+}
+
+MatchesTableModel::MatchesTableModel(const MatchesInfo &matches,
+                                     QObject *parent)
+    : PagedTableModel({"query", "train", "img", "distance", "inlier"}, parent),
+      _matches(matches.matches),
+      _inliers(matches.inliers_mask) {}
+int MatchesTableModel::TotalRows() const { return _matches.size(); }
+QVariant MatchesTableModel::Cell(const int row, const int column) const {
+  const auto &dmatch = _matches[row];
+  switch (column) {
+    case 0:
+      return dmatch.queryIdx;
+    case 1:
+      return dmatch.trainIdx;
+    case 2:
+      return dmatch.imgIdx;
+    case 3:
+      return dmatch.distance;
+    case 4:
+      return row < _inliers.size() ? int(_inliers[row]) : QVariant();
+  }
+  return QVariant();
+}
+
+MatchMatrixModel::MatchMatrixModel(const ImageStitcher *image_stitcher,
+                                   const int count, const double thresh,
+                                   QObject *parent)
+    : QAbstractTableModel(parent),
+      _count(count),
+      _thresh(thresh),
+      _confidences(size_t(count) * count, -1.0f) {
+  for (const auto &[index, matches] : image_stitcher->FeaturesMatches()) {
+    const auto &[i, j] = index;
+    if (i < 0 || i >= count || j < 0 || j >= count) {
+      continue;
+    }
+    _confidences[size_t(i) * count + j] = matches.confidence;
+    if (i != j) {
+      _max_confidence = (std::max)(_max_confidence, (float)matches.confidence);
+    }
+  }
+}
+int MatchMatrixModel::rowCount(const QModelIndex &parent) const {
+  return parent.isValid() ? 0 : _count;
+}
+int MatchMatrixModel::columnCount(const QModelIndex &parent) const {
+  return parent.isValid() ? 0 : _count;
+}
+QVariant MatchMatrixModel::data(const QModelIndex &index, int role) const {
+  if (!index.isValid() || index.row() >= _count || index.column() >= _count) {
+    return QVariant();
+  }
+  const float confidence =
+      _confidences[size_t(index.row()) * _count + index.column()];
+  if (confidence < 0 || index.row() == index.column()) {
+    return QVariant();
+  }
+  switch (role) {
+    case Qt::DisplayRole:
+      return QString().setNum(confidence, 'f', 3);
+    case Qt::ToolTipRole:
+      return QString::number(index.row() + 1) + ", " +
+             QString::number(index.column() + 1) + " : " +
+             QString().setNum(confidence, 'f', 6);
+    case Qt::BackgroundRole: {
+      // 置信度从低到高对应蓝到红
+      double t = _max_confidence > 0 ? confidence / _max_confidence : 0;
+      return QColor::fromHsvF((1 - std::clamp(t, 0.0, 1.0)) * 0.66, 0.6, 1.0);
+    }
+    case Qt::FontRole:
+      if (confidence >= _thresh) {
+        QFont font;
+        font.setBold(true);
+        return font;
+      }
+      return QVariant();
+    case Qt::TextAlignmentRole:
+      return Qt::AlignCenter;
+  }
+  return QVariant();
+}
+QVariant MatchMatrixModel::headerData(int section, Qt::Orientation orientation,
+                                      int role) const {
+  if (role != Qt::DisplayRole) {
+    return QVariant();
+  }
+  return (orientation == Qt::Horizontal ? "o_" : "f_") +
+         QString::number(section + 1);
+}
+Qt::ItemFlags MatchMatrixModel::flags(const QModelIndex &index) const {
+  if (!index.isValid() || index.row() == index.column()) {
+    return Qt::NoItemFlags;
+  }
+  return Qt::ItemIsEnabled | Qt::ItemIsSelectable;
+}
+
+StageImagesModel::StageImagesModel(const ImageStitcher *image_stitcher,
+                                   const int count, QObject *parent)
+    : QAbstractTableModel(parent),
+      _count(count),
+      _available(size_t(STAGE_COUNT) * count, 0) {
+  // 中间数据只对应参与拼接的图像，按component换算到图像下标
+  const auto &comp = image_stitcher->component();
+  const size_t sizes[STAGE_COUNT] = {
+      image_stitcher->CompensatorImages().size(),
+      image_stitcher->SeamMasks().size()};
+  for (int stage = 0; stage < STAGE_COUNT; ++stage) {
+    for (int i = 0; i < comp.size() && i < sizes[stage]; ++i) {
+      if (comp[i] >= 0 && comp[i] < count) {
+        _available[size_t(stage) * count + comp[i]] = 1;
+      }
+    }
+  }
+}
+int StageImagesModel::rowCount(const QModelIndex &parent) const {
+  return parent.isValid() ? 0 : STAGE_COUNT;
+}
+int StageImagesModel::columnCount(const QModelIndex &parent) const {
+  return parent.isValid() ? 0 : _count;
+}
+QVariant StageImagesModel::data(const QModelIndex &index, int role) const {
+  if (!index.isValid() || index.row() >= STAGE_COUNT ||
+      index.column() >= _count) {
+    return QVariant();
+  }
+  const bool available =
+      _available[size_t(index.row()) * _count + index.column()];
+  switch (role) {
+    case Qt::DisplayRole:
+      return available ? QString::number(index.column() + 1) : QString("-");
+    case Qt::TextAlignmentRole:
+      return Qt::AlignCenter;
+  }
+  return QVariant();
+}
+QVariant StageImagesModel::headerData(int section, Qt::Orientation orientation,
+                                      int role) const {
+  if (role != Qt::DisplayRole) {
+    return QVariant();
+  }
+  if (orientation == Qt::Horizontal) {
+    return QString::number(section + 1);
+  }
+  return section == COMPENSATOR ? "compensator result" : "seam find result";
+}
+Qt::ItemFlags StageImagesModel::flags(const QModelIndex &index) const {
+  if (!index.isValid() ||
+      !_available[size_t(index.row()) * _count + index.column()]) {
+    return Qt::NoItemFlags;
+  }
+  return Qt::ItemIsEnabled | Qt::ItemIsSelectable;
+}
+
 MidDataView::MidDataView(ImageStitcher *image_stitcher, QWidget *parent)
     : QWidget(parent), image_stitcher(image_stitcher) {
   SetupUi();
@@ -513,130 +768,145 @@ void MidDataView::SetupUi() {
   setLayout(grid_layout);
   int image_length = image_stitcher->FinalStitchImages().size();
 
-  features_buttons.resize(image_length);
-  original_buttons.resize(image_length);
-  matches_buttons.resize(image_length,
-                         std::vector<QPushButton *>(image_length));
-  compensator_buttons.resize(image_length);
-  seam_mask_buttons.resize(image_length);
-
   label = new QLabel();
-  label->setText("特征图\\原图");
+  label->setText("行: 特征图, 列: 原图, 双击单元格查看匹配");
 
   grid_layout->addWidget(label, 0, 0);
 
-  for (int i = 0; i < image_length; ++i) {
-    original_buttons[i] = new QPushButton();
-    connect(
-        original_buttons[i], &QPushButton::clicked, this,
-        [i, this](bool checked) {
-          CustomizeTitleWidget *main_window = new CustomizeTitleWidget();
-          connect(this, &MidDataView::destroyed, main_window,
-                  [main_window](QObject *) { main_window->close(); });
-          ImageView *image_view = new ImageView();
-          image_view->SetImage(GetImage(i));
-          main_window->setCentralWidget(image_view);
-          main_window->setWindowTitle(tr("原图 - ") + QString::number(i + 1));
-          main_window->setAttribute(Qt::WA_DeleteOnClose, true);
-          main_window->show();
-        });
-    original_buttons[i]->setText("o_" + QString::number(i + 1));
-    grid_layout->addWidget(original_buttons[i], 0, i + 1);
-  }
-  for (int i = 0; i < image_length; ++i) {
-    features_buttons[i] = new QPushButton();
-    connect(features_buttons[i], &QPushButton::clicked, this,
-            [i, this](bool checked) {
-              CustomizeTitleWidget *main_window = new CustomizeTitleWidget();
-              connect(this, &MidDataView::destroyed, main_window,
-                      [main_window](QObject *) { main_window->close(); });
-              ImageView *image_view = new ImageView();
-              QTextEdit *text_edit = new QTextEdit();
-              QTextEdit *text_edit1 = new QTextEdit();
-              QSplitter *splitter = new QSplitter();
-              QSplitter *splitter1 = new QSplitter();
-              splitter->addWidget(image_view);
-              splitter1->setOrientation(Qt::Vertical);
-              splitter1->addWidget(text_edit1);
-              splitter1->addWidget(text_edit);
-              splitter->addWidget(splitter1);
-
-              text_edit1->setText(GetCameraParamsText(i));
-              text_edit->setText(GetFeaturesText(i));
-              text_edit->setReadOnly(true);
-              image_view->SetImage(GetFeaturesImage(i));
-
-              main_window->setCentralWidget(splitter);
-              main_window->setWindowTitle(tr("特征提取图 - ") +
-                                          QString::number(i + 1));
-              main_window->setAttribute(Qt::WA_DeleteOnClose, true);
-              main_window->show();
-            });
-    features_buttons[i]->setText("f_" + QString::number(i + 1));
-    grid_layout->addWidget(features_buttons[i], i + 1, 0);
-  }
   auto thresh =
       image_stitcher->GetParams().GetParam("PanoConfidenceThresh", 0.0);
-  for (int i = 0; i < image_length; ++i) {
-    for (int j = 0; j < image_length; ++j) {
-      matches_buttons[i][j] = new QPushButton();
-      connect(matches_buttons[i][j], &QPushButton::clicked, this,
-              [i, j, this](bool checked) {
-                CustomizeTitleWidget *main_window = new CustomizeTitleWidget();
-                connect(this, &MidDataView::destroyed, main_window,
-                        [main_window](QObject *) { main_window->close(); });
-                ImageView *image_view = new ImageView();
-                ImageView *image_view1 = new ImageView();
-                QTextEdit *text_edit = new QTextEdit();
-                QSplitter *splitter = new QSplitter();
-                QSplitter *splitter1 = new QSplitter();
-                splitter1->setOrientation(Qt::Vertical);
-                splitter1->addWidget(image_view);
-                splitter1->addWidget(image_view1);
-                splitter->addWidget(splitter1);
-                splitter->addWidget(text_edit);
-
-                text_edit->setText(GetMatchesText(i, j));
-                text_edit->setReadOnly(true);
-                image_view->SetImage(GetMatchesImage(i, j));
-                image_view1->SetImage(GetWarpImage(i, j));
-
-                main_window->setCentralWidget(splitter);
-
-                main_window->setWindowTitle(tr("匹配图 - ") +
-                                            QString::number(i + 1) + ", " +
-                                            QString::number(j + 1));
-                main_window->setAttribute(Qt::WA_DeleteOnClose, true);
-                main_window->show();
-              });
-      auto matches = image_stitcher->FeaturesMatches()[{i, j}];
-      matches_buttons[i][j]->setText(
-          QString().setNum(matches.confidence, 'f', 6));
-      if (matches.confidence >= thresh) {
-        matches_buttons[i][j]->setAutoFillBackground(true);
-        QPalette pal = matches_buttons[i][j]->palette();
-        pal.setColor(QPalette::ButtonText, QColor(Qt::red));
-        matches_buttons[i][j]->setPalette(pal);
-      }
-      if (i == j) {
-        matches_buttons[i][j]->setEnabled(false);
-      }
-      grid_layout->addWidget(matches_buttons[i][j], i + 1, j + 1);
-    }
-  }
-
-  auto compensator_label = new QLabel();
-  compensator_label->setText("compensator result");
-  grid_layout->addWidget(compensator_label, image_length + 1, 0);
-  compensator_buttons.resize(image_length);
-  for (int i = 0; i < image_length; ++i) {
-    compensator_buttons[i] = new QPushButton();
-    connect(
-        compensator_buttons[i], &QPushButton::clicked, this,
-        [i, this](bool checked) {
-          CustomizeTitleWidget *main_window = new CustomizeTitleWidget();
-          connect(this, &MidDataView::destroyed, main_window,
-                  [main_window](QObject *) { main_window->close(); });
+  // 表格视图只绘制可见的单元格，大量图像时不必为每对图像创建控件
+  matches_model =
+      new MatchMatrixModel(image_stitcher, image_length, thresh, this);
+  matches_view = new QTableView();
+  matches_view->setModel(matches_model);
+  matches_view->horizontalHeader()->setDefaultSectionSize(64);
+  matches_view->verticalHeader()->setDefaultSectionSize(24);
+  matches_view->horizontalHeader()->setSectionResizeMode(QHeaderView::Fixed);
+  matches_view->verticalHeader()->setSectionResizeMode(QHeaderView::Fixed);
+  matches_view->setSelectionMode(QAbstractItemView::SingleSelection);
+  matches_view->setEditTriggers(QAbstractItemView::NoEditTriggers);
+  grid_layout->addWidget(matches_view, 1, 0);
+
+  connect(matches_view->horizontalHeader(), &QHeaderView::sectionClicked, this,
+          [this](int i) {
+            CustomizeTitleWidget *main_window = new CustomizeTitleWidget();
+            connect(this, &MidDataView::destroyed, main_window,
+                    [main_window](QObject *) { main_window->close(); });
+            ImageView *image_view = new ImageView();
+            image_view->SetImage(GetImage(i));
+            main_window->setCentralWidget(image_view);
+            main_window->setWindowTitle(tr("原图 - ") + QString::number(i + 1));
+            main_window->setAttribute(Qt::WA_DeleteOnClose, true);
+            main_window->show();
+          });
+  connect(matches_view->verticalHeader(), &QHeaderView::sectionClicked, this,
+          [this](int i) {
+            CustomizeTitleWidget *main_window = new CustomizeTitleWidget();
+            connect(this, &MidDataView::destroyed, main_window,
+                    [main_window](QObject *) { main_window->close(); });
+            ImageView *image_view = new ImageView();
+            QTextEdit *text_edit = new QTextEdit();
+            QTextEdit *text_edit1 = new QTextEdit();
+            QTableView *table_view = new QTableView();
+            QSplitter *splitter = new QSplitter();
+            QSplitter *splitter1 = new QSplitter();
+            splitter->addWidget(image_view);
+            splitter1->setOrientation(Qt::Vertical);
+            splitter1->addWidget(text_edit1);
+            splitter1->addWidget(text_edit);
+            splitter1->addWidget(table_view);
+            splitter->addWidget(splitter1);
+            if (i < image_stitcher->ImagesFeatures().size()) {
+              // 特征点逐页加载，只格式化可见的行
+              table_view->setModel(new KeypointsTableModel(
+                  image_stitcher->ImagesFeatures()[i], table_view));
+            }
+
+            text_edit1->setText(GetCameraParamsText(i));
+            text_edit->setText(GetFeaturesText(i));
+            text_edit->setReadOnly(true);
+            image_view->SetImage(GetFeaturesImage(i));
+
+            main_window->setCentralWidget(splitter);
+            main_window->setWindowTitle(tr("特征提取图 - ") +
+                                        QString::number(i + 1));
+            main_window->setAttribute(Qt::WA_DeleteOnClose, true);
+            main_window->show();
+          });
+  connect(matches_view, &QTableView::doubleClicked, this,
+          [this](const QModelIndex &index) {
+            const int i = index.row();
+            const int j = index.column();
+            if (i == j) {
+              return;
+            }
+            CustomizeTitleWidget *main_window = new CustomizeTitleWidget();
+            connect(this, &MidDataView::destroyed, main_window,
+                    [main_window](QObject *) { main_window->close(); });
+            ImageView *image_view = new ImageView();
+            ImageView *image_view1 = new ImageView();
+            QTextEdit *text_edit = new QTextEdit();
+            QTableView *table_view = new QTableView();
+            QSplitter *splitter = new QSplitter();
+            QSplitter *splitter1 = new QSplitter();
+            QSplitter *splitter2 = new QSplitter();
+            splitter1->setOrientation(Qt::Vertical);
+            splitter1->addWidget(image_view);
+            splitter1->addWidget(image_view1);
+            splitter2->setOrientation(Qt::Vertical);
+            splitter2->addWidget(text_edit);
+            splitter2->addWidget(table_view);
+            splitter->addWidget(splitter1);
+            splitter->addWidget(splitter2);
+            if (auto matches = FindMatches(i, j); matches != nullptr) {
+              table_view->setModel(new MatchesTableModel(*matches, table_view));
+            }
+
+            text_edit->setText(GetMatchesText(i, j));
+            text_edit->setReadOnly(true);
+            image_view->SetImage(GetMatchesImage(i, j));
+            image_view1->SetImage(GetWarpImage(i, j));
+
+            main_window->setCentralWidget(splitter);
+
+            main_window->setWindowTitle(tr("匹配图 - ") +
+                                        QString::number(i + 1) + ", " +
+                                        QString::number(j + 1));
+            main_window->setAttribute(Qt::WA_DeleteOnClose, true);
+            main_window->show();
+          });
+
+  // 曝光补偿和拼接缝同样用表格视图，双击有数据的单元格查看
+  stages_model = new StageImagesModel(image_stitcher, image_length, this);
+  stages_view = new QTableView();
+  stages_view->setModel(stages_model);
+  stages_view->horizontalHeader()->setDefaultSectionSize(48);
+  stages_view->verticalHeader()->setDefaultSectionSize(24);
+  stages_view->horizontalHeader()->setSectionResizeMode(QHeaderView::Fixed);
+  stages_view->verticalHeader()->setSectionResizeMode(QHeaderView::Fixed);
+  stages_view->setSelectionMode(QAbstractItemView::SingleSelection);
+  stages_view->setEditTriggers(QAbstractItemView::NoEditTriggers);
+  stages_view->setVerticalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
+  stages_view->setFixedHeight(
+      stages_view->horizontalHeader()->sizeHint().height() +
+      StageImagesModel::STAGE_COUNT *
+          stages_view->verticalHeader()->defaultSectionSize() +
+      stages_view->horizontalScrollBar()->sizeHint().height() +
+      2 * stages_view->frameWidth());
+  grid_layout->addWidget(stages_view, 2, 0);
+
+  connect(
+      stages_view, &QTableView::doubleClicked, this,
+      [this](const QModelIndex &index) {
+        if (!(stages_model->flags(index) & Qt::ItemIsEnabled)) {
+          return;
+        }
+        const int i = index.column();
+        CustomizeTitleWidget *main_window = new CustomizeTitleWidget();
+        connect(this, &MidDataView::destroyed, main_window,
+                [main_window](QObject *) { main_window->close(); });
+        if (index.row() == StageImagesModel::COMPENSATOR) {
           ImageView *image_view = new ImageView();
           ImageView *image_view1 = new ImageView();
           QSplitter *splitter = new QSplitter();
@@ -644,44 +914,24 @@ void MidDataView::SetupUi() {
           splitter->addWidget(image_view);
           splitter->addWidget(image_view1);
 
-          image_view->SetImage(GetCompensatorImage(i)[0]);
-          image_view1->SetImage(GetCompensatorImage(i)[1]);
+          auto images = GetCompensatorImage(i);
+          image_view->SetImage(images[0]);
+          image_view1->SetImage(images[1]);
 
           main_window->setCentralWidget(splitter);
-
           main_window->setWindowTitle(tr("补偿 - ") + QString::number(i + 1));
-          main_window->setAttribute(Qt::WA_DeleteOnClose, true);
-          main_window->show();
-        });
-    compensator_buttons[i]->setText(QString::number(i + 1));
-    grid_layout->addWidget(compensator_buttons[i], image_length + 1, i + 1);
-  }
-
-  auto seam_label = new QLabel();
-  seam_label->setText("seam find result");
-  grid_layout->addWidget(seam_label, image_length * 2 + 1, 0);
-  seam_mask_buttons.resize(image_length);
-  for (int i = 0; i < image_length; ++i) {
-    seam_mask_buttons[i] = new QPushButton();
-    connect(seam_mask_buttons[i], &QPushButton::clicked, this,
-            [i, this](bool checked) {
-              CustomizeTitleWidget *main_window = new CustomizeTitleWidget();
-              connect(this, &MidDataView::destroyed, main_window,
-                      [main_window](QObject *) { main_window->close(); });
-              ImageView *image_view = new ImageView();
-
-              image_view->SetImage(GetSeamMaskImage(i));
+        } else {
+          ImageView *image_view = new ImageView();
 
-              main_window->setCentralWidget(image_view);
+          image_view->SetImage(GetSeamMaskImage(i));
 
-              main_window->setWindowTitle(tr("拼接缝裁剪 - ") +
-                                          QString::number(i + 1));
-              main_window->setAttribute(Qt::WA_DeleteOnClose, true);
-              main_window->show();
-            });
-    seam_mask_buttons[i]->setText(QString::number(i + 1));
-    grid_layout->addWidget(seam_mask_buttons[i], image_length * 2 + 1, i + 1);
-  }
+          main_window->setCentralWidget(image_view);
+          main_window->setWindowTitle(tr("拼接缝裁剪 - ") +
+                                      QString::number(i + 1));
+        }
+        main_window->setAttribute(Qt::WA_DeleteOnClose, true);
+        main_window->show();
+      });
 }
 
 QImage MidDataView::GetImage(const int index) {
@@ -716,36 +966,68 @@ QString MidDataView::GetFeaturesText(const int index) {
     return QString();
   }
   std::ostringstream text;
-  auto features = image_stitcher->ImagesFeatures()[index];
+  const auto &features = image_stitcher->ImagesFeatures()[index];
   text << "img_idx : " << features.img_idx << std::endl;
   text << "img_size : " << features.img_size << std::endl;
   text << "keypoint size : " << features.keypoints.size() << std::endl;
-  text << "keypoints : " << std::endl;
-  for (int i = 0; i < features.keypoints.size(); ++i) {
-    text << features.keypoints[i].pt << std::endl;
+  if (!features.keypoints.empty()) {
+    float min_response = std::numeric_limits<float>::max();
+    float max_response = std::numeric_limits<float>::lowest();
+    float min_size = std::numeric_limits<float>::max(), max_size = 0;
+    double sum_response = 0, sum_size = 0;
+    for (const auto &keypoint : features.keypoints) {
+      min_response = (std::min)(min_response, keypoint.response);
+      max_response = (std::max)(max_response, keypoint.response);
+      min_size = (std::min)(min_size, keypoint.size);
+      max_size = (std::max)(max_size, keypoint.size);
+      sum_response += keypoint.response;
+      sum_size += keypoint.size;
+    }
+    const size_t count = features.keypoints.size();
+    text << "response (min/mean/max) : " << min_response << " / "
+         << sum_response / count << " / " << max_response << std::endl;
+    text << "size (min/mean/max) : " << min_size << " / " << sum_size / count
+         << " / " << max_size << std::endl;
   }
-  text << "description : " << std::endl;
-  text << features.descriptors << std::endl;
+  text << "description : " << features.descriptors.rows << " x "
+       << features.descriptors.cols << " "
+       << cv::typeToString(features.descriptors.type()) << std::endl;
   return QString(text.str().c_str());
 }
+const MatchesInfo *MidDataView::FindMatches(const int index1,
+                                            const int index2) const {
+  const auto &features_matches =
+      std::as_const(*image_stitcher).FeaturesMatches();
+  auto it = features_matches.find({index1, index2});
+  return it == features_matches.end() ? nullptr : &it->second;
+}
 QString MidDataView::GetMatchesText(const int index1, const int index2) {
+  auto found = FindMatches(index1, index2);
+  if (found == nullptr) {
+    return tr("没有匹配结果");
+  }
   std::ostringstream text;
-  auto matches = image_stitcher->FeaturesMatches()[{index1, index2}];
+  const auto &matches = *found;
   text << "src_idx : " << matches.src_img_idx << std::endl;
   text << "dst_idx : " << matches.dst_img_idx << std::endl;
   text << "confidence : " << matches.confidence << std::endl;
   text << "H : " << std::endl;
   text << matches.H << std::endl;
   text << "inlier point size : " << matches.num_inliers << std::endl;
-  for (int i = 0; i < matches.getInliers().size(); ++i) {
-    text << int(matches.getInliers()[i]) << " ";
-  }
-  text << std::endl;
-  text << "DMatches : " << std::endl;
-  for (int i = 0; i < matches.getMatches().size(); ++i) {
-    const auto &dmatch = matches.getMatches()[i];
-    text << dmatch.imgIdx << " " << dmatch.queryIdx << " " << dmatch.trainIdx
-         << " " << dmatch.distance << std::endl;
+  text << "DMatches size : " << matches.matches.size() << std::endl;
+  if (!matches.matches.empty()) {
+    float min_distance = std::numeric_limits<float>::max(), max_distance = 0;
+    double sum_distance = 0;
+    for (const auto &dmatch : matches.matches) {
+      min_distance = (std::min)(min_distance, dmatch.distance);
+      max_distance = (std::max)(max_distance, dmatch.distance);
+      sum_distance += dmatch.distance;
+    }
+    text << "inlier ratio : "
+         << double(matches.num_inliers) / matches.matches.size() << std::endl;
+    text << "distance (min/mean/max) : " << min_distance << " / "
+         << sum_distance / matches.matches.size() << " / " << max_distance
+         << std::endl;
   }
   return QString(text.str().c_str());
 }
@@ -771,9 +1053,13 @@ CameraParams MidDataView::GetCameraParams(const int index) {
   }
   if (camera_params.size() != image_stitcher->FinalStitchImages().size()) {
     camera_params.resize(image_stitcher->FinalStitchImages().size());
-    auto comp = image_stitcher->component();
-    for (int i = 0; i < comp.size(); ++i) {
-      camera_params[comp[i]] = image_stitcher->FinalCameraParams()[i];
+    const auto &comp = image_stitcher->component();
+    const auto &cameras = image_stitcher->FinalCameraParams();
+    // 分量拼接失败时没有相机参数
+    for (int i = 0; i < comp.size() && i < cameras.size(); ++i) {
+      if (comp[i] < camera_params.size()) {
+        camera_params[comp[i]] = cameras[i];
+      }
     }
   }
   return camera_params[index];
@@ -794,7 +1080,12 @@ QImage MidDataView::GetMatchesImage(const int index1, const int index2) {
     const auto &image2 = image_stitcher->FinalStitchImages()[index2];
     const auto &features1 = image_stitcher->ImagesFeatures()[index1];
     const auto &features2 = image_stitcher->ImagesFeatures()[index2];
-    auto &matches = image_stitcher->FeaturesMatches()[{index1, index2}];
+    auto found = FindMatches(index1, index2);
+    if (found == nullptr) {
+      return QImage();
+    }
+    // DrawMatches需要可修改的匹配信息，复制一份
+    MatchesInfo matches = *found;
     matches_images[index1][index2] =
         cv2qt::CvMat2QImage(image_stitcher->DrawMatches(
             image1, features1, image2, features2, matches));
@@ -812,7 +1103,9 @@ QImage MidDataView::GetSeamMaskImage(const int index) {
   if (seam_mask_images[index].isNull()) {
     auto &comp = image_stitcher->component();
     int i = std::lower_bound(comp.begin(), comp.end(), index) - comp.begin();
-    if (i < comp.size() && comp[i] == index) {
+    // 部分拼接流程不记录拼接缝
+    if (i < comp.size() && comp[i] == index &&
+        i < image_stitcher->SeamMasks().size()) {
       seam_mask_images[index] =
           cv2qt::CvMat2QImage(image_stitcher->SeamMasks()[i]);
     } else {
@@ -833,10 +1126,16 @@ std::vector<QImage> MidDataView::GetCompensatorImage(const int index) {
   if (compensator_images[index].empty()) {
     auto &comp = image_stitcher->component();
     int i = std::lower_bound(comp.begin(), comp.end(), index) - comp.begin();
-    if (i < comp.size() && comp[i] == index) {
-      for (const auto &image : image_stitcher->CompensatorImages()[i]) {
+    const auto &images = image_stitcher->CompensatorImages();
+    // 部分拼接流程不记录曝光补偿前后的图像
+    if (i < comp.size() && comp[i] == index && i < images.size()) {
+      for (const auto &image : images[i]) {
         compensator_images[index].push_back(cv2qt::CvMat2QImage(image));
       }
+      // 界面固定显示两张
+      if (compensator_images[index].size() < 2) {
+        compensator_images[index].resize(2);
+      }
     } else {
       return std::vector<QImage>(2);
     }
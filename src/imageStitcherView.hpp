@@ -1,12 +1,15 @@
 #pragma once
 
+#include <QAbstractTableModel>
 #include <QComboBox>
 #include <QDialog>
 #include <QFormLayout>
 #include <QPushButton>
 #include <QScrollArea>
 #include <QSplitter>
+#include <QTableView>
 #include <QWidget>
+#include <atomic>
 #include <future>
 
 #include "core/imageStitcher/imageStitcher.hpp"
@@ -47,15 +50,135 @@ class ConfigDialog : public QDialog {
   QPushButton *cancel_button;
 };
 
+/**
+ * @brief 分页加载的只读表格，视图滚动到末尾时每次多加载一页，
+ * 单元格文本只在显示时格式化。
+ */
+class PagedTableModel : public QAbstractTableModel {
+ public:
+  static constexpr int kPageSize = 1000;
+
+ public:
+  PagedTableModel(const QStringList &headers, QObject *parent = nullptr);
+  int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+  int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+  QVariant data(const QModelIndex &index,
+                int role = Qt::DisplayRole) const override;
+  QVariant headerData(int section, Qt::Orientation orientation,
+                      int role = Qt::DisplayRole) const override;
+  bool canFetchMore(const QModelIndex &parent) const override;
+  void fetchMore(const QModelIndex &parent) override;
+
+ protected:
+  virtual int TotalRows() const = 0;
+  virtual QVariant Cell(const int row, const int column) const = 0;
+
+ private:
+  QStringList _headers;
+  int _loaded_rows = kPageSize;
+};
+
+/**
+ * @brief 图像的特征点和描述子，每行一个特征点
+ */
+class KeypointsTableModel : public PagedTableModel {
+ public:
+  KeypointsTableModel(const ImageFeatures &features,
+                      QObject *parent = nullptr);
+
+ protected:
+  int TotalRows() const override;
+  QVariant Cell(const int row, const int column) const override;
+
+ private:
+  KeyPoints _keypoints;
+  Mat _descriptors;
+};
+
+/**
+ * @brief 两图之间的DMatch，每行一个匹配
+ */
+class MatchesTableModel : public PagedTableModel {
+ public:
+  MatchesTableModel(const MatchesInfo &matches, QObject *parent = nullptr);
+
+ protected:
+  int TotalRows() const override;
+  QVariant Cell(const int row, const int column) const override;
+
+ private:
+  std::vector<cv::DMatch> _matches;
+  std::vector<uchar> _inliers;
+};
+
+/**
+ * @brief 匹配置信度矩阵，行列为图像下标，按置信度着色。
+ * 构造时把稀疏的匹配结果展开成稠密的置信度表，之后不再访问拼接器。
+ */
+class MatchMatrixModel : public QAbstractTableModel {
+ public:
+  MatchMatrixModel(const ImageStitcher *image_stitcher, const int count,
+                   const double thresh, QObject *parent = nullptr);
+  int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+  int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+  QVariant data(const QModelIndex &index,
+                int role = Qt::DisplayRole) const override;
+  QVariant headerData(int section, Qt::Orientation orientation,
+                      int role = Qt::DisplayRole) const override;
+  Qt::ItemFlags flags(const QModelIndex &index) const override;
+
+ private:
+  int _count;
+  double _thresh;
+  float _max_confidence = 0;
+  // 没有匹配结果的位置为负数
+  std::vector<float> _confidences;
+};
+
+/**
+ * @brief 各阶段逐图的中间结果，行为阶段，列为图像下标。
+ * 构造时记录哪些图像有该阶段的数据，没有数据的单元格不可选。
+ */
+class StageImagesModel : public QAbstractTableModel {
+ public:
+  enum Stage { COMPENSATOR, SEAM_MASK, STAGE_COUNT };
+
+ public:
+  StageImagesModel(const ImageStitcher *image_stitcher, const int count,
+                   QObject *parent = nullptr);
+  int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+  int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+  QVariant data(const QModelIndex &index,
+                int role = Qt::DisplayRole) const override;
+  QVariant headerData(int section, Qt::Orientation orientation,
+                      int role = Qt::DisplayRole) const override;
+  Qt::ItemFlags flags(const QModelIndex &index) const override;
+
+ private:
+  int _count;
+  // 按(阶段, 图像下标)展开
+  std::vector<char> _available;
+};
+
 class MidDataView : public QWidget {
  public:
   MidDataView(ImageStitcher *image_stitcher, QWidget *parent = nullptr);
   void SetupUi();
+  /**
+   * @brief 查找两图的匹配结果，不存在时返回nullptr，不会向拼接器插入空项
+   */
+  const MatchesInfo *FindMatches(const int index1, const int index2) const;
   QImage GetImage(const int index);
   QImage GetFeaturesImage(const int index);
   QImage GetMatchesImage(const int index1, const int index2);
   QImage GetWarpImage(const int index1, const int index2);
+  /**
+   * @brief 特征的统计信息，逐个特征点的数据见KeypointsTableModel
+   */
   QString GetFeaturesText(const int index);
+  /**
+   * @brief 匹配的统计信息，逐个匹配的数据见MatchesTableModel
+   */
   QString GetMatchesText(const int index1, const int index2);
   QString GetCameraParamsText(const int index);
   CameraParams GetCameraParams(const int index);
@@ -72,11 +195,10 @@ class MidDataView : public QWidget {
   std::vector<QImage> seam_mask_images;
   std::vector<CameraParams> camera_params;
   QGridLayout *grid_layout;
-  std::vector<QPushButton *> features_buttons;
-  std::vector<QPushButton *> original_buttons;
-  std::vector<std::vector<QPushButton *>> matches_buttons;
-  std::vector<QPushButton *> compensator_buttons;
-  std::vector<QPushButton *> seam_mask_buttons;
+  QTableView *matches_view;
+  MatchMatrixModel *matches_model;
+  QTableView *stages_view;
+  StageImagesModel *stages_model;
 };
 
 class ImageStitcherView : public QWidget {
@@ -88,6 +210,10 @@ class ImageStitcherView : public QWidget {
   void CreateFromDirectory(const QString &path);
   void ShowImage(const QPixmap &pixmap);
   void ShowImage(const QImage &image);
+  /**
+   * @brief 显示融合进度预览，拼接结束后到达的预览会被丢弃
+   */
+  void ShowPreview(const QImage &image);
   void ShowMessage(const QString &message);
   inline Parameters &Params() { return image_stitcher.GetParams(); }
   inline void SetParams(const Parameters &params) {
@@ -115,6 +241,7 @@ class ImageStitcherView : public QWidget {
     void SetProgress(const float progress);
     void ShowMessage(const std::string &message, int timeout = 0);
     void Result(std::vector<ImagePtr> img);
+    void Preview(ImagePtr image);
 
    protected:
     std::vector<QImage> images;
@@ -132,6 +259,7 @@ class ImageStitcherView : public QWidget {
 
  private:
   ImageItemModel *m_model;
+  std::atomic<bool> _previewing{false};
   ImageBox *input_image_box;
   ImageView *result_view_widget;
   QPushButton *stitch_button;
@@ -6,6 +6,7 @@
 #include <QStyleFactory>
 
 #include "mainWindow.h"
+#include "core/qtCommon/signal2qt.hpp"
 
 int main(int argc, char *argv[]) {
 #ifdef WIN 
@@ -16,6 +17,8 @@ int main(int argc, char *argv[]) {
 #endif
 #endif
   QApplication a(argc, argv);
+  // 拼接线程发出的信号由界面线程的事件循环调用槽
+  signal2qt::InstallCallQueue();
   MainWindow w;
   w.show();
   a.setFont(QFont("黑体", 12));
@@ -0,0 +1,205 @@
+// This file is part of MyProject
+// Author: llhsdmd(llhsdmd@qq.com)
+// Copyright (c) 2021 Your Company
+
+#include <atomic>
+#include <thread>
+
+#include "trackable.hpp"
+
+namespace {
+#ifdef SIGNAL_QUEUE_TEST_HOOKS
+void (*last_pop_hook)() = nullptr;
+#endif
+
+struct PendingCall {
+  std::atomic<PendingCall *> next{nullptr};
+  void (*fn)(void *) = nullptr;
+  void *param = nullptr;
+};
+/**
+ * @brief Pending calls of a thread,multi-producer single-consumer lock-free
+ * queue(Dmitry Vyukov's intrusive MPSC queue)
+ *
+ */
+struct CallQueue {
+  std::thread::id thread;
+  std::atomic<bool> active{false};
+  //< Pushes in progress,the owner waits for them before dispatching the last
+  //< calls or changing notify
+  std::atomic<int> pushing{0};
+  //< Written only while inactive and no push in progress,published by active
+  void (*notify)(void *) = nullptr;
+  void *user = nullptr;
+  //< A wakeup is pending,only the first push of a batch notifies
+  std::atomic<bool> scheduled{false};
+  std::atomic<PendingCall *> head{&stub}; //< Pushed by the emitting threads
+  PendingCall *tail = &stub;              //< Popped by the owner thread
+  PendingCall stub;
+  CallQueue *next = nullptr;
+
+  void push(PendingCall *call) {
+    call->next.store(nullptr, std::memory_order_relaxed);
+    PendingCall *prev = head.exchange(call, std::memory_order_acq_rel);
+    // The consumer stops at prev until the link is stored
+    prev->next.store(call, std::memory_order_release);
+  }
+  /**
+   * @brief Pop a call,only called by the owner thread
+   *
+   * @return PendingCall* nullptr if empty or a push is in progress
+   */
+  PendingCall *pop() {
+    PendingCall *first = tail;
+    PendingCall *next = first->next.load(std::memory_order_acquire);
+    if (first == &stub) {
+      if (next == nullptr) {
+        return nullptr;
+      }
+      tail = next;
+      first = next;
+      next = next->next.load(std::memory_order_acquire);
+    }
+    if (next != nullptr) {
+      tail = next;
+      return first;
+    }
+    if (first != head.load(std::memory_order_acquire)) {
+      return nullptr;
+    }
+#ifdef SIGNAL_QUEUE_TEST_HOOKS
+    if (last_pop_hook != nullptr) {
+      last_pop_hook();
+    }
+#endif
+    // first is the last call,put the stub after it so it can be popped.A call
+    // pushed since the check above ends up before the stub
+    push(&stub);
+    next = first->next.load(std::memory_order_acquire);
+    if (next != nullptr) {
+      tail = next;
+      return first;
+    }
+    return nullptr;
+  }
+};
+//< Queues are never deleted,so the emitting threads can walk it without lock
+std::atomic<CallQueue *> queues{nullptr};
+thread_local CallQueue *current_queue = nullptr;
+
+/**
+ * @brief Stop accepting calls,return after the running pushes finished
+ *
+ */
+void Deactivate(CallQueue *queue) {
+  // Pairs with _PushQueuedCall,either the pusher sees inactive or we see it
+  queue->active.store(false);
+  while (queue->pushing.load() != 0) {
+    std::this_thread::yield();
+  }
+}
+CallQueue *FindQueue(std::thread::id thread) {
+  for (auto queue = queues.load(); queue != nullptr; queue = queue->next) {
+    if (queue->thread == thread) {
+      return queue;
+    }
+  }
+  return nullptr;
+}
+/**
+ * @brief Run the calls in the queue
+ *
+ * @param end Stop after the call,nullptr for all calls
+ */
+size_t Dispatch(CallQueue *queue, const PendingCall *end) {
+  size_t count = 0;
+  while (PendingCall *call = queue->pop()) {
+    call->fn(call->param);
+    ++count;
+    const bool last = call == end;
+    delete call;
+    if (last) {
+      break;
+    }
+  }
+  return count;
+}
+} // namespace
+
+void *_SlotPriv::_GetQueue() { return current_queue; }
+void *_SlotPriv::_GetQueue(std::thread::id thread) {
+  CallQueue *queue = FindQueue(thread);
+  if (queue == nullptr || !queue->active) {
+    return nullptr;
+  }
+  return queue;
+}
+#ifdef SIGNAL_QUEUE_TEST_HOOKS
+namespace _SlotPriv {
+//< Test only,called when the owner is about to pop the last call of its queue
+void _SetLastPopHook(void (*hook)()) { last_pop_hook = hook; }
+} // namespace _SlotPriv
+#endif
+bool _SlotPriv::_PushQueuedCall(void *q, void (*fn)(void *), void *param) {
+  auto *queue = static_cast<CallQueue *>(q);
+  queue->pushing.fetch_add(1);
+  // The queue may be uninstalled after the caller found it,the calls pushed
+  // after its last dispatch would never run
+  if (!queue->active.load()) {
+    queue->pushing.fetch_sub(1);
+    return false;
+  }
+  auto *call = new PendingCall;
+  call->fn = fn;
+  call->param = param;
+  queue->push(call);
+  // Pairs with DispatchQueuedCalls,the owner either sees the call in this
+  // batch or has cleared the flag so we wake it up again
+  if (!queue->scheduled.exchange(true, std::memory_order_acq_rel)) {
+    queue->notify(queue->user);
+  }
+  queue->pushing.fetch_sub(1);
+  return true;
+}
+
+void InstallCallQueue(void (*notify)(void *user), void *user) {
+  const auto thread = std::this_thread::get_id();
+  CallQueue *queue = FindQueue(thread);
+  if (queue == nullptr) {
+    queue = new CallQueue;
+    queue->thread = thread;
+    queue->next = queues.load();
+    while (!queues.compare_exchange_weak(queue->next, queue)) {
+    }
+  }
+  // Installing again replaces notify,the running pushes may be reading it
+  Deactivate(queue);
+  queue->notify = notify;
+  queue->user = user;
+  queue->scheduled = false;
+  queue->active.store(true);
+  current_queue = queue;
+}
+void UninstallCallQueue() {
+  if (current_queue == nullptr) {
+    return;
+  }
+  // The emitting threads call the slots directly from now on
+  Deactivate(current_queue);
+  Dispatch(current_queue, nullptr);
+  current_queue = nullptr;
+}
+size_t DispatchQueuedCalls() {
+  CallQueue *queue = current_queue;
+  if (queue == nullptr) {
+    return 0;
+  }
+  queue->scheduled.exchange(false, std::memory_order_acq_rel);
+  // Only the calls pushed before now,the later ones have notified again,so
+  // the event loop is not starved by busy emitters
+  const PendingCall *end = queue->head.load(std::memory_order_acquire);
+  // The stub is the head when the queue is empty,or when a call was pushed
+  // while the last pop put the stub back,then the call is before the stub and
+  // would never be the end,so run until the queue is empty
+  return Dispatch(queue, end == &queue->stub ? nullptr : end);
+}
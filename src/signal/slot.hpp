@@ -19,10 +19,14 @@ furnished to do so...
 
 #pragma once
 
+#include <atomic>
 #include <functional>
 #include <list>
 #include <memory>
+#include <mutex>
+#include <thread>
 #include <tuple>
+#include <vector>
 #include <cstring>
 
 #include "call.hpp"
@@ -31,10 +35,34 @@ furnished to do so...
 namespace _SlotPriv {
 
 void *_GetQueue();
-void _PushQueuedCall(void *, void (*fn)(void *), void *param);
+void *_GetQueue(std::thread::id thread); //< nullptr if the thread has no queue
+//< false if the queue is uninstalled,the caller should call it directly
+bool _PushQueuedCall(void *, void (*fn)(void *), void *param);
 
 } // namespace _SlotPriv
 
+/**
+ * @brief Install the call queue for current thread,the slots of Trackable
+ * living in the thread are queued when the signal is emitted in other threads
+ *
+ * @param notify Called in the emitting thread after a call queued,it should
+ * wake up current thread to call DispatchQueuedCalls()
+ * @param user The userdata for notify
+ */
+void InstallCallQueue(void (*notify)(void *user), void *user);
+/**
+ * @brief Uninstall the call queue of current thread,the pending calls are
+ * dispatched
+ *
+ */
+void UninstallCallQueue();
+/**
+ * @brief Call all pending calls of current thread
+ *
+ * @return size_t The number of the calls
+ */
+size_t DispatchQueuedCalls();
+
 // Emm, Maybe we should use our clang-format to format it
 // Formated with WebKit style
 struct _QueuedConnection {};
@@ -288,18 +316,42 @@ struct _TimerID {
 class _SlotBase {
 protected:
   //< pointer for delete the slot
-  typedef void (*CleanupFn)(void *self, bool from_object);
+  typedef void (*CleanupFn)(void *self);
+  //< pointer for remove the slot from the object
+  typedef void (*DetachFn)(void *self);
   CleanupFn cleanup_ptr;
+  DetachFn detach_ptr = nullptr;
+  std::thread::id thread; //< Thread of the object,empty for common callable
+  Trackable *object = nullptr; //< nullptr for common callable
+  bool queued = false;    //< Queued even if emitted in the same thread
 
   _SlotBase(CleanupFn f) : cleanup_ptr(f){};
 
 private:
+  //< Disconnected,the running emission and the queued calls skip it
+  std::atomic<bool> removed{false};
+  //< Held by the signal and the queued calls
+  std::atomic<int> refcount{1};
+
+  void ref() { refcount.fetch_add(1, std::memory_order_relaxed); }
   /**
-   * @brief Delete the slot
+   * @brief Delete the slot after the last reference released
+   *
+   */
+  void unref() {
+    if (refcount.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+      cleanup_ptr(this);
+    }
+  }
+  /**
+   * @brief Remove the slot's functor from the object
    *
-   * @param from_object Is the Trackable::~Trackable call the method?
    */
-  void cleanup(bool from_object = false) { cleanup_ptr(this, from_object); }
+  void detach() {
+    if (detach_ptr != nullptr) {
+      detach_ptr(this);
+    }
+  }
   template <class RetT> friend class Signal;
   friend class SignalBase;
   friend class Connection;
@@ -341,7 +393,7 @@ protected:
    * @brief Delete self
    *
    */
-  static void Delete(void *self, bool) { delete static_cast<_MemSlot *>(self); }
+  static void Delete(void *self) { delete static_cast<_MemSlot *>(self); }
   static RetT Invoke(void *self, Args... args) {
     return static_cast<_MemSlot *>(self)->invoke(std::forward<Args>(args)...);
   }
@@ -364,17 +416,11 @@ template <class Callable, class RetT, class... Args>
 class _ClassSlot : public _Slot<RetT, Args...> {
 protected:
   Callable callable;
-  Trackable *object;
   _FunctorLocation location;
-  static void Delete(void *self, bool from_object) {
-    std::unique_ptr<_ClassSlot> ptr(static_cast<_ClassSlot *>(self));
-    // Call from object
-    if (!from_object) {
-      //< lock the object
-      // Btk::lock_guard<Trackable> locker(*(ptr->object));
-
-      ptr->object->Trackable::remove_callback(ptr->location);
-    }
+  static void Delete(void *self) { delete static_cast<_ClassSlot *>(self); }
+  static void Detach(void *self) {
+    auto *slot = static_cast<_ClassSlot *>(self);
+    slot->object->Trackable::remove_callback(slot->location);
   }
   static RetT Invoke(void *self, Args... args) {
     return static_cast<_ClassSlot *>(self)->invoke(std::forward<Args>(args)...);
@@ -382,14 +428,14 @@ protected:
   RetT invoke(Args... args) {
     return _Call(callable, std::forward<Args>(args)...);
   }
-  _ClassSlot(Callable &&c, Trackable *o)
-      : _Slot<RetT, Args...>(Delete, Invoke), callable(c), object(o) {}
+  _ClassSlot(Callable &&c, Trackable *o);
   template <class T> friend class Signal;
   friend class Trackable;
 };
 class _GenericCallBase {
 protected:
-  bool deleted = false;
+  std::mutex mutex;     //< Guard deleted
+  bool deleted = false; //< The object destroyed before the call
   friend struct _GenericCallFunctor;
 };
 /**
@@ -507,11 +553,19 @@ public:
   FunctorLocation remove_callback_safe(FunctorLocation location) {
     return impl().remove_callback_safe(location);
   }
+  /**
+   * @brief The thread the object created in,the slots are queued to the thread
+   * if it has a call queue and the signal is emitted in other threads
+   *
+   * @return std::thread::id
+   */
+  std::thread::id thread_id() const noexcept { return _thread; }
 
 private:
   struct Impl {
+    //< Guard functors_cb,a thread holding it only try_lock the signals
+    std::recursive_mutex mutex;
     std::list<Functor> functors_cb;
-    // mutable SpinLock spinlock;//<SDL_spinlock for multithreading
 
     // Member
     void disconnect_all();
@@ -522,6 +576,13 @@ private:
     FunctorLocation exec_functor(FunctorLocation location);
     FunctorLocation remove_callback(FunctorLocation location);
     FunctorLocation remove_callback_safe(FunctorLocation location);
+    /**
+     * @brief Call and remove the functor with mutex locked,the signal of a
+     * connection is locked too
+     *
+     * @return false The signal is busy,release mutex and retry
+     */
+    bool call_functor(std::list<Functor>::iterator iter);
     // TimerID add_timer(Uint32 internal);
 
     // void dump_functors(FILE *output = stderr) const;
@@ -532,9 +593,20 @@ private:
    * @return Data&
    */
   Impl &impl() const;
-  mutable Impl *_impl = nullptr; //<For lazy
+  std::recursive_mutex &mutex() const { return impl().mutex; }
+  mutable std::atomic<Impl *> _impl{nullptr}; //<For lazy
+  std::thread::id _thread = std::this_thread::get_id();
   template <class RetT> friend class Signal;
+  friend class SignalBase;
 };
+// Need the complete Trackable
+template <class Callable, class RetT, class... Args>
+_ClassSlot<Callable, RetT, Args...>::_ClassSlot(Callable &&c, Trackable *o)
+    : _Slot<RetT, Args...>(Delete, Invoke), callable(c) {
+  this->object = o;
+  this->detach_ptr = Detach;
+  this->thread = o->Trackable::thread_id();
+}
 /**
  * @brief Functor for Connection
  *
@@ -562,7 +634,7 @@ public:
    * @return true
    * @return false
    */
-  bool empty() const { return _slots.empty(); }
+  bool empty() const { return _snapshot.load() == nullptr; }
   /**
    * @brief The signal is emitting?
    *
@@ -584,8 +656,56 @@ public:
   void disconnect_all();
 
 protected:
-  std::list<_SlotBase *> _slots; //< All _slots
-  // mutable SpinLock spinlock;//< SDL_spinlock for multithreading
+  typedef std::list<_SlotBase *>::iterator Iterator;
+  typedef std::vector<_SlotBase *> SlotArray;
+  /**
+   * @brief Disconnect the slot,the slot is deleted after all emissions
+   * finished
+   *
+   * @param iter
+   * @param from_object Is the Trackable::~Trackable call the method?
+   */
+  void remove_slot(Iterator iter, bool from_object);
+  /**
+   * @brief Replace the snapshot for emission after _slots changed,must be
+   * called with mutex() locked
+   *
+   */
+  void publish_slots();
+  /**
+   * @brief Delete the removed slots and the old snapshots if no one emitting
+   *
+   */
+  void sweep_slots();
+  /**
+   * @brief Keep the snapshot and the slots alive during emission
+   *
+   */
+  class EmitGuard {
+  public:
+    EmitGuard(const SignalBase *signal) : signal(signal) {
+      signal->_emitting.fetch_add(1);
+    }
+    ~EmitGuard() {
+      if (signal->_emitting.fetch_sub(1) == 1 && signal->_has_retired) {
+        const_cast<SignalBase *>(signal)->sweep_slots();
+      }
+    }
+
+  private:
+    const SignalBase *signal;
+  };
+
+  //< All _slots,guarded by mutex().Lock order is signal then object,a thread
+  //< holding an object only try_lock the signals
+  std::list<_SlotBase *> _slots;
+  //< Immutable copy of _slots for emission,nullptr if empty
+  std::atomic<const SlotArray *> _snapshot{nullptr};
+  //< Removed slots and old snapshots,guarded by mutex()
+  std::vector<_SlotBase *> _retired_slots;
+  std::vector<const SlotArray *> _retired_snapshots;
+  mutable std::atomic<int> _emitting{0};  //< Number of running emissions
+  std::atomic<bool> _has_retired{false}; //< Anything waiting for delete
   template <class RetT> friend class Signal;
   friend class Connection;
 };
@@ -607,66 +727,47 @@ public:
    * @return RetT The return type
    */
   RetT notify(Args... args) const {
-    // lock the signalbase
-    //  lock_guard<const SignalBase> locker(*this);
-    // why it has complie error on msvc
-    // std::is_same<void,RetT>()
     if (empty()) {
       return RetT();
     }
-
+    // Walk the snapshot without lock,it and the slots removed by other
+    // threads or the callback are deleted after all emissions finished
+    EmitGuard guard(this);
+    const SlotArray *slots = _snapshot.load();
+    if (slots == nullptr) {
+      return RetT();
+    }
+    // Slots connected in the callback are not called by this emission
+    const auto current = std::this_thread::get_id();
     if constexpr (std::is_same<void, RetT>::value) {
-#if 1
-      // FIXME : It may be slow, but it as safe when user disconnect
-      // the signal in the callback
-      auto _slots = this->_slots;
-#endif
-
-      for (auto slot : _slots) {
-        static_cast<_Slot<RetT, Args...> *>(slot)->invoke(
-            std::forward<Args>(args)...);
+      for (_SlotBase *slot : *slots) {
+        // args may be used by the next slot,don't forward it
+        if (!slot->removed && !queue_call(slot, current, args...)) {
+          static_cast<_Slot<RetT, Args...> *>(slot)->invoke(args...);
+        }
       }
     } else {
-#if 1
-      // FIXME : It may be slow, but it as safe when user disconnect
-      // the signal in the callback
-      auto _slots = this->_slots;
-#endif
       RetT ret{};
-      for (auto slot : _slots) {
-        ret = static_cast<_Slot<RetT, Args...> *>(slot)->invoke(
-            std::forward<Args>(args)...);
+      for (_SlotBase *slot : *slots) {
+        if (!slot->removed && !queue_call(slot, current, args...)) {
+          ret = static_cast<_Slot<RetT, Args...> *>(slot)->invoke(args...);
+        }
       }
       return ret;
     }
   }
   /**
-   * @brief Emit with nothrow
+   * @brief Same as notify,queued slots included
    *
    * @param args
    * @return RetT
    */
   RetT nothrow_emit(Args... args) const {
-    // lock the signalbase
-    //  lock_guard<const SignalBase> locker(*this);
-    // why it has complie error on msvc
-    // std::is_same<void,RetT>()
-    if constexpr (std::is_same<void, RetT>::value) {
-      for (auto slot : _slots) {
-        static_cast<_Slot<RetT, Args...> *>(slot)->invoke(
-            std::forward<Args>(args)...);
-      }
-    } else {
-      RetT ret{};
-      for (auto slot : _slots) {
-        ret = static_cast<_Slot<RetT, Args...> *>(slot)->invoke(
-            std::forward<Args>(args)...);
-      }
-      return ret;
-    }
+    return notify(std::forward<Args>(args)...);
   }
   /**
-   * @brief Push the notify into event queue
+   * @brief Push the notify into the call queue of current thread,emit now if
+   * the thread has no call queue
    *
    * @param args
    */
@@ -674,7 +775,21 @@ public:
     if (empty()) {
       return;
     }
-    defer_call(&Signal::defer_emit_entry, std::forward<Args>(args)...);
+    void *queue = _SlotPriv::_GetQueue();
+    if (queue == nullptr) {
+      notify(args...);
+      return;
+    }
+    std::unique_lock<std::recursive_mutex> locker(mutex());
+    auto *call = new DeferredEmit(this, args...);
+    // Mark the call deleted if the signal destroyed before it
+    call->location = add_functor(_GenericCallFunctor(call));
+    if (!_SlotPriv::_PushQueuedCall(queue, defer_emit_entry, call)) {
+      remove_callback(call->location);
+      locker.unlock();
+      delete call;
+      notify(args...);
+    }
   }
   RetT operator()(Args... args) const {
     return notify(std::forward<Args>(args)...);
@@ -687,14 +802,39 @@ public:
    * @return Connection
    */
   template <class Callable> Connection connect(Callable &&callable) {
-    // lock_guard<const SignalBase> locker(*this);
+    return connect_slot(std::forward<Callable>(callable), false);
+  }
+  /**
+   * @brief Connect callable,the calls are always queued to the thread of the
+   * object or current thread for common callable,and return nothing
+   *
+   * @tparam Callable
+   * @param callable
+   * @return Connection
+   */
+  template <class Callable>
+  Connection connect(Callable &&callable, _QueuedConnection) {
+    return connect_slot(std::forward<Callable>(callable), true);
+  }
+  template <class Method, class TObject>
+  Connection connect(Method &&method, TObject *object) {
+    return connect_method(std::forward<Method>(method), object, false);
+  }
+  template <class Method, class TObject>
+  Connection connect(Method &&method, TObject *object, _QueuedConnection) {
+    return connect_method(std::forward<Method>(method), object, true);
+  }
 
+private:
+  template <class Callable>
+  Connection connect_slot(Callable &&callable, bool queued) {
     if constexpr (std::is_base_of_v<_BindWithMemFunction, Callable>) {
       // For callable bind with HasSlots
       using Slot = _ClassSlot<Callable, RetT, Args...>;
 
       Trackable *object =
           static_cast<_BindWithMemFunction &>(callable).object_ptr;
+      std::scoped_lock locker(mutex(), object->Trackable::mutex());
 
       Slot *slot = new Slot(std::forward<Callable>(callable), object);
       _slots.push_back(slot);
@@ -704,19 +844,25 @@ public:
       _ConnectionFunctor functor(con);
 
       slot->location = object->Trackable::add_functor(functor);
+      set_queued(slot, queued);
+      publish_slots();
       return {object, slot->location};
     } else {
       // For common callable
       using Slot = _MemSlot<Callable, RetT, Args...>;
-      _slots.push_back(new Slot(std::forward<Callable>(callable)));
+      std::lock_guard<std::recursive_mutex> locker(mutex());
+      Slot *slot = new Slot(std::forward<Callable>(callable));
+      _slots.push_back(slot);
+      set_queued(slot, queued);
+      publish_slots();
       return Connection{this, --_slots.end()};
     }
   }
   template <class Method, class TObject>
-  Connection connect(Method &&method, TObject *object) {
+  Connection connect_method(Method &&method, TObject *object, bool queued) {
     static_assert(std::is_base_of<Trackable, TObject>(),
                   "Trackable must inherit HasSlots");
-    // lock_guard<const SignalBase> locker(*this);
+    std::scoped_lock locker(mutex(), object->Trackable::mutex());
 
     using ClassWrap = _MemberFunctionBinder<Method>;
     using Slot = _ClassSlot<ClassWrap, RetT, Args...>;
@@ -728,12 +874,102 @@ public:
     _ConnectionFunctor functor(con);
 
     slot->location = object->Trackable::add_functor(functor);
+    set_queued(slot, queued);
+    publish_slots();
 
     return {object, slot->location};
   }
-
-private:
+  static void set_queued(_SlotBase *slot, bool queued) {
+    if (!queued) {
+      return;
+    }
+    slot->queued = true;
+    if (slot->thread == std::thread::id()) {
+      slot->thread = std::this_thread::get_id();
+    }
+  }
+  /**
+   * @brief Call for the slot queued to the thread of the object
+   *
+   */
+  struct QueuedCall {
+    _Slot<RetT, Args...> *slot;
+    std::tuple<std::decay_t<Args>...> args;
+  };
+  /**
+   * @brief Queue the call if the object lives in another thread which has a
+   * call queue,the return value of the slot is dropped
+   *
+   * @param slot
+   * @param current The emitting thread
+   * @param args
+   * @return true The call is queued
+   */
+  static bool queue_call(_SlotBase *slot, std::thread::id current,
+                         Args &...args) {
+    if (slot->thread == std::thread::id() ||
+        (slot->thread == current && !slot->queued)) {
+      return false;
+    }
+    void *queue = _SlotPriv::_GetQueue(slot->thread);
+    if (queue == nullptr) {
+      return false;
+    }
+    // The slot is kept until the call finished
+    slot->ref();
+    auto *call =
+        new QueuedCall{static_cast<_Slot<RetT, Args...> *>(slot), {args...}};
+    if (!_SlotPriv::_PushQueuedCall(queue, queued_entry, call)) {
+      delete call;
+      slot->unref();
+      return false;
+    }
+    return true;
+  }
+  static void queued_entry(void *self) {
+    std::unique_ptr<QueuedCall> call(static_cast<QueuedCall *>(self));
+    // Disconnected or the object destroyed before the call
+    if (!call->slot->removed) {
+      std::apply([&](auto &...args) { call->slot->invoke(args...); },
+                 call->args);
+    }
+    call->slot->unref();
+  }
+  /**
+   * @brief Notify pushed by defer_emit
+   *
+   */
+  class DeferredEmit : public _GenericCallBase {
+  public:
+    DeferredEmit(Signal *signal, Args &...args)
+        : signal(signal), args(args...) {}
+    bool destroyed() const { return deleted; }
+    using _GenericCallBase::mutex;
+
+    Signal *signal;
+    FunctorLocation location;
+    std::tuple<std::decay_t<Args>...> args;
+  };
   //< Impl for defer notify
-  void defer_emit_entry(Args... args) { notify(std::forward<Args>(args)...); }
+  static void defer_emit_entry(void *self) {
+    std::unique_ptr<DeferredEmit> call(static_cast<DeferredEmit *>(self));
+    while (true) {
+      std::unique_lock<std::mutex> locker(call->mutex);
+      if (call->destroyed()) {
+        return;
+      }
+      // The signal marks the call under its lock when destroying,so only
+      // try_lock it
+      if (call->signal->mutex().try_lock()) {
+        call->signal->remove_callback(call->location);
+        call->signal->mutex().unlock();
+        break;
+      }
+      locker.unlock();
+      std::this_thread::yield();
+    }
+    std::apply([&](auto &...args) { call->signal->notify(args...); },
+               call->args);
+  }
 };
 using HasSlots = Trackable;
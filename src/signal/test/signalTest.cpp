@@ -0,0 +1,370 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "../trackable.hpp"
+
+namespace Test {
+
+class Receiver : public Trackable {
+ public:
+  void OnValue(int value) {
+    values.push_back(value);
+    threads.push_back(std::this_thread::get_id());
+  }
+  std::vector<int> values;
+  std::vector<std::thread::id> threads;
+};
+
+void CountNotify(void *user) { ++*static_cast<std::atomic<int> *>(user); }
+
+TEST(SignalTest, NotifyAllSlots) {
+  Signal<void(int)> signal;
+  int sum = 0;
+  signal.connect([&sum](int value) { sum += value; });
+  signal.connect([&sum](int value) { sum += value * 10; });
+  signal(2);
+  EXPECT_EQ(sum, 22);
+}
+
+TEST(SignalTest, ArgumentsNotMovedBetweenSlots) {
+  Signal<void(std::shared_ptr<int>)> signal;
+  int count = 0;
+  for (int i = 0; i < 3; ++i) {
+    signal.connect([&count](std::shared_ptr<int> value) {
+      if (value != nullptr) {
+        ++count;
+      }
+    });
+  }
+  signal(std::make_shared<int>(1));
+  EXPECT_EQ(count, 3);
+}
+
+TEST(SignalTest, DisconnectSelfWhileEmitting) {
+  Signal<void(int)> signal;
+  Connection connection;
+  int first = 0, second = 0;
+  connection = signal.connect([&](int) {
+    ++first;
+    connection.disconnect();
+  });
+  signal.connect([&second](int) { ++second; });
+  signal(0);
+  signal(0);
+  EXPECT_EQ(first, 1);
+  EXPECT_EQ(second, 2);
+}
+
+TEST(SignalTest, DisconnectOtherWhileEmitting) {
+  Signal<void(int)> signal;
+  Connection connection;
+  int called = 0;
+  signal.connect([&connection](int) { connection.disconnect(); });
+  connection = signal.connect([&called](int) { ++called; });
+  signal(0);
+  EXPECT_EQ(called, 0);
+  EXPECT_FALSE(signal.empty());
+}
+
+TEST(SignalTest, ConnectWhileEmitting) {
+  Signal<void(int)> signal;
+  int called = 0;
+  signal.connect([&signal, &called](int) {
+    signal.connect([&called](int) { ++called; });
+  });
+  signal(0);
+  // 发出过程中连接的槽从下一次发出开始调用
+  EXPECT_EQ(called, 0);
+  signal(0);
+  EXPECT_EQ(called, 1);
+}
+
+TEST(SignalTest, ReceiverDestroyedWhileEmitting) {
+  Signal<void(int)> signal;
+  auto receiver = std::make_unique<Receiver>();
+  signal.connect([&receiver](int) { receiver.reset(); });
+  signal.connect(&Receiver::OnValue, receiver.get());
+  signal(1);
+  EXPECT_EQ(receiver, nullptr);
+  signal(2);
+}
+
+TEST(SignalTest, TrackableDisconnect) {
+  Signal<void(int)> signal;
+  {
+    Receiver receiver;
+    signal.connect(&Receiver::OnValue, &receiver);
+    signal(1);
+    EXPECT_EQ(receiver.values, std::vector<int>{1});
+  }
+  EXPECT_TRUE(signal.empty());
+  signal(2);
+}
+
+TEST(SignalTest, ReturnValue) {
+  Signal<int(int)> signal;
+  signal.connect([](int value) { return value + 1; });
+  signal.connect([](int value) { return value * 2; });
+  EXPECT_EQ(signal(5), 10);
+}
+
+TEST(SignalTest, ConcurrentConnectAndEmit) {
+  Signal<void(int)> signal;
+  std::atomic<int> total{0};
+  signal.connect([&total](int value) { total += value; });
+  std::atomic<bool> running{true};
+  std::vector<std::thread> threads;
+  // 其他线程不断连接和断开，常驻的槽不受影响
+  for (int i = 0; i < 2; ++i) {
+    threads.emplace_back([&signal, &running]() {
+      while (running) {
+        auto connection = signal.connect([](int) {});
+        connection.disconnect();
+      }
+    });
+  }
+  std::vector<std::thread> emitters;
+  for (int i = 0; i < 4; ++i) {
+    emitters.emplace_back([&signal]() {
+      for (int j = 0; j < 10000; ++j) {
+        signal(1);
+      }
+    });
+  }
+  for (auto &emitter : emitters) {
+    emitter.join();
+  }
+  running = false;
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(total, 40000);
+}
+
+TEST(SignalTest, QueuedToReceiverThread) {
+  std::atomic<int> notified{0};
+  InstallCallQueue(CountNotify, &notified);
+  Signal<void(int)> signal;
+  Receiver receiver;
+  signal.connect(&Receiver::OnValue, &receiver);
+  std::thread([&signal]() {
+    signal(1);
+    signal(2);
+  }).join();
+  EXPECT_TRUE(receiver.values.empty());
+  EXPECT_GT(notified, 0);
+  EXPECT_EQ(DispatchQueuedCalls(), 2);
+  EXPECT_EQ(receiver.values, (std::vector<int>{1, 2}));
+  EXPECT_EQ(receiver.threads[0], std::this_thread::get_id());
+  // 同一线程内仍然直接调用
+  signal(3);
+  EXPECT_EQ(receiver.values.size(), 3);
+  UninstallCallQueue();
+}
+
+TEST(SignalTest, QueuedCallAfterReceiverDestroyed) {
+  std::atomic<int> notified{0};
+  InstallCallQueue(CountNotify, &notified);
+  Signal<void(int)> signal;
+  auto receiver = std::make_unique<Receiver>();
+  signal.connect(&Receiver::OnValue, receiver.get());
+  std::thread([&signal]() { signal(1); }).join();
+  receiver.reset();
+  EXPECT_TRUE(signal.empty());
+  EXPECT_EQ(DispatchQueuedCalls(), 1);
+  UninstallCallQueue();
+}
+
+TEST(SignalTest, DirectCallWithoutQueue) {
+  Signal<void(int)> signal;
+  Receiver receiver;
+  signal.connect(&Receiver::OnValue, &receiver);
+  std::thread([&signal]() { signal(1); }).join();
+  EXPECT_EQ(receiver.values, std::vector<int>{1});
+}
+TEST(SignalTest, QueuedConnection) {
+  std::atomic<int> notified{0};
+  InstallCallQueue(CountNotify, &notified);
+  Signal<void(int)> signal;
+  Receiver receiver;
+  int called = 0;
+  signal.connect([&called](int) { ++called; }, QueuedConnection);
+  signal.connect(&Receiver::OnValue, &receiver, QueuedConnection);
+  signal(1);
+  // 同一线程内也排队
+  EXPECT_EQ(called, 0);
+  EXPECT_TRUE(receiver.values.empty());
+  EXPECT_EQ(notified, 1);
+  EXPECT_EQ(DispatchQueuedCalls(), 2);
+  EXPECT_EQ(called, 1);
+  EXPECT_EQ(receiver.values, std::vector<int>{1});
+  UninstallCallQueue();
+}
+
+TEST(SignalTest, DeferEmit) {
+  std::atomic<int> notified{0};
+  InstallCallQueue(CountNotify, &notified);
+  Receiver receiver;
+  auto signal = std::make_unique<Signal<void(int)>>();
+  signal->connect(&Receiver::OnValue, &receiver);
+  signal->defer_emit(1);
+  EXPECT_TRUE(receiver.values.empty());
+  EXPECT_EQ(DispatchQueuedCalls(), 1);
+  EXPECT_EQ(receiver.values, std::vector<int>{1});
+  // 信号在排队的发出执行前析构
+  signal->defer_emit(2);
+  signal.reset();
+  EXPECT_EQ(DispatchQueuedCalls(), 1);
+  EXPECT_EQ(receiver.values, std::vector<int>{1});
+  UninstallCallQueue();
+}
+
+TEST(SignalTest, QueuedFromManyThreads) {
+  std::atomic<int> notified{0};
+  InstallCallQueue(CountNotify, &notified);
+  Signal<void(int)> signal;
+  Receiver receiver;
+  signal.connect(&Receiver::OnValue, &receiver);
+  const int threads_count = 4, emits_count = 5000;
+  std::vector<std::thread> threads;
+  for (int i = 0; i < threads_count; ++i) {
+    threads.emplace_back([&signal, i]() {
+      for (int j = 0; j < emits_count; ++j) {
+        signal(i * emits_count + j);
+      }
+    });
+  }
+  const size_t total = threads_count * emits_count;
+  size_t dispatched = 0;
+  while (dispatched < total) {
+    dispatched += DispatchQueuedCalls();
+    std::this_thread::yield();
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  ASSERT_EQ(receiver.values.size(), total);
+  // 每个线程发出的调用保持顺序，一批调用只唤醒一次
+  std::vector<int> last(threads_count, -1);
+  for (int value : receiver.values) {
+    EXPECT_GT(value, last[value / emits_count]);
+    last[value / emits_count] = value;
+  }
+  EXPECT_LT(notified, static_cast<int>(total));
+  UninstallCallQueue();
+}
+
+TEST(SignalTest, DestroySignalAndReceiverConcurrently) {
+  // 信号析构从信号一侧断开，接收者析构从对象一侧断开，两边同时进行不能死锁
+  for (int i = 0; i < 200; ++i) {
+    auto signal = std::make_unique<Signal<void(int)>>();
+    auto receiver = std::make_unique<Receiver>();
+    for (int j = 0; j < 8; ++j) {
+      signal->connect(&Receiver::OnValue, receiver.get());
+    }
+    std::thread thread([&signal]() { signal.reset(); });
+    receiver.reset();
+    thread.join();
+  }
+}
+
+TEST(SignalTest, ConnectOnSeparateSignalsConcurrently) {
+  // 每个信号和对象有自己的锁，不同信号的连接、断开互不影响
+  const int threads_count = 4, rounds = 2000;
+  std::vector<std::thread> threads;
+  std::atomic<int> calls{0};
+  for (int i = 0; i < threads_count; ++i) {
+    threads.emplace_back([&calls, rounds]() {
+      Signal<void(int)> signal;
+      Receiver receiver;
+      for (int j = 0; j < rounds; ++j) {
+        auto con = signal.connect([&calls](int) { ++calls; });
+        signal.connect(&Receiver::OnValue, &receiver);
+        signal(j);
+        con.disconnect();
+        receiver.disconnect_all();
+      }
+      EXPECT_EQ(receiver.values.size(), size_t(rounds));
+      EXPECT_TRUE(signal.empty());
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(calls, threads_count * rounds);
+}
+
+class Counter : public Trackable {
+ public:
+  void OnValue(int) { ++count; }
+  std::atomic<int> count{0};
+};
+
+TEST(SignalTest, EmitWhileUninstalling) {
+  // 接收线程反复安装、卸载队列，卸载之后排入的调用改为在发出线程直接调用，
+  // 既不丢失也不泄漏
+  Signal<void(int)> signal;
+  Counter counter;
+  signal.connect(&Counter::OnValue, &counter);
+  const int emits_count = 20000;
+  std::atomic<bool> done{false};
+  std::atomic<int> notified{0};
+  InstallCallQueue(CountNotify, &notified);
+  std::thread thread([&signal, &done]() {
+    for (int i = 0; i < emits_count; ++i) {
+      signal(i);
+    }
+    done = true;
+  });
+  while (!done) {
+    DispatchQueuedCalls();
+    UninstallCallQueue();
+    InstallCallQueue(CountNotify, &notified);
+  }
+  thread.join();
+  UninstallCallQueue();
+  EXPECT_EQ(counter.count, emits_count);
+}
+
+#ifdef SIGNAL_QUEUE_TEST_HOOKS
+}  // namespace Test
+
+// Test only seam of queue.cpp,called before popping the last call
+namespace _SlotPriv {
+void _SetLastPopHook(void (*hook)());
+}  // namespace _SlotPriv
+
+namespace Test {
+Signal<void(int)> *push_while_popping = nullptr;
+
+void PushWhilePopping() {
+  _SlotPriv::_SetLastPopHook(nullptr);
+  std::thread([]() { (*push_while_popping)(2); }).join();
+}
+
+TEST(SignalTest, QueuedWhilePoppingLastCall) {
+  std::atomic<int> notified{0};
+  InstallCallQueue(CountNotify, &notified);
+  Signal<void(int)> signal;
+  Receiver receiver;
+  signal.connect(&Receiver::OnValue, &receiver);
+  std::thread([&signal]() { signal(1); }).join();
+  // 另一个线程恰好在取出最后一个调用、放回stub之前排队，新调用位于stub之前，
+  // 队列头是stub
+  push_while_popping = &signal;
+  _SlotPriv::_SetLastPopHook(PushWhilePopping);
+  EXPECT_EQ(DispatchQueuedCalls(), 1);
+  EXPECT_EQ(receiver.values, std::vector<int>{1});
+  EXPECT_EQ(notified, 2);
+  EXPECT_EQ(DispatchQueuedCalls(), 1);
+  EXPECT_EQ(receiver.values, (std::vector<int>{1, 2}));
+  EXPECT_EQ(DispatchQueuedCalls(), 0);
+  push_while_popping = nullptr;
+  UninstallCallQueue();
+}
+#endif
+}  // namespace Test
@@ -19,32 +19,66 @@ furnished to do so...
 
 #include "trackable.hpp"
 
+#include <algorithm>
+
+namespace {
+using LockGuard = std::lock_guard<std::recursive_mutex>;
+using UniqueLock = std::unique_lock<std::recursive_mutex>;
+}
+
 Trackable::Trackable() {}
 Trackable::~Trackable() {
-  if (_impl != nullptr) {
-    _impl->cleanup();
-    delete _impl;
+  Impl *impl = _impl.load();
+  if (impl != nullptr) {
+    impl->cleanup();
+    delete impl;
+  }
+}
+bool Trackable::Impl::call_functor(std::list<Functor>::iterator iter) {
+  std::recursive_mutex *signal_mutex = nullptr;
+  if (iter->magic == Functor::Signal) {
+    // The signal is alive while the connection is here,it has to lock us to
+    // remove it.But it may hold its lock and wait for ours,so never block
+    signal_mutex =
+        &static_cast<Connection *>(iter->user1)->signal()->Trackable::mutex();
+    if (!signal_mutex->try_lock()) {
+      return false;
+    }
   }
+  iter->_call();
+  functors_cb.erase(iter);
+  if (signal_mutex != nullptr) {
+    signal_mutex->unlock();
+  }
+  return true;
 }
 void Trackable::Impl::cleanup() {
-  // lock_guard<SpinLock> locker(spinlock);
   // cleanup all
-  for (auto i = functors_cb.begin(); i != functors_cb.end();) {
-    // Call the functor
-    i->_call();
-    i = functors_cb.erase(i);
+  while (true) {
+    UniqueLock locker(mutex);
+    if (functors_cb.empty()) {
+      return;
+    }
+    if (!call_functor(functors_cb.begin())) {
+      locker.unlock();
+      std::this_thread::yield();
+    }
   }
 }
 void Trackable::Impl::disconnect_all() {
-  // lock_guard<SpinLock> locker(spinlock);
-  // disconnect the timer
-  for (auto i = functors_cb.begin(); i != functors_cb.end();) {
-    // Call the functor
-    if (i->magic == Functor::Signal) {
-      i->_call();
-      i = functors_cb.erase(i);
-    } else {
-      ++i;
+  // disconnect the signals,keep the others
+  while (true) {
+    UniqueLock locker(mutex);
+    auto i = std::find_if(functors_cb.begin(), functors_cb.end(),
+                          [](const Functor &functor) {
+                            return functor.magic == Functor::Signal;
+                          });
+    if (i == functors_cb.end()) {
+      return;
+    }
+    if (!call_functor(i)) {
+      locker.unlock();
+      std::this_thread::yield();
     }
   }
 }
@@ -60,14 +94,17 @@ _FunctorLocation Trackable::Impl::add_callback(void (*fn)(void *),
     reinterpret_cast<void (*)(void *)>(self.user1)(self.user2);
   };
 
+  LockGuard locker(mutex);
   functors_cb.push_back(functor);
   return {--functors_cb.end()};
 }
 _FunctorLocation Trackable::Impl::add_functor(const Functor &functor) {
+  LockGuard locker(mutex);
   functors_cb.push_back(functor);
   return {--functors_cb.end()};
 }
 _FunctorLocation Trackable::Impl::remove_callback(FunctorLocation location) {
+  LockGuard locker(mutex);
   // Remove this callback
   if (location.iter != functors_cb.end()) {
     location->_cleanup();
@@ -76,15 +113,19 @@ _FunctorLocation Trackable::Impl::remove_callback(FunctorLocation location) {
   return {--functors_cb.end()};
 }
 _FunctorLocation Trackable::Impl::exec_functor(FunctorLocation location) {
-  // Remove this callback
-  if (location.iter != functors_cb.end()) {
-    location->_call();
-    functors_cb.erase(location.iter);
+  while (true) {
+    UniqueLock locker(mutex);
+    // Remove this callback
+    if (location.iter == functors_cb.end() || call_functor(location.iter)) {
+      return {--functors_cb.end()};
+    }
+    locker.unlock();
+    std::this_thread::yield();
   }
-  return {--functors_cb.end()};
 }
 _FunctorLocation Trackable::Impl::remove_callback_safe(
     FunctorLocation location) {
+  LockGuard locker(mutex);
   // Remove this callback after do check
   // Check is vaild location
   for (auto iter = functors_cb.begin(); iter != functors_cb.end(); ++iter) {
@@ -99,26 +140,86 @@ _FunctorLocation Trackable::Impl::remove_callback_safe(
 SignalBase::SignalBase() {}
 SignalBase::~SignalBase() { disconnect_all(); }
 void SignalBase::disconnect_all() {
-  auto iter = _slots.begin();
-  while (iter != _slots.end()) {
-    (*iter)->cleanup();
-    iter = _slots.erase(iter);
+  LockGuard locker(mutex());
+  while (!_slots.empty()) {
+    remove_slot(_slots.begin(), false);
+  }
+}
+void SignalBase::remove_slot(Iterator iter, bool from_object) {
+  LockGuard locker(mutex());
+  _SlotBase *slot = *iter;
+  // The object is destroying and locked by the caller,don't touch it.Otherwise
+  // it is alive until it removes the slot under our lock,and it backs off if
+  // it holds its lock and wants ours,so blocking on it is fine
+  Trackable *object = from_object ? nullptr : slot->object;
+  if (object != nullptr) {
+    object->Trackable::mutex().lock();
+  }
+  // The slot may be running in other threads or the callback now
+  slot->removed = true;
+  _slots.erase(iter);
+  if (!from_object) {
+    slot->detach();
   }
+  if (object != nullptr) {
+    object->Trackable::mutex().unlock();
+  }
+  _retired_slots.push_back(slot);
+  publish_slots();
+}
+void SignalBase::publish_slots() {
+  const SlotArray *slots = nullptr;
+  if (!_slots.empty()) {
+    slots = new SlotArray(_slots.begin(), _slots.end());
+  }
+  const SlotArray *old = _snapshot.exchange(slots);
+  if (old != nullptr) {
+    _retired_snapshots.push_back(old);
+  }
+  // Pairs with EmitGuard,either we see no emission or the last emission sees
+  // the flag and sweeps
+  _has_retired = true;
+  if (_emitting == 0) {
+    sweep_slots();
+  }
+}
+void SignalBase::sweep_slots() {
+  LockGuard locker(mutex());
+  // The emissions started after the check only see the current snapshot
+  if (_emitting > 0) {
+    return;
+  }
+  _has_retired = false;
+  for (auto slot : _retired_slots) {
+    slot->unref();
+  }
+  for (auto slots : _retired_snapshots) {
+    delete slots;
+  }
+  _retired_slots.clear();
+  _retired_snapshots.clear();
 }
 void Connection::disconnect(bool from_object) {
   if (status == WithSignal) {
-    (*sig.iter)->cleanup(from_object);
-    sig.current->_slots.erase(sig.iter);
+    sig.current->remove_slot(sig.iter, from_object);
   } else if (status == WithObject) {
     obj.object->exec_functor(obj.loc);
   }
   status = None;
 }
 auto Trackable::impl() const -> Impl & {
-  if (_impl == nullptr) {
-    _impl = new Impl;
+  Impl *impl = _impl.load(std::memory_order_acquire);
+  if (impl == nullptr) {
+    // Racing threads create their own,the losers delete theirs
+    Impl *created = new Impl;
+    if (_impl.compare_exchange_strong(impl, created,
+                                      std::memory_order_acq_rel)) {
+      impl = created;
+    } else {
+      delete created;
+    }
   }
-  return *_impl;
+  return *impl;
 }
 // Remove the
 _ConnectionFunctor::_ConnectionFunctor(Connection con) {
@@ -139,7 +240,9 @@ _ConnectionFunctor::_ConnectionFunctor(Connection con) {
 }
 _GenericCallFunctor::_GenericCallFunctor(_GenericCallBase *base) {
   call = [](_Functor &self) {
-    static_cast<_GenericCallBase *>(self.user1)->deleted = true;
+    auto *base = static_cast<_GenericCallBase *>(self.user1);
+    std::lock_guard<std::mutex> locker(base->mutex);
+    base->deleted = true;
   };
   cleanup = nullptr;
   user1 = base;
@@ -1,4 +1,13 @@
 target("signal")
   set_kind("static")
   set_languages("c++17")
-  add_files("*.cpp")
\ No newline at end of file
+  add_files("*.cpp")
+
+target("signalTest")
+  set_kind("binary")
+  set_languages("c++17")
+  add_packages("gtest")
+  add_defines("SIGNAL_QUEUE_TEST_HOOKS")
+  add_files("*.cpp")
+  add_files("test/signalTest.cpp")
+  add_files("../gtest/testMain.cpp")
\ No newline at end of file
@@ -3,6 +3,7 @@
 #include <QDebug>
 #include <QDrag>
 #include <QFileDialog>
+#include <QImageReader>
 #include <QMimeData>
 #include <QWhatsThis>
 #include <algorithm>
@@ -10,65 +11,150 @@
 #include <vector>
 
 namespace ImageStitch {
+ImageItemModel::ImageLoader ImageItemModel::_image_loader = nullptr;
+
 ImageItemModel::ImageItemModel(QObject *parent) : QAbstractItemModel(parent) {
-  _rows = 0;
+  _thumbnails.setMaxCost(kThumbnailCacheLimit);
+}
+void ImageItemModel::setImageLoader(ImageLoader loader) {
+  _image_loader = loader;
+}
+ImageItemModel::~ImageItemModel() {
+  // 后台任务完成时会回调模型，析构前必须等待
+  _thumbnail_pool.clear();
+  _thumbnail_pool.waitForDone();
 }
-ImageItemModel::~ImageItemModel() {}
 QVariant ImageItemModel::data(const QModelIndex &_index, int role) const {
   if (!_index.isValid() || _index.row() < 0 || _index.column() != 0 ||
-      _index.row() >= _rows) {
+      _index.row() >= rowCount()) {
     return QVariant();
   }
   switch (role) {
     case Qt::DecorationRole:
-      return QIcon(
-          _datas.at(_index.row())[(int)Qt::DecorationRole].value<QPixmap>());
+      return thumbnail(_index.row());
     case Qt::DisplayRole:
-      return QString(
-          QFileInfo(
-              _datas.at(_index.row())[(int)Qt::DisplayRole].value<QString>())
-              .baseName());
+      return QString(QFileInfo(_items.at(_index.row()).file_path).baseName());
     case Qt::ToolTipRole:
-      return _datas.at(_index.row())[(int)Qt::DisplayRole].value<QString>();
+      return _items.at(_index.row()).file_path;
+    case kImageRole:
+      return image(_index.row());
   }
   return QVariant();
 }
 
+QVariant ImageItemModel::thumbnail(const int row) const {
+  const auto &item = _items.at(row);
+  if (!item.thumbnail.isNull() || item.file_path.isEmpty()) {
+    return QIcon(item.thumbnail);
+  }
+  if (auto pixmap = _thumbnails.object(item.file_path); pixmap != nullptr) {
+    return QIcon(*pixmap);
+  }
+  requestThumbnail(item.file_path);
+  return QVariant();
+}
+
+void ImageItemModel::requestThumbnail(const QString &file) const {
+  if (_pending_thumbnails.contains(file)) {
+    return;
+  }
+  _pending_thumbnails.insert(file);
+  auto model = const_cast<ImageItemModel *>(this);
+  _thumbnail_pool.start([model, file]() {
+    // 按缩略图尺寸解码，JPEG可以直接在DCT域缩小，不必解码原图
+    QImageReader reader(file);
+    reader.setAutoTransform(true);
+    const QSize size = reader.size();
+    if (size.isValid()) {
+      reader.setScaledSize(size.scaled(kThumbnailWidth, kThumbnailHeight,
+                                       Qt::KeepAspectRatio));
+    }
+    QImage thumbnail = reader.read();
+    if (thumbnail.isNull()) {
+      qWarning() << "Couldn't load thumbnail : " << file << " "
+                 << reader.errorString();
+    }
+    // QPixmap只能在界面线程创建
+    QMetaObject::invokeMethod(
+        model, [model, file, thumbnail]() {
+          model->thumbnailLoaded(file, thumbnail);
+        },
+        Qt::QueuedConnection);
+  });
+}
+
+void ImageItemModel::thumbnailLoaded(const QString &file,
+                                     const QImage &thumbnail) {
+  _pending_thumbnails.remove(file);
+  // 加载失败时也缓存空图，避免反复重试
+  auto pixmap = new QPixmap(QPixmap::fromImage(thumbnail));
+  _thumbnails.insert(
+      file, pixmap,
+      std::max(1, pixmap->width() * pixmap->height() * pixmap->depth() / 8 /
+                      1024));
+  // 只通知使用该文件的行，同一文件可能被添加多次
+  for (int row = 0; row < _items.size(); ++row) {
+    if (_items.at(row).file_path == file) {
+      emit dataChanged(index(row, 0), index(row, 0), {Qt::DecorationRole});
+    }
+  }
+}
+
+QImage ImageItemModel::scaledThumbnail(const QImage &image) {
+  if (image.isNull()) {
+    return image;
+  }
+  return image.scaled(kThumbnailWidth, kThumbnailHeight, Qt::KeepAspectRatio,
+                      Qt::SmoothTransformation);
+}
+
+QImage ImageItemModel::image(const int row) const {
+  if (row < 0 || row >= rowCount()) {
+    return QImage();
+  }
+  const auto &item = _items.at(row);
+  if (!item.image.isNull() || item.file_path.isEmpty()) {
+    return item.image;
+  }
+  return _image_loader ? _image_loader(item.file_path)
+                       : QImage(item.file_path);
+}
+
 int ImageItemModel::columnCount(const QModelIndex &parent) const { return 1; }
 
-int ImageItemModel::rowCount(const QModelIndex &parent) const { return _rows; }
+int ImageItemModel::rowCount(const QModelIndex &parent) const {
+  return _items.size();
+}
 
 QModelIndex ImageItemModel::index(int row, int column,
                                   const QModelIndex &parent) const {
   if (row < 0 || row >= rowCount() || column != 0) {
     return QModelIndex();
   }
-  return createIndex(row, 0, (void *)&_datas[row]);
+  return createIndex(row, 0);
 }
 QModelIndex ImageItemModel::parent(const QModelIndex &child) const {
   return QModelIndex();
 }
-QList<QPair<QString, QPixmap>> ImageItemModel::getItems(const int row,
-                                                        const int column) {
-  QList<QPair<QString, QPixmap>> items;
+QList<QPair<QString, QImage>> ImageItemModel::getItems(const int row,
+                                                       const int column) {
+  QList<QPair<QString, QImage>> items;
   if (row < 0 || row + column > rowCount() || column < 1) {
     return items;
   }
-  auto it = _datas.begin() + row;
-  for (int i = 0; i < column; ++i, ++it) {
-    items.append(QPair((*it)[Qt::DisplayRole].value<QString>(),
-                       (*it)[Qt::DecorationRole].value<QPixmap>()));
+  for (int i = row; i < row + column; ++i) {
+    items.append(QPair(_items[i].file_path, _items[i].image));
   }
   return items;
 }
 bool ImageItemModel::insertRows(const int row,
-                                const QList<QPair<QString, QPixmap>> &datas) {
+                                const QList<QPair<QString, QImage>> &datas) {
   int count = datas.size();
   if (!insertRows(row, count)) {
     return false;
   }
   for (int i = 0; i < count; ++i) {
-    setItem(i + row, QPair(datas[i].first, datas[i].second));
+    setItem(i + row, datas[i]);
   }
   return true;
 }
@@ -77,17 +163,20 @@ bool ImageItemModel::setData(const QModelIndex &_index, const QVariant &value,
   if (_index.column() != 0 || _index.row() < 0 || _index.row() >= rowCount()) {
     return false;
   }
-  QModelIndex idx;
+  auto &item = _items[_index.row()];
   switch (role) {
     case Qt::DecorationRole:
-      _datas[_index.row()][Qt::DecorationRole] = value;
-      idx = createIndex(_index.row(), 0, (void *)&_datas[_index.row()]);
-      emit dataChanged(idx, idx, {role});
+      if (value.canConvert<QImage>()) {
+        item.image = value.value<QImage>();
+      } else {
+        item.image = value.value<QPixmap>().toImage();
+      }
+      item.thumbnail = QPixmap::fromImage(scaledThumbnail(item.image));
+      emit dataChanged(_index, _index, {role});
       return true;
     case Qt::DisplayRole:
-      _datas[_index.row()][Qt::DisplayRole] = value;
-      idx = createIndex(_index.row(), 0, (void *)&_datas[_index.row()]);
-      emit dataChanged(idx, idx, {role});
+      item.file_path = value.value<QString>();
+      emit dataChanged(_index, _index, {role});
       return true;
   }
   return false;
@@ -118,21 +207,8 @@ bool ImageItemModel::insertRows(int row, int count, const QModelIndex &parent) {
     return false;
   }
   beginInsertRows(parent, row, row + count - 1);
-  if (_rows == 0) {
-    int i = 0;
-    while (i < count) {
-      _datas.push_back(QMap<int, QVariant>());
-      ++i;
-    }
-    _rows = count;
-  } else {
-    auto it = _datas.begin() + row;
-    int i = 0;
-    while (i < count) {
-      it = _datas.insert(it, QMap<int, QVariant>());
-      ++i;
-    }
-    _rows += count;
+  for (int i = 0; i < count; ++i) {
+    _items.insert(row, ImageItem());
   }
   endInsertRows();
   return true;
@@ -144,13 +220,7 @@ bool ImageItemModel::removeRows(int row, int count, const QModelIndex &parent) {
     return false;
   }
   beginRemoveRows(parent, row, row + count - 1);
-  auto it = _datas.begin() + row;
-  int i = 0;
-  while (i < count) {
-    it = _datas.erase(it);
-    ++i;
-  }
-  _rows -= count;
+  _items.erase(_items.begin() + row, _items.begin() + row + count);
   endRemoveRows();
   return true;
 }
@@ -165,10 +235,12 @@ Qt::ItemFlags ImageItemModel::flags(const QModelIndex &index) const {
   }
 }
 QMap<int, QVariant> ImageItemModel::index2Item(const QModelIndex &index) const {
+  QMap<int, QVariant> item;
   if (index.isValid() && index.row() < rowCount()) {
-    return _datas[index.row()];
+    item[Qt::DisplayRole] = _items[index.row()].file_path;
+    item[Qt::DecorationRole] = _items[index.row()].image;
   }
-  return QMap<int, QVariant>();
+  return item;
 }
 QMimeData *ImageItemModel::mimeData(const QModelIndexList &indexes) const {
   QMimeData *data = new QMimeData;
@@ -180,9 +252,12 @@ QMimeData *ImageItemModel::mimeData(const QModelIndexList &indexes) const {
     return data;
   } else {
     qDebug() << "mimeData";
-    auto item = index2Item(indexes.at(0));
-    data->setText(item[Qt::DisplayRole].value<QString>());
-    data->setImageData(item[Qt::DecorationRole].value<QPixmap>());
+    const auto &item = _items.at(indexes.at(0).row());
+    data->setText(item.file_path);
+    // 来自文件的项只传路径，由接收方按需加载
+    if (!item.image.isNull()) {
+      data->setImageData(item.image);
+    }
     return data;
   }
 }
@@ -192,33 +267,47 @@ bool ImageItemModel::addItem(const QString &file) {
     qWarning() << "File " << file << " does not exist";
     return false;
   }
-  return addItem(QImage(file), file);
+  return insertRow(rowCount()) &&
+         setData(index(rowCount() - 1, 0), file, Qt::DisplayRole);
+}
+bool ImageItemModel::addItems(const QStringList &files) {
+  QStringList exist_files;
+  for (const auto &file : files) {
+    if (QFileInfo(file).isFile()) {
+      exist_files.append(file);
+    } else {
+      qWarning() << "File " << file << " does not exist";
+    }
+  }
+  if (exist_files.isEmpty()) {
+    return false;
+  }
+  const int row = rowCount();
+  beginInsertRows(QModelIndex(), row, row + exist_files.size() - 1);
+  for (const auto &file : exist_files) {
+    _items.append(ImageItem{file, QImage(), QPixmap()});
+  }
+  endInsertRows();
+  return true;
 }
 bool ImageItemModel::addItem(const QImage &img, const QString &file_path) {
-  return addItem(QPixmap::fromImage(img), file_path);
+  return insertRow(rowCount()) &&
+         setItem(rowCount() - 1, QPair(file_path, img));
 }
 bool ImageItemModel::addItem(const QPixmap &pixmap, const QString &file_path) {
-  return insertRow(rowCount()) &&
-         setItem(rowCount() - 1, QPair(file_path, pixmap));
+  return addItem(pixmap.toImage(), file_path);
 }
 bool ImageItemModel::setItem(const int row,
-                             const QPair<QString, QPixmap> &data) {
+                             const QPair<QString, QImage> &data) {
   return setData(index(row, 0, QModelIndex()), data.first, Qt::DisplayRole) &&
          setData(index(row, 0, QModelIndex()), data.second, Qt::DecorationRole);
 }
 
 bool ImageItemModel::removeItem(const int _index) { return removeRow(_index); }
-QList<QPixmap> ImageItemModel::pixmapList() {
-  QList<QPixmap> pixmapList;
-  for (auto &data : _datas) {
-    pixmapList.append(data[Qt::DecorationRole].value<QPixmap>());
-  }
-  return pixmapList;
-}
 QList<QString> ImageItemModel::fileList() {
   QList<QString> fileList;
-  for (auto &data : _datas) {
-    fileList.append(data[Qt::DisplayRole].value<QString>());
+  for (const auto &item : _items) {
+    fileList.append(item.file_path);
   }
   return fileList;
 }
@@ -232,6 +321,8 @@ void ImageBox::setupUi(const int width, const int height) {
   resize(width, height);
   setViewMode(QListView::ListMode);
   setIconSize(QSize(kDefaultIconWidth, kDefaultIconHeight));
+  // 所有项同样大小，视图不必逐项计算布局
+  setUniformItemSizes(true);
   setLayoutDirection(Qt::LayoutDirectionAuto);
   setContextMenuPolicy(Qt::CustomContextMenu);
   setDragDropMode(QListView::DragDropMode::DropOnly);
@@ -265,12 +356,17 @@ void ImageBox::dropEvent(QDropEvent *event) {
   if (event->mimeData()->hasImage()) {
     qDebug() << "ImageBox::dropEvent image";
     auto imageItemModel = dynamic_cast<ImageItemModel *>(model());
-    const QPixmap pixmap = event->mimeData()->imageData().value<QPixmap>();
     QString text = "";
     if (event->mimeData()->hasText()) {
       text = event->mimeData()->text();
     }
-    imageItemModel->addItem(pixmap, text);
+    // 能找到原文件时只记录路径，不在模型中保存整张图像
+    if (QFileInfo(text).isFile()) {
+      imageItemModel->addItem(text);
+    } else {
+      imageItemModel->addItem(
+          event->mimeData()->imageData().value<QImage>(), text);
+    }
     if (index > -1) {
       imageItemModel->moveRow(QModelIndex(), imageItemModel->rowCount() - 1,
                               QModelIndex(), index);
@@ -310,15 +406,14 @@ void ImageBox::dropEvent(QDropEvent *event) {
 }
 
 void ImageBox::handleDoubleClick(const QModelIndex &_index) {
-  auto data = dynamic_cast<ImageItemModel *>(model())->index2Item(_index);
-  auto pixmap = data[Qt::DecorationRole];
+  // 列表中只有缩略图，查看时才加载原图
+  auto image = model()->data(_index, ImageItemModel::kImageRole);
   CustomizeTitleWidget *widget = new CustomizeTitleWidget();
   connect(this, &CustomizeTitleWidget::destroyed, widget,
           [widget](QObject *) { widget->close(); });
-  ImageView *imageView = new ImageView(pixmap.value<QPixmap>());
+  ImageView *imageView = new ImageView(image.value<QImage>());
   widget->setCentralWidget(imageView);
-  widget->setWindowTitle(
-      QFileInfo(data[Qt::DisplayRole].value<QString>()).baseName());
+  widget->setWindowTitle(model()->data(_index, Qt::DisplayRole).toString());
   widget->setAttribute(Qt::WA_DeleteOnClose, true);
   QToolButton *on_top = new QToolButton();
   widget->addWidget(on_top, 4);
@@ -363,13 +458,13 @@ void ImageBox::handleCustomContextMenu(const QPoint &pos) {
     QAction *save = _menu->addAction(tr("另存为"));
     connect(save, &QAction::triggered, this, [this, &index]() {
       auto file_path = model()->data(index, Qt::DisplayRole);
-      auto pixmap = model()->data(index, Qt::DecorationRole);
+      auto image = model()->data(index, ImageItemModel::kImageRole);
       QString fileName = QFileDialog::getSaveFileName(
           this,
           tr("另存文件"),               // dialog title
           file_path.value<QString>(),   // default directory
           tr("Images (*.png *.jpg)"));  // filter files by extension
-      pixmap.value<QPixmap>().save(fileName);
+      image.value<QImage>().save(fileName);
     });
     // 唤出菜单
     _menu->exec(mapToGlobal(pos));
@@ -389,9 +484,7 @@ void ImageBox::handleImageAdd() {
       "Images (*.png *.jpg *.jpeg);;All File (*.*)");  // filter files by
                                                        // extension
   auto imageItemModel = dynamic_cast<ImageItemModel *>(model());
-  for (const auto &file : fileNames) {
-    imageItemModel->addItem(file);
-  }
+  imageItemModel->addItems(fileNames);
 }
 
 }  // namespace ImageStitch
\ No newline at end of file
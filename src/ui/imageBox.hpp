@@ -1,18 +1,40 @@
 #pragma once
 
+#include <QCache>
 #include <QListView>
 #include <QMap>
 #include <QMenu>
 #include <QPixmap>
+#include <QSet>
+#include <QThreadPool>
 #include <QWidget>
+#include <functional>
 
 #include "imageView.hpp"
 
 namespace ImageStitch {
 
 class ImageItemModel : public QAbstractItemModel {
+ public:
+  using ImageLoader = std::function<QImage(const QString &)>;
+  /**
+   * @brief 取原图的数据角色，图像按需加载，不在模型中常驻
+   */
+  static constexpr int kImageRole = Qt::UserRole;
+  static constexpr int kThumbnailWidth = 100;
+  static constexpr int kThumbnailHeight = 100;
+  /**
+   * @brief 缩略图缓存上限(KB)
+   */
+  static constexpr int kThumbnailCacheLimit = 64 * 1024;
+
  public:
   ImageItemModel(QObject *parent = (QObject *)nullptr);
+  /**
+   * @brief 设置从文件加载图像的方式，默认直接用QImage解码。
+   * 程序中设置为从进程共享的解码缓存取图，避免拼接时重复解码。
+   */
+  static void setImageLoader(ImageLoader loader);
   ~ImageItemModel();
   QVariant data(const QModelIndex &_index,
                 int role = Qt::DecorationRole) const override;
@@ -32,21 +54,48 @@ class ImageItemModel : public QAbstractItemModel {
                   const QModelIndex &parent = QModelIndex()) override;
   Qt::ItemFlags flags(const QModelIndex &index) const override;
   QMimeData *mimeData(const QModelIndexList &indexes) const override;
-  QList<QPair<QString, QPixmap>> getItems(const int row, const int column);
-  bool insertRows(const int row, const QList<QPair<QString, QPixmap>> &datas);
+  /**
+   * @brief 取出文件路径和内存中的图像，来自文件的项图像为空
+   */
+  QList<QPair<QString, QImage>> getItems(const int row, const int column);
+  bool insertRows(const int row, const QList<QPair<QString, QImage>> &datas);
   QMap<int, QVariant> index2Item(const QModelIndex &index) const;
+  /**
+   * @brief 只记录文件路径，缩略图在首次显示时由后台线程生成
+   */
   bool addItem(const QString &file);
+  /**
+   * @brief 批量添加文件，只触发一次行插入
+   */
+  bool addItems(const QStringList &files);
   bool addItem(const QImage &img, const QString &file_path = "");
   bool addItem(const QPixmap &pixmap, const QString &file_path = "");
-  bool setItem(const int row, const QPair<QString, QPixmap> &data);
+  bool setItem(const int row, const QPair<QString, QImage> &data);
   bool removeItem(const int _index);
-  QList<QPixmap> pixmapList();
+  /**
+   * @brief 加载第row项的原图
+   */
+  QImage image(const int row) const;
   QList<QString> fileList();
 
  private:
-  QList<QMap<int, QVariant>> _datas;
-  int _hide_index;
-  int _rows;
+  struct ImageItem {
+    QString file_path;
+    // 没有对应文件(如拖入的图像数据)时才在内存中保存原图
+    QImage image;
+    QPixmap thumbnail;
+  };
+  QVariant thumbnail(const int row) const;
+  void requestThumbnail(const QString &file) const;
+  void thumbnailLoaded(const QString &file, const QImage &thumbnail);
+  static QImage scaledThumbnail(const QImage &image);
+
+ private:
+  QList<ImageItem> _items;
+  mutable QCache<QString, QPixmap> _thumbnails;
+  mutable QSet<QString> _pending_thumbnails;
+  mutable QThreadPool _thumbnail_pool;
+  static ImageLoader _image_loader;
 };
 class ImageBox : public QListView {
   Q_OBJECT
@@ -4,13 +4,13 @@
 
 #include <QFileDialog>
 #include <QMenu>
+#include <QPaintEvent>
+#include <algorithm>
 #include <cmath>
 
 namespace ImageStitch {
 ImageView::ImageView(QWidget *parent) : QWidget(parent) {
   setupUi(kDefaultWindowWidth, kDefaultWindowHeight);
-  _pixmap = QPixmap();
-  _pixmap.fill(Qt::transparent);
 }
 
 ImageView::ImageView(const QImage &image, QWidget *parent) : QWidget(parent) {
@@ -29,6 +29,8 @@ void ImageView::setupUi(int iWidth, int iHeight) {
   _iYOffset = 0;
   _iScale = 1.0;
   _mouseLeftPressed = false;
+  _tiles.setMaxCost(kTileCacheLimit);
+  _pyramid_pool.setMaxThreadCount(1);
   _textLabel = new QLabel(this);
   _textLabel->setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Expanding);
   _textLabel->setAlignment(Qt::AlignCenter);
@@ -37,50 +39,48 @@ void ImageView::setupUi(int iWidth, int iHeight) {
                    &ImageView::Menu);
 }
 ImageView::~ImageView() {
-  // TODO(llhsdmd): to do
+  // 后台生成任务会回调视图，析构前让其尽快退出并等待
+  ++_pyramid_generation;
+  _pyramid_pool.clear();
+  _pyramid_pool.waitForDone();
 }
 void ImageView::Menu(const QPoint &pos) {
   QMenu menu;
-  if (!_pixmap.isNull()) {
+  if (!_image.isNull()) {
     menu.addAction(tr("顺时针旋转90°"), [this]() {
-      QMatrix leftmatrix;
+      QTransform leftmatrix;
       leftmatrix.rotate(90);
-      QPixmap pix =
-          GetPixmap().transformed(leftmatrix, Qt::SmoothTransformation);
-      SetPixmap(pix);
+      SetImage(GetImage().transformed(leftmatrix, Qt::SmoothTransformation));
     });
     menu.addAction(tr("逆时针旋转90°"), [this]() {
-      QMatrix leftmatrix;
+      QTransform leftmatrix;
       leftmatrix.rotate(270);
-      QPixmap pix =
-          GetPixmap().transformed(leftmatrix, Qt::SmoothTransformation);
-      SetPixmap(pix);
-    });
-    menu.addAction(tr("水平翻转"), [this]() {
-      SetPixmap(
-          QPixmap::fromImage(GetPixmap().toImage().mirrored(true, false)));
-    });
-    menu.addAction(tr("竖直翻转"), [this]() {
-      SetPixmap(
-          QPixmap::fromImage(GetPixmap().toImage().mirrored(false, true)));
+      SetImage(GetImage().transformed(leftmatrix, Qt::SmoothTransformation));
     });
+    menu.addAction(tr("水平翻转"),
+                   [this]() { SetImage(GetImage().mirrored(true, false)); });
+    menu.addAction(tr("竖直翻转"),
+                   [this]() { SetImage(GetImage().mirrored(false, true)); });
     menu.addSeparator();
     menu.addAction(tr("保存图像"), [this]() {
       QString fileName = QFileDialog::getSaveFileName(
           this, tr("保存图像"), tr("未命名"), tr("Images (*.png *.jpg)"));
       if (!fileName.isEmpty()) {
-        _pixmap.save(fileName);
+        _image.save(fileName);
       }
     });
     menu.exec(mapToGlobal(pos));
   }
 }
 void ImageView::AutoScale() {
-  float scale_x = (float)width() / (float)_pixmap.width();
-  float scale_y = (float)height() / (float)_pixmap.height();
+  if (_image.isNull()) {
+    return;
+  }
+  float scale_x = (float)width() / (float)_image.width();
+  float scale_y = (float)height() / (float)_image.height();
   float scale = scale_x < scale_y ? scale_x : scale_y;
-  SetOffset((width() - _pixmap.width() * scale) / 2,
-            (height() - _pixmap.height() * scale) / 2);
+  SetOffset((width() - _image.width() * scale) / 2,
+            (height() - _image.height() * scale) / 2);
   SetScale(scale);
 }
 void ImageView::ShowMessage(const QString &message) {
@@ -90,23 +90,106 @@ void ImageView::ShowMessage(const QString &message) {
 }
 
 void ImageView::SetImage(const QImage &image) {
-  _pixmap = QPixmap::fromImage(image);
+  _image = image;
+  buildPyramid();
   if (!image.isNull()) {
     AutoScale();
     _textLabel->setVisible(false);
   } else {
     _textLabel->setVisible(true);
   }
+  update();
 }
 
-void ImageView::SetPixmap(const QPixmap &pixmap) {
-  _pixmap = pixmap;
-  if (!pixmap.isNull()) {
-    AutoScale();
-    _textLabel->setVisible(false);
+void ImageView::SetPixmap(const QPixmap &pixmap) { SetImage(pixmap.toImage()); }
+
+void ImageView::UpdateImage(const QImage &image) {
+  if (image.isNull() || image.size() != _image.size()) {
+    SetImage(image);
+    return;
+  }
+  _image = image;
+  buildPyramid();
+  update();
+}
+
+void ImageView::buildPyramid() {
+  const int generation = ++_pyramid_generation;
+  _pyramid_pool.clear();
+  _tiles.clear();
+  _levels.clear();
+  if (_image.isNull()) {
+    return;
+  }
+  // 第0层就是原图，瓦片直接引用其像素，立即可用
+  _levels.push_back(_image);
+  if ((std::max)(_image.width(), _image.height()) <= kTileSize) {
+    return;
+  }
+  QImage image = _image;
+  _pyramid_pool.start([this, generation, image]() {
+    QImage level = image;
+    for (int i = 1; (std::max)(level.width(), level.height()) > kTileSize;
+         ++i) {
+      if (generation != _pyramid_generation) {
+        return;
+      }
+      level = level.scaled((std::max)(1, level.width() / 2),
+                           (std::max)(1, level.height() / 2),
+                           Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+      QMetaObject::invokeMethod(
+          this, [this, generation, i, level]() {
+            levelBuilt(generation, i, level);
+          },
+          Qt::QueuedConnection);
+    }
+  });
+}
+
+void ImageView::levelBuilt(int generation, int level, const QImage &image) {
+  // 图像已经更换，丢弃旧图的层
+  if (generation != _pyramid_generation ||
+      level != static_cast<int>(_levels.size())) {
+    return;
+  }
+  _levels.push_back(image);
+  if (pyramidLevel() == level) {
+    update();
+  }
+}
+
+int ImageView::pyramidLevel() const {
+  if (_levels.empty()) {
+    return -1;
+  }
+  // 选择分辨率不低于显示分辨率的最粗层，绘制时最多缩小一半
+  int level = _iScale >= 1 ? 0 : (int)std::floor(std::log2(1.0 / _iScale));
+  return std::clamp(level, 0, static_cast<int>(_levels.size()) - 1);
+}
+
+QPixmap ImageView::tile(int level, int x, int y) {
+  const quint64 key =
+      (quint64(level) << 48) | (quint64(y) << 24) | quint64(x);
+  if (auto pixmap = _tiles.object(key); pixmap != nullptr) {
+    return *pixmap;
+  }
+  const QImage &image = _levels[level];
+  QRect rect = QRect(x * kTileSize, y * kTileSize, kTileSize, kTileSize)
+                   .intersected(image.rect());
+  QImage tile_image;
+  if (image.depth() % 8 == 0 && image.colorCount() == 0) {
+    // 不复制层数据，只在转换为QPixmap时拷贝一块瓦片
+    tile_image = QImage(image.constScanLine(rect.y()) +
+                            rect.x() * image.depth() / 8,
+                        rect.width(), rect.height(), image.bytesPerLine(),
+                        image.format());
   } else {
-    _textLabel->setVisible(true);
+    tile_image = image.copy(rect);
   }
+  auto pixmap = new QPixmap(QPixmap::fromImage(tile_image));
+  _tiles.insert(key, pixmap,
+                (std::max)(1, rect.width() * rect.height() * 4 / 1024));
+  return *pixmap;
 }
 
 // Member Funcitons
@@ -169,18 +252,42 @@ void ImageView::resizeEvent(QResizeEvent *event) {
 
 void ImageView::paintEvent(QPaintEvent *event) {
   QPainter painter(this);
-  QPoint start{-_iXOffset, -_iYOffset};
-  QPoint size{this->width(), this->height()};
-  int left = 0, up = 0;
-  if (start.x() < 0) {
-    left = -start.x();
-  }
-  if (start.y() < 0) {
-    up = -start.y();
-  }
-  QRect target{left, up, (size.x() - left), (size.y() - up)};
-  QRect source{(start + QPoint{left, up}) / _iScale, (size + start) / _iScale};
-  painter.drawPixmap(target, _pixmap, source);
+  const int level = pyramidLevel();
+  if (level >= 0) {
+    const QImage &image = _levels[level];
+    // 层像素到窗口坐标的缩放
+    const double level_scale = (double)_image.width() / image.width();
+    const double scale = _iScale * level_scale;
+    // 放大时保持像素清晰，缩小时平滑
+    painter.setRenderHint(QPainter::SmoothPixmapTransform, scale < 1);
+    // 只绘制与可见区域相交的瓦片
+    const QRectF visible =
+        QRectF(event->rect())
+            .translated(-_iXOffset, -_iYOffset)
+            .intersected(QRectF(0, 0, image.width() * scale,
+                                image.height() * scale));
+    if (!visible.isEmpty()) {
+      const int tile_x0 = (int)(visible.left() / scale) / kTileSize;
+      const int tile_y0 = (int)(visible.top() / scale) / kTileSize;
+      const int tile_x1 = (int)std::ceil(visible.right() / scale) / kTileSize;
+      const int tile_y1 =
+          (int)std::ceil(visible.bottom() / scale) / kTileSize;
+      for (int y = tile_y0; y <= tile_y1; ++y) {
+        for (int x = tile_x0; x <= tile_x1; ++x) {
+          QRect rect = QRect(x * kTileSize, y * kTileSize, kTileSize, kTileSize)
+                           .intersected(image.rect());
+          if (rect.isEmpty()) {
+            continue;
+          }
+          QRectF target(_iXOffset + rect.x() * scale,
+                        _iYOffset + rect.y() * scale, rect.width() * scale,
+                        rect.height() * scale);
+          painter.drawPixmap(target, tile(level, x, y),
+                             QRectF(0, 0, rect.width(), rect.height()));
+        }
+      }
+    }
+  }
   // painter.setPen(QColor("blue"));
   // painter.drawRect(0, 0, size.x() - 1, size.y() - 1);
   QWidget::paintEvent(event);
@@ -190,11 +297,11 @@ void ImageView::wheelEvent(QWheelEvent *event) {
   float delta = ((float)event->y() / event->delta());
   // 基础缩放系数1.05，缩放次数为滚动量。
   float scale_coeff = powf(1.05, delta);
-  if (_iScale * scale_coeff * _pixmap.width() >= kMaxImageWidth ||
-      _iScale * scale_coeff * _pixmap.height() >= kMaxImageHeight) {
-    scale_coeff = (kMaxImageWidth / _pixmap.width()) / _iScale;
+  if (_iScale * scale_coeff * _image.width() >= kMaxImageWidth ||
+      _iScale * scale_coeff * _image.height() >= kMaxImageHeight) {
+    scale_coeff = (kMaxImageWidth / _image.width()) / _iScale;
     scale_coeff =
-        (std::min)(scale_coeff, (kMaxImageHeight / _pixmap.height()) / _iScale);
+        (std::min)(scale_coeff, (kMaxImageHeight / _image.height()) / _iScale);
   }
   // 计算鼠标所在点变换后的偏移量
   QPoint pos = event->pos();
@@ -203,6 +310,6 @@ void ImageView::wheelEvent(QWheelEvent *event) {
   SetOffset(pos.x() - origin_offset.x(), pos.y() - origin_offset.y());
   Scale(scale_coeff);
 }
-QSize ImageView::sizeHint() const { return _pixmap.size(); }
+QSize ImageView::sizeHint() const { return _image.size(); }
 
 } // namespace ImageStitch
\ No newline at end of file
@@ -5,8 +5,12 @@
 #include <QLabel>
 #include <QMouseEvent>
 #include <QPainter>
+#include <QCache>
 #include <QPixmap>
+#include <QThreadPool>
 #include <QWidget>
+#include <atomic>
+#include <vector>
 
 #include "customizeTitleWidget.hpp"
 
@@ -18,6 +22,14 @@ class ImageView : public QWidget {
   const int32_t kMaxImageHeight = ~(1 << 31);
   const int32_t kDefaultWindowWidth = 800;
   const int32_t kDefaultWindowHeight = 600;
+  /**
+   * @brief 金字塔瓦片边长
+   */
+  static constexpr int kTileSize = 256;
+  /**
+   * @brief 瓦片QPixmap缓存上限(KB)
+   */
+  static constexpr int kTileCacheLimit = 64 * 1024;
 
  public:
   ImageView(const QImage &image, QWidget *parent = nullptr);
@@ -27,6 +39,10 @@ class ImageView : public QWidget {
 
   void SetImage(const QImage &image);
   void SetPixmap(const QPixmap &pixmap);
+  /**
+   * @brief 替换显示的图像，尺寸不变时保留当前缩放和偏移，用于逐步刷新的预览
+   */
+  void UpdateImage(const QImage &image);
   void ShowMessage(const QString &message);
   void SetOffset(int x, int y);
   void Offset(int x, int y);
@@ -34,8 +50,20 @@ class ImageView : public QWidget {
   void Scale(float scale);
   void AutoScale();
   void Menu(const QPoint &pos);
-  inline const QPixmap &GetPixmap() const { return _pixmap; }
-  inline QPixmap GetPixmap() { return _pixmap; }
+  inline const QImage &GetImage() const { return _image; }
+  inline QPixmap GetPixmap() const { return QPixmap::fromImage(_image); }
+  /**
+   * @brief 当前缩放下应使用的已生成层级，层级越高分辨率越低
+   */
+  int pyramidLevel() const;
+  /**
+   * @brief 已生成的金字塔层数，后台生成完成前只有原图一层
+   */
+  inline int pyramidLevelCount() const { return (int)_levels.size(); }
+  /**
+   * @brief 第level层第(x, y)块瓦片，边缘的瓦片按层的边界裁剪
+   */
+  QPixmap tile(int level, int x, int y);
 
  protected:
   // Member Funcitons
@@ -47,9 +75,20 @@ class ImageView : public QWidget {
   void resizeEvent(QResizeEvent *event) override;
   QSize sizeHint() const override;
   void setupUi(int iWidth, int iHeight);
+  /**
+   * @brief 在后台逐级生成2的幂次缩小的金字塔层，每完成一层刷新一次
+   */
+  void buildPyramid();
+  void levelBuilt(int generation, int level, const QImage &image);
 
  private:
-  QPixmap _pixmap;
+  // 原图只保存为QImage，绘制时按层级切成瓦片转换为QPixmap，
+  // 避免超大全景图超出QPixmap尺寸限制
+  QImage _image;
+  std::vector<QImage> _levels;
+  QCache<quint64, QPixmap> _tiles;
+  std::atomic<int> _pyramid_generation{0};
+  QThreadPool _pyramid_pool;
   QLabel *_textLabel;
   int _iXOffset, _iYOffset;
   float _iScale;
@@ -1,9 +1,15 @@
 #include <glog/logging.h>
 #include <gtest/gtest.h>
 
+#include <QCoreApplication>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
 #include <QGraphicsPixmapItem>
 #include <QGraphicsScene>
 #include <QGraphicsView>
+#include <QIcon>
+#include <QSet>
 
 #include "../imageBox.hpp"
 
@@ -36,4 +42,46 @@ TEST(ImageBoxTest, BoxViewTest) {
   widget->setAttribute(Qt::WA_DeleteOnClose, true);
   widget->show();
 }
+
+TEST(ImageBoxTest, ThumbnailNotifiesLoadedRows) {
+  QStringList files;
+  for (int i = 0; i < 2; ++i) {
+    QImage image(400, 300, QImage::Format_RGB32);
+    image.fill(i == 0 ? Qt::red : Qt::blue);
+    files.append(QDir::temp().filePath(
+        QString("imageBoxTest%1.png").arg(i)));
+    ASSERT_TRUE(image.save(files.back()));
+  }
+  ImageItemModel model;
+  // 第0行和第2行是同一个文件，第1行的缩略图没有被请求过
+  model.addItems({files[0], files[1], files[0]});
+  QSet<int> changed_rows;
+  QObject::connect(
+      &model, &QAbstractItemModel::dataChanged,
+      [&changed_rows](const QModelIndex& top_left,
+                      const QModelIndex& bottom_right,
+                      const QVector<int>& roles) {
+        EXPECT_TRUE(roles.contains(Qt::DecorationRole));
+        for (int row = top_left.row(); row <= bottom_right.row(); ++row) {
+          changed_rows.insert(row);
+        }
+      });
+  // 首次取缩略图时还没有加载完成，由后台线程生成后再通知
+  EXPECT_FALSE(model.data(model.index(0, 0), Qt::DecorationRole).isValid());
+  QElapsedTimer timer;
+  timer.start();
+  while (changed_rows.isEmpty() && timer.elapsed() < 5000) {
+    QCoreApplication::processEvents(QEventLoop::AllEvents, 10);
+  }
+  EXPECT_EQ(changed_rows, QSet<int>({0, 2}));
+  auto icon = model.data(model.index(0, 0), Qt::DecorationRole);
+  ASSERT_TRUE(icon.canConvert<QIcon>());
+  const auto sizes = icon.value<QIcon>().availableSizes();
+  ASSERT_FALSE(sizes.isEmpty());
+  EXPECT_LE(sizes.front().width(), ImageItemModel::kThumbnailWidth);
+  EXPECT_LE(sizes.front().height(), ImageItemModel::kThumbnailHeight);
+  for (const auto& file : files) {
+    QFile::remove(file);
+  }
+}
 }  // namespace Test
\ No newline at end of file
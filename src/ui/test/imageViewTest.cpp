@@ -1,6 +1,9 @@
 #include <glog/logging.h>
 #include <gtest/gtest.h>
 
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QThread>
 #include <string>
 
 #include "../imageView.hpp"
@@ -21,4 +24,52 @@ TEST(ImageViewTest, ViewWindowTest) {
   }
 }
 
+TEST(ImageViewTest, LargeImageTest) {
+  // 边长超过瓦片尺寸的图像按瓦片金字塔绘制，
+  // 1000x600逐级缩小为500x300、250x150
+  const int kTile = ImageView::kTileSize;
+  QImage img(1000, 600, QImage::Format_RGB888);
+  for (int y = 0; y < img.height(); ++y) {
+    uchar *line = img.scanLine(y);
+    for (int x = 0; x < img.width(); ++x) {
+      line[x * 3] = x % 256;
+      line[x * 3 + 1] = y % 256;
+      line[x * 3 + 2] = (x / kTile + y / kTile) % 2 * 255;
+    }
+  }
+  ImageView view(img);
+  EXPECT_EQ(view.GetImage().size(), img.size());
+  // 金字塔在后台生成，逐层投递回界面线程
+  QElapsedTimer timer;
+  timer.start();
+  while (view.pyramidLevelCount() < 3 && timer.elapsed() < 5000) {
+    QCoreApplication::processEvents();
+    QThread::msleep(1);
+  }
+  ASSERT_EQ(view.pyramidLevelCount(), 3);
+
+  // 选择分辨率不低于显示分辨率的最粗层
+  view.SetScale(1.5);
+  EXPECT_EQ(view.pyramidLevel(), 0);
+  view.SetScale(0.6);
+  EXPECT_EQ(view.pyramidLevel(), 0);
+  view.SetScale(0.3);
+  EXPECT_EQ(view.pyramidLevel(), 1);
+  view.SetScale(0.2);
+  EXPECT_EQ(view.pyramidLevel(), 2);
+  view.SetScale(0.01);
+  EXPECT_EQ(view.pyramidLevel(), 2);
+
+  // 内部瓦片是完整的，边缘瓦片按层的边界裁剪
+  EXPECT_EQ(view.tile(0, 1, 1).size(), QSize(kTile, kTile));
+  EXPECT_EQ(view.tile(0, 3, 2).size(),
+            QSize(1000 - 3 * kTile, 600 - 2 * kTile));
+  EXPECT_EQ(view.tile(1, 1, 1).size(), QSize(500 - kTile, 300 - kTile));
+  EXPECT_EQ(view.tile(2, 0, 0).size(), QSize(250, 150));
+  // 瓦片的像素来自原图对应的位置
+  QImage tile = view.tile(0, 3, 2).toImage();
+  EXPECT_EQ(tile.pixel(0, 0), img.pixel(3 * kTile, 2 * kTile));
+  EXPECT_EQ(tile.pixel(10, 20), img.pixel(3 * kTile + 10, 2 * kTile + 20));
+}
+
 }  // namespace Test
\ No newline at end of file